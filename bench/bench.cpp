@@ -0,0 +1,206 @@
+/*
+ * bench: compiler throughput benchmarks.
+ *
+ *   bench [--lcc <path>] [--reps <n>] [--scale <f>] [--seed <n>]
+ *
+ * For every generated case (see lc_gen.hpp) this reports the best
+ * of --reps runs of:
+ *
+ *   lex    Tokenizer::tokenize()               tokens/s, MB/s
+ *   parse  Parser::parse_program() on tokens   nodes/s
+ *          that were lexed beforehand
+ *   e2e    `lcc <file>` as a child process     wall seconds, peak RSS
+ *
+ * Before timing a case, one `lcc --mc=check` run makes sure the
+ * program is one LC2K can hold and lcc assembles correctly; the
+ * benchmark stops if it is not.
+ *
+ * Output is one tab-separated record per line,
+ *
+ *   case <TAB> metric <TAB> value <TAB> unit
+ *
+ * in a fixed order, so results of two commits can be diffed.
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "lc_gen.hpp"
+#include "tokenizer.hpp"
+#include "parser.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+struct Case {
+    lc_gen::Shape shape;
+    size_t        size;
+};
+
+/*
+ * Sizes at --scale 1; each takes well under a second to compile.
+ * Lets, chain and nested fold down to a few words. Fns and mixed
+ * keep their code, so they stay at about two thirds of LC2K's
+ * 65536 words (44K and 43K), leaving room for --scale 1.4.
+ */
+static const Case Cases[] = {
+    {lc_gen::Shape::Lets,   200000},
+    {lc_gen::Shape::Chain,  400000},
+    {lc_gen::Shape::Nested, 200000},
+    {lc_gen::Shape::Fns,      2000},
+    {lc_gen::Shape::Mixed,    6000},
+};
+
+/* Replays pre-lexed tokens so parsing can be timed on its own. */
+class VectorTokenSource : public TokenSource {
+public:
+    explicit VectorTokenSource(const std::vector<Token>& tokens)
+        : m_tokens(tokens) {}
+
+    size_t read_tokens(Token* out, size_t max) override {
+        size_t count = std::min(max, this->m_tokens.size() - this->m_pos);
+        std::copy_n(this->m_tokens.begin() + this->m_pos, count, out);
+        this->m_pos += count;
+        return count;
+    }
+
+private:
+    const std::vector<Token>& m_tokens;
+    size_t                    m_pos = 0;
+};
+
+static double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void report(const std::string& name, const char* metric, double value, const char* unit) {
+    std::printf("%s\t%s\t%.10g\t%s\n", name.c_str(), metric, value, unit);
+}
+
+struct ProcessResult {
+    bool   ok;
+    double seconds;
+    long   max_rss_kb;
+};
+
+/* Runs `lcc [option] path` with stdout discarded. */
+static ProcessResult run_lcc(const std::string& lcc, const std::string& path, const char* option = nullptr) {
+    auto start = Clock::now();
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        int null_fd = open("/dev/null", O_WRONLY);
+        dup2(null_fd, STDOUT_FILENO);
+        if (option)
+            execl(lcc.c_str(), lcc.c_str(), option, path.c_str(), (char*)nullptr);
+        else
+            execl(lcc.c_str(), lcc.c_str(), path.c_str(), (char*)nullptr);
+        _exit(127);
+    }
+
+    int status = 0;
+    struct rusage usage {};
+    wait4(pid, &status, 0, &usage);
+
+    return ProcessResult {
+        .ok         = WIFEXITED(status) && WEXITSTATUS(status) == 0,
+        .seconds    = seconds_since(start),
+        .max_rss_kb = usage.ru_maxrss,
+    };
+}
+
+int main(int argc, char **argv) {
+    std::string lcc   = "./build/lcc";
+    int         reps  = 5;
+    double      scale = 1.0;
+    uint64_t    seed  = 1;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+
+        if      (arg == "--lcc")   lcc   = argv[i + 1];
+        else if (arg == "--reps")  reps  = std::atoi(argv[i + 1]);
+        else if (arg == "--scale") scale = std::atof(argv[i + 1]);
+        else if (arg == "--seed")  seed  = std::strtoull(argv[i + 1], nullptr, 10);
+        else {
+            std::cerr << "bench: unknown option " << arg << "\n";
+            return 1;
+        }
+    }
+
+    std::printf("case\tmetric\tvalue\tunit\n");
+
+    for (const Case& c : Cases) {
+        size_t size = static_cast<size_t>(c.size * scale);
+        std::string name = std::string(lc_gen::ShapeNames[static_cast<int>(c.shape)]) +
+                           "-" + std::to_string(size);
+
+        std::string src = lc_gen::Generator(seed).generate(c.shape, size);
+        double mb = src.size() / (1024.0 * 1024.0);
+
+        /* Lexing */
+        double lex_best = 1e30;
+        std::vector<Token> tokens;
+        for (int r = 0; r < reps; r++) {
+            auto start = Clock::now();
+            tokens = Tokenizer(src).tokenize();
+            lex_best = std::min(lex_best, seconds_since(start));
+        }
+
+        /* Parsing */
+        double parse_best = 1e30;
+        size_t nodes = 0;
+        for (int r = 0; r < reps; r++) {
+            VectorTokenSource source(tokens);
+            Parser parser(source);
+
+            auto start = Clock::now();
+            auto program = parser.parse_program();
+            parse_best = std::min(parse_best, seconds_since(start));
+
+            nodes = program->arena.object_count() + 1;   // + the ProgramNode
+        }
+
+        /* End to end */
+        std::string path = "/tmp/lcc-bench-" + std::to_string(getpid()) + ".lc";
+        std::ofstream(path, std::ios::binary) << src;
+
+        if (!run_lcc(lcc, path, "--mc=check").ok) {
+            std::cerr << "bench: " << lcc << " --mc=check failed on " << name << "\n";
+            std::remove(path.c_str());
+            return 1;
+        }
+
+        double e2e_best = 1e30;
+        long   rss_best = 0;
+        for (int r = 0; r < reps; r++) {
+            auto result = run_lcc(lcc, path);
+            if (!result.ok) {
+                std::cerr << "bench: " << lcc << " failed on " << name << "\n";
+                std::remove(path.c_str());
+                return 1;
+            }
+            e2e_best = std::min(e2e_best, result.seconds);
+            rss_best = rss_best ? std::min(rss_best, result.max_rss_kb) : result.max_rss_kb;
+        }
+        std::remove(path.c_str());
+
+        report(name, "input.bytes",          src.size(),              "B");
+        report(name, "lex.tokens",           tokens.size(),           "tokens");
+        report(name, "lex.tokens_per_sec",   tokens.size() / lex_best, "tokens/s");
+        report(name, "lex.mb_per_sec",       mb / lex_best,           "MB/s");
+        report(name, "parse.nodes",          nodes,                   "nodes");
+        report(name, "parse.nodes_per_sec",  nodes / parse_best,      "nodes/s");
+        report(name, "e2e.seconds",          e2e_best,                "s");
+        report(name, "e2e.peak_rss",         rss_best,                "KB");
+        std::fflush(stdout);
+    }
+}
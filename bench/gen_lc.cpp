@@ -0,0 +1,26 @@
+/*
+ * gen_lc: writes a synthetic LC program to stdout.
+ *
+ *   gen_lc <shape> <size> [seed]
+ *
+ * Shapes are listed in lc_gen.hpp.
+ */
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "lc_gen.hpp"
+
+int main(int argc, char **argv) {
+    lc_gen::Shape shape;
+
+    if (argc < 3 || !lc_gen::parse_shape(argv[1], shape)) {
+        std::cerr << "usage: gen_lc <lets|chain|nested|fns|mixed> <size> [seed]\n";
+        return 1;
+    }
+
+    size_t   size = std::strtoull(argv[2], nullptr, 10);
+    uint64_t seed = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1;
+
+    std::cout << lc_gen::Generator(seed).generate(shape, size);
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/*
+ * Synthetic LC program generator for the benchmarks.
+ *
+ * Every shape produces a valid program (no redeclarations, only
+ * declared names are read) and is fully determined by
+ * (shape, size, seed), so results are comparable between commits.
+ *
+ *  - lets:   `size` let declarations reading earlier variables
+ *  - chain:  long +/- chains, `size` terms in total
+ *  - nested: deeply parenthesised expressions, `size` levels in total
+ *  - fns:    `size` function declarations, each called once
+ *  - mixed:  a quarter of each of the above
+ */
+namespace lc_gen {
+
+enum class Shape { Lets, Chain, Nested, Fns, Mixed };
+
+inline constexpr std::string_view ShapeNames[] = {"lets", "chain", "nested", "fns", "mixed"};
+
+inline bool parse_shape(std::string_view name, Shape& out) {
+    for (size_t i = 0; i < std::size(ShapeNames); i++) {
+        if (ShapeNames[i] == name) {
+            out = static_cast<Shape>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+class Generator {
+public:
+    explicit Generator(uint64_t seed) : m_state(seed * 2 + 1) {}
+
+    std::string generate(Shape shape, size_t size) {
+        this->m_out.clear();
+        this->m_vars  = 0;
+        this->m_ready = 0;
+        this->m_funcs = 0;
+
+        this->_emit(shape, size);
+        this->m_out += "exit(v0);\n";
+        return std::move(this->m_out);
+    }
+
+private:
+    static constexpr size_t ChainLength = 64;   // terms per chain statement
+    static constexpr size_t NestDepth   = 48;   // paren levels per statement
+
+    uint64_t    m_state;
+    std::string m_out;
+    size_t      m_vars  = 0;    // v0 .. v{m_vars-1} are declared
+    size_t      m_ready = 0;    // ... and v0 .. v{m_ready-1} may be read
+    size_t      m_funcs = 0;
+
+    uint32_t _next() {
+        /* xorshift64* */
+        this->m_state ^= this->m_state >> 12;
+        this->m_state ^= this->m_state << 25;
+        this->m_state ^= this->m_state >> 27;
+        return static_cast<uint32_t>((this->m_state * 0x2545F4914F6CDD1Dull) >> 32);
+    }
+
+    void _emit(Shape shape, size_t size) {
+        /* v0 always exists, so every shape has something to read. */
+        if (this->m_vars == 0) {
+            this->_let_begin();
+            this->m_out += "1";
+            this->_let_end();
+        }
+
+        switch (shape) {
+            case Shape::Lets:   this->_lets(size);   break;
+            case Shape::Chain:  this->_chain(size);  break;
+            case Shape::Nested: this->_nested(size); break;
+            case Shape::Fns:    this->_fns(size);    break;
+            case Shape::Mixed:
+                this->_lets  (size / 4);
+                this->_chain (size / 4);
+                this->_nested(size / 4);
+                this->_fns   (size / 4);
+                break;
+        }
+    }
+
+    /* A random operand: literal or an already declared variable. */
+    void _operand() {
+        if (this->_next() % 2)
+            this->m_out += std::to_string(this->_next() % 1000);
+        else
+            this->_var(this->_next() % this->m_ready);
+    }
+
+    void _var(size_t i) {
+        this->m_out += 'v';
+        this->m_out += std::to_string(i);
+    }
+
+    void _op() {
+        this->m_out += this->_next() % 2 ? " + " : " - ";
+    }
+
+    void _let_begin() {
+        this->m_out += "let ";
+        this->_var(this->m_vars++);
+        this->m_out += " : int = ";
+    }
+
+    /* The new variable becomes readable only after its own declaration. */
+    void _let_end() {
+        this->m_out += ";\n";
+        this->m_ready = this->m_vars;
+    }
+
+    void _lets(size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            size_t terms = 1 + this->_next() % 3;
+            this->_let_begin();
+            this->_operand();
+            for (size_t t = 1; t < terms; t++) {
+                this->_op();
+                this->_operand();
+            }
+            this->_let_end();
+        }
+    }
+
+    void _chain(size_t terms) {
+        while (terms > 0) {
+            size_t length = terms < ChainLength ? terms : ChainLength;
+            terms -= length;
+
+            this->_let_begin();
+            this->_operand();
+            for (size_t t = 1; t < length; t++) {
+                this->_op();
+                this->_operand();
+            }
+            this->_let_end();
+        }
+    }
+
+    void _nested(size_t levels) {
+        while (levels > 0) {
+            size_t depth = levels < NestDepth ? levels : NestDepth;
+            levels -= depth;
+
+            this->_let_begin();
+            this->m_out.append(depth, '(');
+            this->_operand();
+            for (size_t d = 0; d < depth; d++) {
+                this->_op();
+                this->_operand();
+                this->m_out += ')';
+            }
+            this->_let_end();
+        }
+    }
+
+    void _fns(size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            size_t f = this->m_funcs++;
+
+            this->m_out += "fn int f" + std::to_string(f) + "(a : int, b : int) {\n";
+            this->m_out += "    let t : int = a + b - ";
+            this->_var(this->_next() % this->m_ready);
+            this->m_out += ";\n    ";
+            this->_var(this->_next() % this->m_ready);
+            this->m_out += " = t - (a - b);\n}\n";
+
+            this->m_out += "f" + std::to_string(f) + "(";
+            this->_operand();
+            this->m_out += ", ";
+            this->_operand();
+            this->m_out += ");\n";
+        }
+    }
+};
+
+} // namespace lc_gen
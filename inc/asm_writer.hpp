@@ -0,0 +1,40 @@
+#pragma once
+
+#include <ostream>
+
+#include "mir.hpp"
+
+/*
+ * Writes an allocated MProgram as LC2K assembly:
+ *
+ *   label <TAB> opcode <TAB> field0 <TAB> field1 <TAB> field2 <TAB> comment
+ *
+ * in the order Layout gives addresses: a jump over the `.fill`
+ * words, the words, then the code (the top-level code, then each
+ * function). Pseudo-instructions are expanded here. Loads and
+ * stores of named words carry the source name as a comment.
+ *
+ * write() throws std::runtime_error, before writing anything, for
+ * a program Assembler would reject too (see Layout).
+ */
+class AsmWriter {
+public:
+    AsmWriter(std::ostream& os, const MProgram& program)
+        : m_os(os), m_program(program) {}
+
+    void write();
+
+    /* Number of words (instructions and .fill) written. */
+    size_t words() const { return this->m_words; }
+
+private:
+    std::ostream&   m_os;
+    const MProgram& m_program;
+    size_t          m_words = 0;
+
+    void _instruction(LabelId label, const MInstr& in);
+    void _data       (const DataWord& word);
+    void _label      (LabelId label);       // label column, empty for NoLabel
+    void _label_name (LabelId label);
+    void _comment    (LabelId label);
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+#include "layout.hpp"
+#include "mir.hpp"
+#include "source_map.hpp"
+
+/*
+ * Assembles an allocated MProgram into an LC2K memory image, laid
+ * out by Layout exactly as AsmWriter writes it.
+ *
+ * Instructions are encoded as in the EECS370 machine-code format
+ * (opcode in bits 24..22, regA 21..19, regB 18..16, then destReg
+ * in bits 2..0 or a 16-bit offset). A symbolic lw/sw offset is the
+ * label's address; a symbolic beq offset is relative to the next
+ * instruction, as an assembler would resolve it.
+ *
+ * Alongside the image it records a SourceMap from the MInstr
+ * locations, for profiling.
+ */
+class Assembler {
+public:
+    explicit Assembler(const MProgram& program)
+        : m_program(program) {}
+
+    /* One word per address; throws std::runtime_error if anything does not fit. */
+    std::vector<int32_t> assemble();
+
+    /* Address of a label, after assemble(). */
+    uint32_t address(LabelId label) const { return this->m_layout->address(label); }
+
+    /* Source of each code address, after assemble(). */
+    const SourceMap& source_map() const { return this->m_map; }
+
+private:
+    const MProgram&       m_program;
+    std::optional<Layout> m_layout;
+    SourceMap             m_map;
+
+    int32_t  _encode   (const MInstr& in, uint32_t pc) const;
+    int32_t  _data     (const DataWord& word) const;
+};
+
+/* An image as an LC2K machine-code file (.mc): one signed decimal word per line. */
+void write_machine_code(std::ostream& os, const std::vector<int32_t>& image);
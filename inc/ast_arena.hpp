@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+ * Fixed-size view of objects stored in an AstArena.
+ * Used for node child lists instead of std::vector.
+ */
+template <typename T>
+struct ArenaSpan {
+    T*       m_data = nullptr;
+    uint32_t m_size = 0;
+
+    T*       begin()       { return this->m_data; }
+    T*       end()         { return this->m_data + this->m_size; }
+    const T* begin() const { return this->m_data; }
+    const T* end()   const { return this->m_data + this->m_size; }
+
+    size_t size()  const { return this->m_size; }
+    bool   empty() const { return this->m_size == 0; }
+
+    T&       operator[](size_t i)       { return this->m_data[i]; }
+    const T& operator[](size_t i) const { return this->m_data[i]; }
+};
+
+/*
+ * Bump allocator owning every node and string of one ProgramNode.
+ *
+ * Memory is carved out of a few large blocks (each twice the size
+ * of the last, up to MaxBlock) and freed all at once when the
+ * arena is destroyed. Destructors of arena objects never run, so
+ * make() only accepts trivially destructible types.
+ */
+class AstArena {
+public:
+    static constexpr size_t InitialBlock = 16 * 1024;
+    static constexpr size_t MaxBlock     = 1024 * 1024;
+
+    AstArena() = default;
+    ~AstArena();
+
+    AstArena(const AstArena&)            = delete;
+    AstArena& operator=(const AstArena&) = delete;
+
+    void* allocate(size_t size, size_t align);
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        static_assert(std::is_trivially_destructible_v<T>,
+                      "AstArena never runs destructors");
+        this->m_objects++;
+        return new (this->allocate(sizeof(T), alignof(T)))
+            T(std::forward<Args>(args)...);
+    }
+
+    /* Frees every block; nothing made in the arena so far may be used again. */
+    void release();
+
+    /* Copies str into the arena; the view lives as long as the arena. */
+    std::string_view copy_string(std::string_view str);
+
+    /* Copies items[from, end) into the arena. */
+    template <typename T>
+    ArenaSpan<T> copy_span(const std::vector<T>& items, size_t from = 0) {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        ArenaSpan<T> span;
+        span.m_size = static_cast<uint32_t>(items.size() - from);
+        if (span.m_size == 0)
+            return span;
+
+        span.m_data = static_cast<T*>(
+            this->allocate(sizeof(T) * span.m_size, alignof(T)));
+        std::memcpy(span.m_data, items.data() + from, sizeof(T) * span.m_size);
+        return span;
+    }
+
+    size_t block_count()  const { return this->m_blocks; }
+    size_t bytes_used()   const { return this->m_used; }
+    size_t object_count() const { return this->m_objects; }
+
+private:
+    struct Block {
+        Block* prev;
+    };
+
+    Block* m_head = nullptr;
+    char*  m_cur  = nullptr;
+    char*  m_end  = nullptr;
+
+    size_t m_next_block = InitialBlock;
+    size_t m_blocks     = 0;
+    size_t m_used       = 0;
+    size_t m_objects    = 0;
+
+    void _grow(size_t min_size);
+};
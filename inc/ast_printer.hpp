@@ -0,0 +1,71 @@
+#pragma once
+
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include "parser_nodes.hpp"
+
+/*
+ * Writes an AST straight to an output stream, with no
+ * intermediate strings.
+ *
+ *  - Text:  LC-like source, one statement per line (the default).
+ *  - SExpr: (VarDecl :name "x" :type "int" :value (IntLiteral :value 5))
+ *  - Json:  {"kind":"VarDecl","name":"x","type":"int","value":{...}}
+ *
+ * SExpr and Json are single-line and meant for tools; every node
+ * carries its kind and named fields, child lists are lists/arrays.
+ *
+ * Long +/- chains are printed without recursion; only parentheses
+ * and call arguments nest calls, as deep as the parser allows.
+ */
+class AstPrinter {
+public:
+    enum class Format { Text, SExpr, Json };
+
+    explicit AstPrinter(std::ostream& os, Format format = Format::Text)
+        : m_os(os), m_format(format) {}
+
+    void print(const ASTNode& node);
+
+    /* Per-node printers, dispatched by visit(). */
+    void operator()(const ProgramNode&);
+    void operator()(const FunctionDeclNode&);
+    void operator()(const FunctionCallNode&);
+    void operator()(const VarDeclNode&);
+    void operator()(const AssignmentNode&);
+    void operator()(const ExitNode&);
+    void operator()(const ExprStmtNode&);
+    void operator()(const BinaryExprNode&);
+    void operator()(const IdentNode&);
+    void operator()(const IntLiteralNode&);
+
+private:
+    std::ostream& m_os;
+    Format        m_format;
+    int           m_indent = 0;     // Text only, in levels of 2 spaces
+
+    /* Operators of the chains being printed, outermost first; nested chains push above. */
+    std::vector<const BinaryExprNode*> m_spine;
+
+    bool _text() const { return this->m_format == Format::Text; }
+
+    /* Text helpers */
+    void _indent();
+    void _expr(const ASTNode* node);     // "<null>" for missing children
+
+    /* Structured (SExpr / Json) helpers */
+    void _begin (const char* kind);
+    void _key   (const char* key);
+    void _end   ();
+    void _string(std::string_view str);
+    void _node  (const ASTNode* node);   // null for missing children
+    void _list  (const NodeList& nodes);
+};
+
+/* Text form of node. */
+inline std::ostream& operator<<(std::ostream& os, const ASTNode& node) {
+    AstPrinter(os).print(node);
+    return os;
+}
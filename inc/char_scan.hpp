@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/*
+ * Run scanners for the Tokenizer.
+ *
+ * Each skip_* returns a pointer to the first byte in [p, end)
+ * that is NOT part of the run (or end). The SIMD paths test
+ * 32 (AVX2) or 16 (SSE2) bytes per step and only load whole
+ * vectors that lie inside the buffer; the remainder, and
+ * targets without SSE2, use a 256-entry class table.
+ *
+ * Character classes match the scalar Tokenizer helpers:
+ *  - whitespace: ' ', '\t', '\n', '\v', '\f', '\r' (std::isspace, "C" locale)
+ *  - digit:      '0'..'9'
+ *  - ident:      'A'..'Z', 'a'..'z', '0'..'9', '_'
+ */
+namespace char_scan {
+
+enum CharClass : uint8_t {
+    Space = 1 << 0,
+    Digit = 1 << 1,
+    Alpha = 1 << 2,   // letters and '_'
+    Ident = Digit | Alpha,
+};
+
+constexpr std::array<uint8_t, 256> _build_class_table() {
+    std::array<uint8_t, 256> table {};
+    for (int c = 0; c < 256; c++) {
+        if (c == ' ' || ('\t' <= c && c <= '\r'))       table[c] |= Space;
+        if ('0' <= c && c <= '9')                       table[c] |= Digit;
+        if (('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || c == '_')
+                                                        table[c] |= Alpha;
+    }
+    return table;
+}
+
+inline constexpr auto ClassTable = _build_class_table();
+
+inline bool is_class(char c, uint8_t cls) {
+    return ClassTable[static_cast<unsigned char>(c)] & cls;
+}
+
+inline const char* _skip_scalar(const char* p, const char* end, uint8_t cls) {
+    while (p < end && is_class(*p, cls))
+        p++;
+    return p;
+}
+
+#if defined(__AVX2__)
+
+using Vec = __m256i;
+inline constexpr int VecWidth = 32;
+
+inline Vec      _load (const char* p)      { return _mm256_loadu_si256(reinterpret_cast<const Vec*>(p)); }
+inline Vec      _splat(char c)             { return _mm256_set1_epi8(c); }
+inline Vec      _or   (Vec a, Vec b)       { return _mm256_or_si256(a, b); }
+inline Vec      _eq   (Vec a, Vec b)       { return _mm256_cmpeq_epi8(a, b); }
+inline Vec      _sub  (Vec a, Vec b)       { return _mm256_sub_epi8(a, b); }
+inline Vec      _min  (Vec a, Vec b)       { return _mm256_min_epu8(a, b); }
+inline uint32_t _mask (Vec v)              { return static_cast<uint32_t>(_mm256_movemask_epi8(v)); }
+
+#elif defined(__SSE2__)
+
+using Vec = __m128i;
+inline constexpr int VecWidth = 16;
+
+inline Vec      _load (const char* p)      { return _mm_loadu_si128(reinterpret_cast<const Vec*>(p)); }
+inline Vec      _splat(char c)             { return _mm_set1_epi8(c); }
+inline Vec      _or   (Vec a, Vec b)       { return _mm_or_si128(a, b); }
+inline Vec      _eq   (Vec a, Vec b)       { return _mm_cmpeq_epi8(a, b); }
+inline Vec      _sub  (Vec a, Vec b)       { return _mm_sub_epi8(a, b); }
+inline Vec      _min  (Vec a, Vec b)       { return _mm_min_epu8(a, b); }
+inline uint32_t _mask (Vec v)              { return static_cast<uint32_t>(_mm_movemask_epi8(v)); }
+
+#endif
+
+#if defined(__AVX2__) || defined(__SSE2__)
+
+inline constexpr uint32_t FullMask =
+    VecWidth == 32 ? 0xFFFFFFFFu : (1u << VecWidth) - 1;
+
+/* Bytes in [lo, lo + span] (unsigned compare via saturating min). */
+inline Vec _in_range(Vec v, char lo, char span) {
+    Vec t = _sub(v, _splat(lo));
+    return _eq(_min(t, _splat(span)), t);
+}
+
+inline Vec _space_lanes(Vec v) {
+    return _or(_eq(v, _splat(' ')), _in_range(v, '\t', '\r' - '\t'));
+}
+
+inline Vec _digit_lanes(Vec v) {
+    return _in_range(v, '0', 9);
+}
+
+inline Vec _ident_lanes(Vec v) {
+    /* Folding case with | 0x20 keeps '@', '[' etc. out of 'a'..'z'. */
+    Vec letter = _in_range(_or(v, _splat(0x20)), 'a', 'z' - 'a');
+    return _or(_or(letter, _digit_lanes(v)), _eq(v, _splat('_')));
+}
+
+template <typename Lanes>
+inline const char* _skip_vec(const char* p, const char* end, uint8_t cls, Lanes lanes) {
+    while (end - p >= VecWidth) {
+        uint32_t hit = _mask(lanes(_load(p)));
+        if (hit != FullMask)
+            return p + __builtin_ctz(~hit & FullMask);
+        p += VecWidth;
+    }
+    return _skip_scalar(p, end, cls);
+}
+
+inline const char* skip_whitespace(const char* p, const char* end) {
+    return _skip_vec(p, end, Space, _space_lanes);
+}
+
+inline const char* skip_digits(const char* p, const char* end) {
+    return _skip_vec(p, end, Digit, _digit_lanes);
+}
+
+inline const char* skip_ident(const char* p, const char* end) {
+    return _skip_vec(p, end, Ident, _ident_lanes);
+}
+
+#else
+
+inline const char* skip_whitespace(const char* p, const char* end) { return _skip_scalar(p, end, Space); }
+inline const char* skip_digits    (const char* p, const char* end) { return _skip_scalar(p, end, Digit); }
+inline const char* skip_ident     (const char* p, const char* end) { return _skip_scalar(p, end, Ident); }
+
+#endif
+
+} // namespace char_scan
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "ir.hpp"
+#include "lowering.hpp"
+#include "mir.hpp"
+#include "thread_pool.hpp"
+
+/*
+ * Lowers IR (see ir.hpp) to machine IR over virtual registers
+ * (see mir.hpp); LinearScan then assigns physical registers.
+ *
+ * Storage model:
+ *  - Globals that some function reads or writes get a memory
+ *    word; their loads and stores become lw / sw.
+ *  - Every other variable lives in virtual registers: a store
+ *    just makes the stored value the variable's register.
+ *  - Parameters get a word per function that the caller stores
+ *    the argument into; the callee loads it on first use.
+ *
+ * The IR passes are what make this cheap: after them a global
+ * is only stored where a call or a caller may read it, and only
+ * reloaded after a call that may have changed it.
+ *
+ * LC has no conditionals, so a call that re-enters a function
+ * already on the call stack can never return. Every function
+ * therefore has a single static frame, and no stack is needed.
+ *
+ * Calling convention: the caller stores the arguments, then
+ * `jalr` links into r7. Every register is caller-saved; callees
+ * return with `jalr 7 6`. exit(value) halts with value in r1.
+ *
+ * An external function gets labels for its entry and parameter
+ * words like any other, but no code and no data: they are left
+ * undefined for the linker to bind to another object's.
+ *
+ * Labels for functions, parameters and shared globals are made
+ * first; then each function is lowered on its own, on pool if
+ * one is given. The constant words a function needs get
+ * provisional labels (see MFunction::relabel) and are shared with
+ * earlier functions' afterwards, walking functions in order, so
+ * labels and data come out as they would from a serial run.
+ */
+class CodeGen {
+public:
+    explicit CodeGen(const IrProgram& program, ThreadPool* pool = nullptr)
+        : m_program(program), m_pool(pool) {}
+
+    MProgram generate();
+
+private:
+    struct Function {
+        LabelId              entry;
+        LabelId              address;           // constant holding entry
+        std::vector<LabelId> params;
+    };
+
+    /* Lowers one function; any number run at once, each on its own MFunction. */
+    class Lowering {
+    public:
+        Lowering(const CodeGen& gen, uint32_t index, MFunction& fn);
+
+        /* Returns the constant words used, by provisional label (from CodeGen::m_first_local). */
+        std::vector<int32_t> run();
+
+    private:
+        const CodeGen&    m_gen;
+        const IrFunction& m_ir;
+        uint32_t          m_index;
+        MFunction&        m_fn;
+        SourceLoc         m_loc = NoLoc;        // of the IR instruction being lowered
+        std::vector<Reg>  m_values;             // per Value
+        std::vector<int32_t>                 m_words;
+        std::unordered_map<VarId,   Reg>     m_var_regs;
+        std::unordered_map<int32_t, Reg>     m_constant_regs;
+        std::unordered_map<int32_t, LabelId> m_word_labels;
+
+        void _instruction(const IrInstr& in);
+        Reg  _load       (VarId var);
+        void _store      (VarId var, Reg value);
+        void _call       (const IrInstr& in);
+
+        /* Emission helpers */
+        Reg     _constant     (int32_t value);
+        LabelId _constant_word(int32_t value);
+        Reg     _lowered      (lowering::Op op, Reg a, Reg b);     // into a new vreg, from the lowering table
+        void    _emit         (MInstr instr) { instr.loc = this->m_loc; this->m_fn.code.push_back(instr); }
+    };
+
+    const IrProgram&      m_program;
+    ThreadPool*           m_pool;
+    MProgram              m_out;
+    std::vector<Function> m_functions;          // per IR function; [0] has no labels
+    std::vector<LabelId>  m_slots;              // per VarId: G or P word, or NoLabel
+    LabelId               m_first_local = 0;    // first provisional label
+
+    std::unordered_map<int32_t, LabelId> m_constants;
+
+    void _declare_functions();
+    void _assign_slots     ();                  // globals some function touches
+    void _merge_constants  (MFunction& fn, const std::vector<int32_t>& words);
+};
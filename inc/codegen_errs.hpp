@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <array>
+#include <stdexcept>
+
+enum class CodegenErrorType {
+    UndeclaredIdentifier,
+    UndeclaredFunction,
+    NotAVariable,
+    NotAFunction,
+    ArgumentCount,
+    COUNT
+};
+
+inline const std::array<const char*, static_cast<size_t>(CodegenErrorType::COUNT)>
+CodegenErrorStrings {{
+    "Undeclared identifier",
+    "Undeclared function",
+    "Not a variable",
+    "Not a function",
+    "Wrong number of arguments to"
+}};
+
+inline std::string to_string(CodegenErrorType type) {
+    auto idx = static_cast<size_t>(type);
+    if (idx >= CodegenErrorStrings.size()) {
+        throw std::out_of_range("Invalid CodegenErrorType");
+    }
+    return CodegenErrorStrings[idx];
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+/*
+ * lcc --server and --client: a long-running lcc that compiles for
+ * other lcc processes over a Unix domain socket, so each command
+ * line skips process startup and finds the interner, thread pools
+ * and result cache already warm (see serve() in lcc.cpp).
+ *
+ * A client sends the command line it was given, its working
+ * directory and, when a "-" input asks for it, what it read from
+ * stdin. The server answers with what that command would have
+ * written to stdout and stderr, and its exit status. Requests are
+ * served one at a time; each uses the pool for its own files and
+ * functions.
+ *
+ * Only one user's processes talk: the socket is mode 0600, in a
+ * directory no other user can replace it in, and each end checks
+ * the other's user (SO_PEERCRED) before trusting it.
+ *
+ * Messages are a byte count followed by strings, each a byte count
+ * followed by its bytes. Counts are 64-bit, in host byte order:
+ * both ends are the same machine.
+ */
+struct CompileRequest {
+    std::string                cwd;
+    std::vector<std::string>   args;    // as given to lcc, without --client
+    std::optional<std::string> input;   // stdin, for "-"
+};
+
+struct CompileResponse {
+    int         status = 0;
+    std::string out;                    // stdout
+    std::string err;                    // stderr
+};
+
+class CompileServer {
+public:
+    using Handler = std::function<CompileResponse(const CompileRequest&)>;
+
+    /*
+     * Listens on path, replacing a stale socket and creating its
+     * directory (mode 0700) if needed; throws if another server is
+     * using it or the directory is another user's.
+     */
+    explicit CompileServer(const std::string& path);
+    ~CompileServer();
+
+    CompileServer(const CompileServer&)            = delete;
+    CompileServer& operator=(const CompileServer&) = delete;
+
+    /* Answers requests with handler until SIGINT or SIGTERM. */
+    void serve(const Handler& handler);
+
+    size_t served() const { return this->m_served; }
+
+private:
+    /* Seconds a connected client has to send its request before it is dropped. */
+    static constexpr int ReceiveTimeout = 10;
+
+    std::string m_path;
+    int         m_fd     = -1;
+    size_t      m_served = 0;
+
+    void _answer(int conn, const Handler& handler);
+};
+
+/*
+ * Sends request to the server at path and waits for the answer.
+ * Returns nullopt if no server is listening there; throws if one
+ * is but the exchange fails, or if the socket or the server
+ * belongs to another user.
+ */
+std::optional<CompileResponse> send_compile_request(const std::string& path, const CompileRequest& request);
+
+/* $LCC_SOCKET, else lcc.sock in $XDG_RUNTIME_DIR, else in /tmp/lcc-<uid>/. */
+std::string default_socket_path();
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "parser_nodes.hpp"
+
+/*
+ * Folds constant expressions in place, before code generation.
+ *
+ *  - `==` between constants, and between two reads of the same
+ *    variable, becomes a literal.
+ *  - Each +/- chain, parentheses included, is flattened into
+ *    signed terms. Its literals are summed into one constant
+ *    (dropped if it is 0), and x - x pairs cancel when the chain
+ *    has no calls that could change x in between.
+ *
+ * Non-constant terms keep their order, so calls still happen in
+ * source order; only when the chain has no calls at all is a
+ * positive term moved to the front, to avoid a leading 0 - x.
+ * Chains are rebuilt left-deep from their own nodes, so folding
+ * never grows the arena by more than one literal per chain.
+ *
+ * Chains and the subtrees compared or scanned for calls are walked
+ * with explicit stacks: a chain as long as the source costs no
+ * stack depth. Only parentheses and call arguments nest calls
+ * here, and the parser bounds those (Parser::MaxNesting).
+ */
+class ConstantFolder {
+public:
+    explicit ConstantFolder(ProgramNode& program)
+        : m_program(program) {}
+
+    void run();
+
+    /* Binary operators removed. */
+    size_t removed() const { return this->m_removed; }
+
+private:
+    struct Term {
+        ASTNodePtr node;
+        bool       negative;
+    };
+
+    ProgramNode& m_program;
+    size_t       m_removed = 0;
+
+    /* Scratch for _chain(), shared by nested chains (mark / resize). */
+    std::vector<Term>            m_walk;        // chain nodes still to flatten
+    std::vector<Term>            m_terms;
+    std::vector<BinaryExprNode*> m_ops;
+    std::vector<IntLiteralNode*> m_literals;
+
+    /* Ident terms by name, for x - x; only used once a chain is flattened. */
+    std::vector<std::pair<SymbolId, size_t>> m_plus, m_minus;
+
+    /* Scratch for _pure() and _same(), which never nest. */
+    std::vector<const ASTNode*>                              m_visit;
+    std::vector<std::pair<const ASTNode*, const ASTNode*>>   m_pairs;
+
+    void       _statement(ASTNode& node);
+    ASTNodePtr _expr     (ASTNodePtr node);
+    ASTNodePtr _equality (BinaryExprNode& node);
+    ASTNodePtr _chain    (BinaryExprNode& node);
+    void       _flatten  (BinaryExprNode& root, uint32_t& constant);
+
+    static bool _is_chain(const ASTNode* node);
+    bool        _pure    (const ASTNode* node);                      // no calls
+    bool        _same    (const ASTNode* a, const ASTNode* b);       // same pure value
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "ast_arena.hpp"
+
+/* Small integer handle for an interned identifier. 0 is never a valid id. */
+using SymbolId = uint32_t;
+
+inline constexpr SymbolId NoSymbol = 0;
+
+/*
+ * Maps identifier text to a SymbolId, storing each distinct
+ * spelling exactly once. Two identifiers are the same name iff
+ * their ids are equal, so later passes never compare strings.
+ *
+ * The Tokenizer interns every m_ident it lexes into global().
+ * Spellings live in the interner's own arena and stay valid for
+ * the life of the process.
+ *
+ * intern() may run on any number of threads at once (lcc compiles
+ * several files in parallel). The table is split into shards by
+ * hash, each with its own lock, slots and character storage, so
+ * threads interning different names rarely meet; ids come from one
+ * atomic counter. Entries are kept in fixed pages that never move
+ * and are written before their id is published, so spelling() is
+ * lock-free for any id the caller got from intern() or through a
+ * synchronising hand-off (e.g. the PipelinedTokenizer's ring).
+ *
+ * Ids depend on the order names are first seen, which is not
+ * deterministic across threads: nothing may order output by id.
+ *
+ * intern() throws std::length_error once 2^28 names are in use;
+ * the interner stays usable for names it already has. A process
+ * that outlives its compiles (lcc --server) clear()s it between
+ * them.
+ */
+class Interner {
+public:
+    static Interner& global();
+
+    SymbolId         intern  (std::string_view text);
+    std::string_view spelling(SymbolId id) const;
+
+    size_t size() const { return this->m_count.load(std::memory_order_relaxed) - 1; }
+
+    /*
+     * Forgets every name and frees their storage. Only while no
+     * other thread interns, and nothing still holds an id or a
+     * spelling from before.
+     */
+    void clear();
+
+private:
+    static constexpr size_t PageBits  = 12;
+    static constexpr size_t PageSize  = size_t(1) << PageBits;
+    static constexpr size_t MaxPages  = size_t(1) << 16;
+    static constexpr size_t ShardBits = 6;
+    static constexpr size_t Shards    = size_t(1) << ShardBits;
+
+    struct Entry {
+        std::string_view text;
+        uint32_t         hash;
+    };
+
+    /* Names whose hash has these top bits; its own lock and open-addressing table. */
+    struct alignas(64) Shard {
+        std::mutex            mutex;
+        AstArena              storage;      // character data
+        std::vector<SymbolId> slots;        // NoSymbol = empty
+        size_t                count = 0;
+    };
+
+    Interner();
+    ~Interner();
+
+    std::unique_ptr<std::atomic<Entry*>[]> m_pages;     // id -> entry, MaxPages slots
+    std::atomic<size_t>                    m_count {1}; // next id (0 unused)
+    std::array<Shard, Shards>              m_shards;
+
+    Entry&          _entry(SymbolId id) const;
+    Entry&          _new_entry(SymbolId id);           // allocating its page if need be
+    static uint32_t _hash(std::string_view text);
+    void            _rehash(Shard& shard) const;
+};
+
+/* Spelling of id in the global interner. */
+inline std::string_view spelling(SymbolId id) {
+    return Interner::global().spelling(id);
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "interner.hpp"
+#include "source_map.hpp"
+
+class ThreadPool;
+
+/*
+ * Mid-level IR: the form a program is in between the AST and
+ * lowering to machine IR (codegen.cpp). IrBuilder produces it,
+ * IrOptimizer rewrites it and IrPrinter dumps it.
+ *
+ * Each function is a list of basic blocks of instructions over
+ * SSA values (%0, %1, ...): every value is defined exactly once,
+ * before its uses. Variables ($x) are only touched through
+ * explicit load and store, so the IR says exactly where a
+ * variable is read or written; the passes decide which of those
+ * accesses are needed at all.
+ *
+ * LC has no branches, so a function is its entry block (bb0)
+ * plus, if it contains an exit, one block per stretch of code
+ * following an exit. Those never run; dead code elimination
+ * drops them. Blocks end with exit or ret, except where dead
+ * code elimination cut one short after a call that never
+ * returns.
+ */
+#define LCC_IR_OPS(X)                                                       \
+    X(Const, "const")  /* dest = imm                                     */ \
+    X(Add,   "add")    /* dest = a + b                                   */ \
+    X(Sub,   "sub")    /* dest = a - b                                   */ \
+    X(Eq,    "eq")     /* dest = a == b                                  */ \
+    X(Load,  "load")   /* dest = var                                     */ \
+    X(Store, "store")  /* var = a                                        */ \
+    X(Call,  "call")   /* callee(args...), no result                     */ \
+    X(Exit,  "exit")   /* halt with a                                    */ \
+    X(Ret,   "ret")    /* return to the caller                           */
+
+#define LCC_IR_OP_ENUM(name, str) name,
+
+enum class IrOp : uint8_t {
+    LCC_IR_OPS(LCC_IR_OP_ENUM)
+};
+
+#undef LCC_IR_OP_ENUM
+
+#define LCC_IR_OP_STRING(name, str) case IrOp::name: return str;
+
+inline const char* to_string(IrOp op) {
+    switch (op) {
+        LCC_IR_OPS(LCC_IR_OP_STRING)
+    }
+    return "?";
+}
+
+#undef LCC_IR_OP_STRING
+
+using Value = uint32_t;
+using VarId = uint32_t;
+
+inline constexpr Value NoValue = UINT32_MAX;
+
+struct IrInstr {
+    IrOp     op;
+    Value    dest   = NoValue;
+    Value    a      = NoValue;
+    Value    b      = NoValue;
+    int32_t  imm    = 0;            // Const
+    VarId    var    = 0;            // Load, Store
+    uint32_t callee = 0;            // Call: index into IrProgram::functions
+    uint32_t args_begin = 0;        // Call: arguments are IrFunction::args[begin, begin + count)
+    uint32_t args_count = 0;
+    SourceLoc loc  = NoLoc;         // statement it came from
+
+    /* Nothing but dest depends on it; unused results can go. */
+    bool pure() const {
+        return this->op == IrOp::Const || this->op == IrOp::Add || this->op == IrOp::Sub ||
+               this->op == IrOp::Eq    || this->op == IrOp::Load;
+    }
+
+    bool terminator() const { return this->op == IrOp::Exit || this->op == IrOp::Ret; }
+};
+
+struct IrBlock {
+    std::vector<IrInstr> code;
+};
+
+struct IrVar {
+    enum Kind : uint8_t { Global, Param, Local } kind;
+    SymbolId name;
+};
+
+struct IrFunction {
+    SymbolId             name = NoSymbol;   // NoSymbol for the top-level code
+    std::vector<VarId>   params;
+    std::vector<IrBlock> blocks;            // blocks[0] is the entry
+    std::vector<Value>   args;              // call arguments, see IrInstr
+    Value                next_value = 0;
+
+    /* Globals read / written by the function or anything it calls, sorted (compute_effects). */
+    std::vector<VarId>   reads;
+    std::vector<VarId>   writes;
+    bool                 returns = false;    // bb0 ends in ret and calls nothing that does not
+
+    /*
+     * Only called here, defined in another file (separate
+     * compilation, see IrBuilder). Its body is a lone ret; calls
+     * to it are assumed to return and to reach every global a
+     * function of this program can.
+     */
+    bool                 external = false;
+
+    Value new_value() { return this->next_value++; }
+};
+
+/*
+ * A whole program. functions[0] is the top-level code, then one
+ * function per FunctionDeclNode in source order, then the
+ * external functions in order of first call. Variables of
+ * every function share one table, so a VarId names a variable
+ * program-wide.
+ */
+struct IrProgram {
+    std::vector<IrVar>      vars;
+    std::vector<IrFunction> functions;
+};
+
+/*
+ * Fills in reads / writes: the globals each function loads and
+ * stores, closed over the call graph, and returns. Code after an
+ * exit counts too; it is harmless, since a function with such
+ * code never returns to its caller anyway.
+ *
+ * A function that returns has therefore done every write in
+ * writes. Calls within a cycle are assumed to return (they never
+ * do: a re-entered function can only exit or recurse forever).
+ * An external function may call back into any function here.
+ *
+ * With pool, each function's own accesses are gathered on it; the
+ * closure over the call graph is serial.
+ */
+void compute_effects(IrProgram& program, ThreadPool* pool = nullptr);
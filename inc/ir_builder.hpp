@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "codegen_errs.hpp"
+#include "ir.hpp"
+#include "parser_nodes.hpp"
+#include "symbol_table.hpp"
+#include "thread_pool.hpp"
+
+/*
+ * Translates a ProgramNode to IR (see ir.hpp), resolving names on
+ * the way. Every read of a variable becomes a load and every
+ * `let` or assignment a store; a call evaluates to 0.
+ *
+ * With reorder set, expressions are evaluated in the order that
+ * keeps the fewest values live (Sethi-Ullman). Each subtree is
+ * labelled with the registers it needs; the operands of a call-free
+ * == are evaluated heavier first, and each +/- chain is flattened
+ * into signed terms that are summed left to right, heaviest first
+ * when the chain has no calls, in source order when it does. Calls
+ * always happen in source order and see the same variables.
+ *
+ * Functions can be called before their declaration; variables
+ * cannot be read before theirs, so a function sees exactly the
+ * globals declared above it.
+ *
+ * The top-level code is translated first, in order, reserving
+ * each function's VarIds (its parameters, then one per `let`) at
+ * its place; globals therefore keep VarIds in source order, and a
+ * function sees the globals numbered below its own. The bodies
+ * are then independent and are translated in parallel when there
+ * is a pool. The IR is the same either way, as is the error
+ * reported: the first in source order.
+ *
+ * With externals set (separate compilation, `lcc -c`), a call to
+ * a function the file does not declare is not an error: it calls
+ * an external function (IrFunction::external), which the linker
+ * finds in another object. Every call must pass it as many
+ * arguments as the first. Externals are declared before any body
+ * is translated, from a scan of each function's calls at its
+ * place.
+ *
+ * Throws std::runtime_error("Codegen error: ...") for undeclared
+ * names and calls with the wrong number of arguments.
+ */
+class IrBuilder {
+public:
+    /* With pool, function bodies are translated on it (see build()). */
+    explicit IrBuilder(const ProgramNode& program, bool reorder = true, bool externals = false,
+                       ThreadPool* pool = nullptr)
+        : m_program(program), m_reorder(reorder), m_externals(externals), m_pool(pool) {}
+
+    IrProgram build();
+
+    /* Expressions evaluated out of source order. */
+    size_t reordered() const { return this->m_reordered; }
+
+private:
+    struct Binding {
+        enum Kind : uint8_t { Variable, Function } kind;
+        uint32_t index;                 // VarId or function index
+    };
+
+    /* Registers a subtree needs (its Ershov number), and whether it is free of calls. */
+    struct Label {
+        uint32_t need;
+        bool     pure;
+    };
+
+    struct Term {
+        const ASTNode* node;
+        bool           negative;
+        Label          label;
+    };
+
+    /*
+     * The walk over one function body, or the top-level code. The
+     * top-level one declares globals; a function's declares its
+     * own variables in the VarIds reserved for it and sees the
+     * globals below them.
+     */
+    class Translator {
+    public:
+        Translator(IrBuilder& builder, uint32_t index, VarId first_var);
+
+        void function (const FunctionDeclNode& node);
+        void statement(const ASTNode& node);
+        void finish   ();               // top-level: running off the end exits with 0
+
+        size_t reordered() const { return this->m_reordered; }
+
+    private:
+        IrBuilder&           m_builder;
+        uint32_t             m_index;       // of the function; the top-level code's may move as externals are added
+        bool                 m_top;         // the top-level code, whose scope is the globals
+        VarId                m_next_var;    // function: the next reserved VarId
+        SymbolTable<Binding> m_locals;
+        SourceLoc            m_loc = NoLoc; // of the statement being translated
+        size_t               m_reordered = 0;
+
+        /* Labels of the statement's binary expressions; chain terms, shared by nested chains (mark / resize). */
+        std::unordered_map<const ASTNode*, Label> m_labels;
+        std::vector<Term>                         m_terms;
+
+        /* Operators _in_order() has still to apply, innermost last. */
+        std::vector<const BinaryExprNode*>        m_spine;
+
+        /* Nodes _label_tree() has yet to label; chain nodes still to _flatten(). */
+        struct Pending {
+            const ASTNode* node;
+            bool           ready;   // children labelled
+            bool           inner;   // below a +/- operator
+        };
+        std::vector<Pending>                              m_pending;
+        std::vector<std::pair<const ASTNode*, bool>>      m_walk;     // node, negative
+
+        Value _expr       (const ASTNode& node);
+        Value _in_order   (const BinaryExprNode& node);    // without reorder
+        Value _call       (const FunctionCallNode& node);
+        Value _equality   (const BinaryExprNode& node);
+        Value _chain      (const BinaryExprNode& node);
+        Label _label      (const ASTNode& node);
+        void  _label_tree (const ASTNode& node);
+        Label _label_node (const ASTNode& node);
+        void  _flatten    (const BinaryExprNode& root);
+        bool  _order      (size_t mark);    // orders the chain in m_terms[mark..]; whether anything moved
+        bool  _terminated () const;         // the current block ends in exit or ret
+
+        IrFunction& _fn() const { return this->m_builder.m_out.functions[this->m_index]; }
+
+        std::optional<Binding> _lookup(SymbolId name) const;
+        VarId _declare_var(IrVar::Kind kind, SymbolId name);
+        VarId _resolve_var(SymbolId name);
+        Value _emit       (IrInstr instr);  // instr.dest, if it has one; stamps m_loc
+    };
+
+    const ProgramNode&   m_program;
+    bool                 m_reorder;
+    bool                 m_externals;
+    ThreadPool*          m_pool;
+    size_t               m_reordered = 0;
+    IrProgram            m_out;
+    SymbolTable<Binding> m_globals;     // functions, and globals as the top-level code declares them
+
+    /* Per IR function; nullptr for the top-level code and external functions. */
+    std::vector<const FunctionDeclNode*> m_decls;
+    std::vector<VarId>                   m_first_var;            // per declared function: its reserved VarIds start here
+    std::unordered_map<SymbolId, uint32_t> m_external_index;     // name -> IR function
+    std::vector<const ASTNode*>            m_prescan;            // _prescan()'s stack
+
+    uint32_t _reserve (const FunctionDeclNode& node);            // its VarIds; returns the first
+    void     _prescan (const FunctionDeclNode& node);            // declares the externals it calls
+    void     _prescan (const ASTNode& node, SymbolTable<Binding>& locals);
+    uint32_t _external(SymbolId name, uint32_t params);
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "ir.hpp"
+#include "thread_pool.hpp"
+
+/*
+ * Optimizes IR in place, running its passes in turn until none
+ * of them changes anything:
+ *
+ *  - Copy propagation: a load of a variable whose value is known
+ *    in the block (stored or loaded earlier, and not possibly
+ *    written by a call since) is replaced by that value.
+ *  - Dead store elimination: a store no later load or call can
+ *    observe is removed. After a ret only globals can be read,
+ *    by the caller; after an exit nothing can.
+ *  - Dead code elimination: code after an exit or a call that
+ *    never returns is dropped, as are loads and arithmetic whose
+ *    value is never used.
+ *
+ * Calls are summarised by the callee's reads and writes, which
+ * are recomputed (compute_effects) whenever a pass changes the
+ * program. Calls themselves are never removed.
+ *
+ * Together these keep each variable in a value for as long as
+ * possible: locals, parameters and globals no function touches
+ * end up with no loads or stores at all.
+ *
+ * A pass only reads other functions' summaries, which stay fixed
+ * until it has run on every function, so with a pool it runs on
+ * the functions in parallel and changes nothing in the result.
+ */
+class IrOptimizer {
+public:
+    explicit IrOptimizer(IrProgram& program, ThreadPool* pool = nullptr)
+        : m_program(program), m_pool(pool) {}
+
+    /* With dump set, prints the IR as built and after each pass that changed it. */
+    void run(std::ostream* dump = nullptr);
+
+    size_t forwarded()   const { return this->m_forwarded; }     // loads replaced
+    size_t dead_stores() const { return this->m_dead_stores; }
+    size_t dead_code()   const { return this->m_dead_code; }     // instructions removed
+
+private:
+    /* State a pass keeps while it works on one function; one per pool slot. */
+    struct Scratch {
+        /* Per-VarId state, reset through touched after each block. */
+        std::vector<Value>   known;         // copy propagation: current value, or NoValue
+        std::vector<uint8_t> live;          // dead stores: Unknown / Live / Dead
+        std::vector<VarId>   touched;
+
+        std::vector<Value>   replace;       // per Value: what replaces it, or NoValue
+        std::vector<uint8_t> used;          // per Value
+        std::vector<uint8_t> remove;        // per instruction of the current block
+    };
+
+    IrProgram&           m_program;
+    ThreadPool*          m_pool;
+    size_t               m_forwarded   = 0;
+    size_t               m_dead_stores = 0;
+    size_t               m_dead_code   = 0;
+    std::vector<Scratch> m_scratch;
+
+    size_t _propagate_copies(IrFunction& fn, Scratch& s) const;
+    size_t _dead_stores     (IrFunction& fn, Scratch& s) const;
+    size_t _dead_code       (IrFunction& fn, Scratch& s) const;
+
+    static size_t _compact(std::vector<IrInstr>& code, const std::vector<uint8_t>& remove);
+};
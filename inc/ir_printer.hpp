@@ -0,0 +1,39 @@
+#pragma once
+
+#include <ostream>
+#include <vector>
+
+#include "ir.hpp"
+
+/*
+ * Writes IR as text, one instruction per line:
+ *
+ *   fn f($x)                ; reads $a  writes $b
+ *   bb0:
+ *       %0 = load $x
+ *       %1 = add %0, %0
+ *       store $b, %1
+ *       call g(%1)
+ *       ret
+ *
+ * The top-level code comes first, headed `top-level`. A variable
+ * whose name is shared with another (shadowing, or locals of the
+ * same name in different functions) is suffixed with its VarId,
+ * as in $x.3.
+ */
+class IrPrinter {
+public:
+    IrPrinter(std::ostream& os, const IrProgram& program);
+
+    void print();
+    void print(const IrFunction& fn);
+
+private:
+    std::ostream&     m_os;
+    const IrProgram&  m_program;
+    std::vector<bool> m_shared;         // per VarId
+
+    void _instr(const IrFunction& fn, const IrInstr& in);
+    void _var  (VarId var);
+    void _vars (const std::vector<VarId>& vars);
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "mir.hpp"
+
+/*
+ * Where an allocated MProgram goes in LC2K memory:
+ *
+ *   0          beq 0 0 <data words>    over the data
+ *   1 ...      every .fill word, most used first
+ *   ...        code: the top-level code, then each function
+ *
+ * lw and sw name their word by a 16-bit absolute offset, so data
+ * has to sit below address 32768; code does not (calls jump
+ * through address words, and the only branches are the short
+ * ones inside expansions). Data first keeps it in reach however
+ * large the code grows. A program without data starts with its
+ * code at 0.
+ *
+ * AsmWriter and Assembler both go through it, so the text and the
+ * machine code agree on every address and a program one of them
+ * cannot hold is rejected by both. The constructor throws
+ * std::runtime_error if the program needs more than LC2K's 65536
+ * words, if it has more data than lw and sw can reach, if a label
+ * is never defined, or if an offset does not fit in its 16 bits.
+ */
+class Layout {
+public:
+    explicit Layout(const MProgram& program);
+
+    uint32_t size() const { return this->m_size; }                   // words
+    uint32_t address(LabelId label) const;                            // throws if undefined
+
+    /* The jump at address 0, if there is data to jump over. */
+    bool   has_jump() const { return !this->m_data.empty(); }
+    MInstr jump    () const;
+
+    /* The .fill words in address order, from 1. */
+    const std::vector<const DataWord*>& data() const { return this->m_data; }
+
+    /* The 16-bit field of a lw, sw or beq at pc: absolute for memory, relative to pc + 1 for beq. */
+    int64_t offset(const MInstr& in, uint32_t pc) const;
+
+private:
+    static constexpr uint32_t Undefined = UINT32_MAX;
+
+    const MProgram&              m_program;
+    std::vector<uint32_t>        m_address;     // per LabelId
+    std::vector<const DataWord*> m_data;
+    uint32_t                     m_size = 0;
+
+    void _order_data();                         // fills m_data, hottest first
+    void _check     () const;
+};
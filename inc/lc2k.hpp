@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * The LC2K target (EECS370): eight 32-bit registers, 65536 words
+ * of word-addressed memory and eight instructions.
+ *
+ *   add  regA regB destReg     destReg = regA + regB
+ *   nor  regA regB destReg     destReg = ~(regA | regB)
+ *   lw   regA regB offset      regB = mem[regA + offset]
+ *   sw   regA regB offset      mem[regA + offset] = regB
+ *   beq  regA regB offset      if regA == regB: pc = pc + 1 + offset
+ *   jalr regA regB             regB = pc + 1; pc = regA
+ *   halt
+ *   noop
+ *
+ * X(name) in encoding order: the opcode field holds the index.
+ */
+#define LCC_LC2K_OPCODES(X) \
+    X(add)                  \
+    X(nor)                  \
+    X(lw)                   \
+    X(sw)                   \
+    X(beq)                  \
+    X(jalr)                 \
+    X(halt)                 \
+    X(noop)
+
+/*
+ * Pseudo-instructions used between lowering and emission. They
+ * keep multi-instruction sequences with fixed branch offsets in
+ * one piece, so the register allocator cannot split them.
+ *
+ *   eq   regA regB destReg     destReg = regA == regB ? 1 : 0
+ *                              (offset names a word holding 1)
+ */
+#define LCC_LC2K_PSEUDO_OPS(X) \
+    X(eq)
+
+#define LCC_LC2K_ENUM(name) name,
+
+enum class Opcode : uint8_t {
+    LCC_LC2K_OPCODES(LCC_LC2K_ENUM)
+    LCC_LC2K_PSEUDO_OPS(LCC_LC2K_ENUM)
+};
+
+#undef LCC_LC2K_ENUM
+
+#define LCC_LC2K_NAME_CASE(name) case Opcode::name: return #name;
+
+inline const char* to_string(Opcode op) {
+    switch (op) {
+        LCC_LC2K_OPCODES   (LCC_LC2K_NAME_CASE)
+        LCC_LC2K_PSEUDO_OPS(LCC_LC2K_NAME_CASE)
+    }
+    return "unknown_opcode";
+}
+
+#undef LCC_LC2K_NAME_CASE
+
+namespace lc2k {
+
+inline constexpr int      NumRegs    = 8;
+inline constexpr uint32_t MemorySize = 65536;      // words
+
+/* Register conventions used by the code generator. */
+inline constexpr int ZeroReg  = 0;     // always 0, never written
+inline constexpr int ExitReg  = 1;     // exit(value) leaves value here
+inline constexpr int LinkReg  = 7;     // return address of jalr calls
+inline constexpr int TrashReg = 6;     // `jalr 7 6` returns; the link it writes is dead
+
+/* 16-bit two's complement offset field of lw/sw/beq. */
+inline constexpr int32_t MinOffset = -32768;
+inline constexpr int32_t MaxOffset =  32767;
+
+} // namespace lc2k
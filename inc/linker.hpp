@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mir.hpp"
+#include "object_file.hpp"
+
+/*
+ * Links objects (see object_file.hpp) into one MProgram, ready for
+ * AsmWriter / Assembler like a program compiled from one file.
+ *
+ *  - The first object is the entry: its top-level code runs first.
+ *    The others may only declare functions.
+ *  - Each external function is bound to the one function of that
+ *    name some object defines, which must take as many
+ *    parameters.
+ *  - Only functions reachable through calls from the entry's
+ *    top-level code are kept, and only the data their code uses.
+ *  - Read-only constant words with the same value, and words
+ *    holding the address of the same function, are merged.
+ *
+ * Kept functions stay in command-line and source order.
+ *
+ * Throws std::runtime_error("Link error: ...").
+ */
+class Linker {
+public:
+    explicit Linker(std::vector<Object> objects)
+        : m_objects(std::move(objects)) {}
+
+    MProgram link();
+
+    size_t stripped() const { return this->m_stripped; }     // functions no call reaches
+    size_t merged  () const { return this->m_merged;   }     // .fill words shared with an equal one
+
+private:
+    /* A function of an object: (object, index into its functions). */
+    struct FnRef {
+        uint32_t object;
+        uint32_t index;
+
+        bool operator==(const FnRef&) const = default;
+    };
+
+    static constexpr FnRef NoFn {UINT32_MAX, UINT32_MAX};
+
+    std::vector<Object> m_objects;
+    MProgram            m_out;
+    size_t              m_stripped = 0;
+    size_t              m_merged   = 0;
+
+    std::unordered_map<SymbolId, FnRef>  m_defined;        // by name
+    std::vector<std::vector<FnRef>>      m_target;         // per object and function: the definition
+    std::vector<std::vector<uint32_t>>   m_address_of;     // per object and label: function whose address word it is, or UINT32_MAX
+    std::vector<std::vector<uint8_t>>    m_kept;           // per object and function
+    std::vector<std::vector<uint8_t>>    m_used;           // per object and label: kept code refers to it
+    std::vector<std::vector<LabelId>>    m_labels;         // per object: old label -> output label
+
+    void  _resolve  ();
+    void  _reach    ();
+    void  _place    ();
+    void  _emit     ();
+
+    LabelId _new    (uint32_t object, LabelId label);      // an output label like label
+    void    _remap  (uint32_t object, MInstr& in) const;
+    DataWord _remap (uint32_t object, const DataWord& word) const;
+
+    [[noreturn]] static void _error(const std::string& msg);
+};
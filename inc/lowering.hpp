@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "lc2k.hpp"
+
+/*
+ * Lowerings of the LC operators LC2K has no instruction for. The
+ * sequences are not written by hand: tools/superopt.cpp searches
+ * every LC2K sequence up to MaxLength instructions long, keeps the
+ * shortest that computes the operator, and writes them to
+ * lowering_table.hpp (`make lowering` regenerates it).
+ *
+ * The entries are tested, not proven: each was run on every pair
+ * of edge values, 100000 random pairs and every pair at 8 bits
+ * (see superopt.cpp for why that last is no proof either). That
+ * no shorter sequence exists is exact, not sampled.
+ *
+ * A sequence is over roles, not registers: A and B are the
+ * operands, D the result, T a spare register and S0.. temporaries
+ * that are each written once. The caller maps roles to registers.
+ *
+ * Sequences differ by which registers they may use (Regs) and, in
+ * the fixed-register settings, by how the operands and the result
+ * alias (Alias): a sequence for d == a may overwrite a, one for
+ * distinct registers must leave both operands intact.
+ */
+namespace lowering {
+
+#define LCC_LOWERED_OPS(X)                                          \
+    X(Sub, "sub")   /* d = a - b                                 */ \
+    X(Neg, "neg")   /* d = -a                                    */ \
+    X(Eq,  "eq")    /* d = a == b ? 1 : 0                        */
+
+#define LCC_LOWERING_ALIASES(X)                                     \
+    X(Distinct, "distinct")  /* a, b and d are three registers   */ \
+    X(DestA,    "d=a")                                              \
+    X(DestB,    "d=b")                                              \
+    X(SameAB,   "a=b")       /* d is another register            */ \
+    X(All,      "d=a=b")
+
+#define LCC_LOWERING_REGS(X)                                                    \
+    X(Ssa,   "ssa")     /* any number of fresh temporaries, written once     */ \
+    X(None,  "none")    /* nothing but a, b, d and r0                        */ \
+    X(Spare, "spare")   /* ... and one spare register                        */
+
+#define LCC_LOWERING_ENUM(name, str) name,
+#define LCC_LOWERING_NAME(name, str) str,
+
+enum class Op    : uint8_t { LCC_LOWERED_OPS      (LCC_LOWERING_ENUM) COUNT };
+enum class Alias : uint8_t { LCC_LOWERING_ALIASES (LCC_LOWERING_ENUM) COUNT };
+enum class Regs  : uint8_t { LCC_LOWERING_REGS    (LCC_LOWERING_ENUM) COUNT };
+
+inline constexpr const char* OpNames   [] = { LCC_LOWERED_OPS     (LCC_LOWERING_NAME) };
+inline constexpr const char* AliasNames[] = { LCC_LOWERING_ALIASES(LCC_LOWERING_NAME) };
+inline constexpr const char* RegsNames [] = { LCC_LOWERING_REGS   (LCC_LOWERING_NAME) };
+
+#undef LCC_LOWERING_ENUM
+#undef LCC_LOWERING_NAME
+
+enum Role : uint8_t { Zero, A, B, D, T, S0, S1, S2 };
+
+inline constexpr const char* RoleNames[] = {"Zero", "A", "B", "D", "T", "S0", "S1", "S2"};
+
+inline constexpr int MaxLength = 4;
+
+/*
+ * One instruction:
+ *   add / nor   z = x op y
+ *   lw          z = 1      (loaded from a word holding 1)
+ *   beq         skip the next offset steps if x == y
+ */
+struct Step {
+    Opcode  op;
+    Role    x      = Zero;
+    Role    y      = Zero;
+    Role    z      = Zero;
+    int8_t  offset = 0;
+};
+
+/* length 0: nothing of at most MaxLength instructions computes op. */
+struct Entry {
+    Op      op;
+    Alias   alias;
+    Regs    regs;
+    uint8_t length;
+    std::array<Step, MaxLength> steps;
+};
+
+/* How the registers of `d = a op b` alias. */
+inline Alias alias_of(uint32_t a, uint32_t b, uint32_t d) {
+    if (a == b)
+        return d == a ? Alias::All : Alias::SameAB;
+    if (d == a)
+        return Alias::DestA;
+    return d == b ? Alias::DestB : Alias::Distinct;
+}
+
+/* The table entry for op; see lowering_table.hpp. */
+const Entry& lookup(Op op, Alias alias, Regs regs);
+
+} // namespace lowering
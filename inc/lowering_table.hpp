@@ -0,0 +1,152 @@
+#pragma once
+
+/*
+ * Generated by tools/superopt.cpp (`make lowering`); do not edit.
+ * See lowering.hpp.
+ */
+#include "lowering.hpp"
+
+namespace lowering {
+
+inline constexpr Entry Table[] = {
+    /* sub, ssa, distinct: 3, checked on 100144 inputs and all 65536 at 8 bits */
+    {Op::Sub, Alias::Distinct, Regs::Ssa, 3, {{
+        {Opcode::nor, Zero, A,    S0,   0},
+        {Opcode::add, B,    S0,   S1,   0},
+        {Opcode::nor, Zero, S1,   D,    0}
+    }}},
+    /* sub, none, distinct: 3, checked on 100144 inputs and all 65536 at 8 bits */
+    {Op::Sub, Alias::Distinct, Regs::None, 3, {{
+        {Opcode::nor, Zero, A,    D,    0},
+        {Opcode::add, B,    D,    D,    0},
+        {Opcode::nor, Zero, D,    D,    0}
+    }}},
+    /* sub, none, d=a: 3, checked on 100144 inputs and all 65536 at 8 bits */
+    {Op::Sub, Alias::DestA, Regs::None, 3, {{
+        {Opcode::nor, Zero, D,    D,    0},
+        {Opcode::add, D,    B,    D,    0},
+        {Opcode::nor, Zero, D,    D,    0}
+    }}},
+    /* sub, none, d=b: nothing within 4 instructions */
+    {Op::Sub, Alias::DestB, Regs::None, 0, {{}}},
+    /* sub, none, a=b: 1, checked on 100144 inputs and all 256 at 8 bits */
+    {Op::Sub, Alias::SameAB, Regs::None, 1, {{
+        {Opcode::add, Zero, Zero, D,    0}
+    }}},
+    /* sub, none, d=a=b: 1, checked on 100144 inputs and all 256 at 8 bits */
+    {Op::Sub, Alias::All, Regs::None, 1, {{
+        {Opcode::add, Zero, Zero, D,    0}
+    }}},
+    /* sub, spare, distinct: 3, checked on 100144 inputs and all 65536 at 8 bits */
+    {Op::Sub, Alias::Distinct, Regs::Spare, 3, {{
+        {Opcode::nor, Zero, A,    D,    0},
+        {Opcode::add, B,    D,    D,    0},
+        {Opcode::nor, Zero, D,    D,    0}
+    }}},
+    /* sub, spare, d=a: 3, checked on 100144 inputs and all 65536 at 8 bits */
+    {Op::Sub, Alias::DestA, Regs::Spare, 3, {{
+        {Opcode::nor, Zero, D,    D,    0},
+        {Opcode::add, D,    B,    D,    0},
+        {Opcode::nor, Zero, D,    D,    0}
+    }}},
+    /* sub, spare, d=b: 3, checked on 100144 inputs and all 65536 at 8 bits */
+    {Op::Sub, Alias::DestB, Regs::Spare, 3, {{
+        {Opcode::nor, Zero, A,    T,    0},
+        {Opcode::add, D,    T,    D,    0},
+        {Opcode::nor, Zero, D,    D,    0}
+    }}},
+    /* sub, spare, a=b: 1, checked on 100144 inputs and all 256 at 8 bits */
+    {Op::Sub, Alias::SameAB, Regs::Spare, 1, {{
+        {Opcode::add, Zero, Zero, D,    0}
+    }}},
+    /* sub, spare, d=a=b: 1, checked on 100144 inputs and all 256 at 8 bits */
+    {Op::Sub, Alias::All, Regs::Spare, 1, {{
+        {Opcode::add, Zero, Zero, D,    0}
+    }}},
+    /* neg, ssa, distinct: 3, checked on 100144 inputs and all 256 at 8 bits */
+    {Op::Neg, Alias::Distinct, Regs::Ssa, 3, {{
+        {Opcode::nor, Zero, Zero, S0,   0},
+        {Opcode::add, A,    S0,   S1,   0},
+        {Opcode::nor, Zero, S1,   D,    0}
+    }}},
+    /* neg, none, distinct: 3, checked on 100144 inputs and all 256 at 8 bits */
+    {Op::Neg, Alias::Distinct, Regs::None, 3, {{
+        {Opcode::nor, Zero, Zero, D,    0},
+        {Opcode::add, A,    D,    D,    0},
+        {Opcode::nor, Zero, D,    D,    0}
+    }}},
+    /* neg, none, d=a: nothing within 4 instructions */
+    {Op::Neg, Alias::DestA, Regs::None, 0, {{}}},
+    /* neg, spare, distinct: 3, checked on 100144 inputs and all 256 at 8 bits */
+    {Op::Neg, Alias::Distinct, Regs::Spare, 3, {{
+        {Opcode::nor, Zero, Zero, D,    0},
+        {Opcode::add, A,    D,    D,    0},
+        {Opcode::nor, Zero, D,    D,    0}
+    }}},
+    /* neg, spare, d=a: 3, checked on 100144 inputs and all 256 at 8 bits */
+    {Op::Neg, Alias::DestA, Regs::Spare, 3, {{
+        {Opcode::nor, Zero, Zero, T,    0},
+        {Opcode::add, D,    T,    D,    0},
+        {Opcode::nor, Zero, D,    D,    0}
+    }}},
+    /* eq, ssa, distinct: nothing within 4 instructions */
+    {Op::Eq, Alias::Distinct, Regs::Ssa, 0, {{}}},
+    /* eq, none, distinct: 3, checked on 100144 inputs and all 65536 at 8 bits */
+    {Op::Eq, Alias::Distinct, Regs::None, 3, {{
+        {Opcode::lw,  Zero, Zero, D,    0},
+        {Opcode::beq, A,    B,    Zero, 1},
+        {Opcode::add, Zero, Zero, D,    0}
+    }}},
+    /* eq, none, d=a: 4, checked on 100144 inputs and all 65536 at 8 bits */
+    {Op::Eq, Alias::DestA, Regs::None, 4, {{
+        {Opcode::beq, D,    B,    Zero, 2},
+        {Opcode::add, Zero, Zero, D,    0},
+        {Opcode::beq, Zero, Zero, Zero, 1},
+        {Opcode::lw,  Zero, Zero, D,    0}
+    }}},
+    /* eq, none, d=b: 4, checked on 100144 inputs and all 65536 at 8 bits */
+    {Op::Eq, Alias::DestB, Regs::None, 4, {{
+        {Opcode::beq, A,    D,    Zero, 2},
+        {Opcode::add, Zero, Zero, D,    0},
+        {Opcode::beq, Zero, Zero, Zero, 1},
+        {Opcode::lw,  Zero, Zero, D,    0}
+    }}},
+    /* eq, none, a=b: 1, checked on 100144 inputs and all 256 at 8 bits */
+    {Op::Eq, Alias::SameAB, Regs::None, 1, {{
+        {Opcode::lw,  Zero, Zero, D,    0}
+    }}},
+    /* eq, none, d=a=b: 1, checked on 100144 inputs and all 256 at 8 bits */
+    {Op::Eq, Alias::All, Regs::None, 1, {{
+        {Opcode::lw,  Zero, Zero, D,    0}
+    }}},
+    /* eq, spare, distinct: 3, checked on 100144 inputs and all 65536 at 8 bits */
+    {Op::Eq, Alias::Distinct, Regs::Spare, 3, {{
+        {Opcode::lw,  Zero, Zero, D,    0},
+        {Opcode::beq, A,    B,    Zero, 1},
+        {Opcode::add, Zero, Zero, D,    0}
+    }}},
+    /* eq, spare, d=a: 4, checked on 100144 inputs and all 65536 at 8 bits */
+    {Op::Eq, Alias::DestA, Regs::Spare, 4, {{
+        {Opcode::add, Zero, D,    T,    0},
+        {Opcode::lw,  Zero, Zero, D,    0},
+        {Opcode::beq, B,    T,    Zero, 1},
+        {Opcode::add, Zero, Zero, D,    0}
+    }}},
+    /* eq, spare, d=b: 4, checked on 100144 inputs and all 65536 at 8 bits */
+    {Op::Eq, Alias::DestB, Regs::Spare, 4, {{
+        {Opcode::add, Zero, D,    T,    0},
+        {Opcode::lw,  Zero, Zero, D,    0},
+        {Opcode::beq, A,    T,    Zero, 1},
+        {Opcode::add, Zero, Zero, D,    0}
+    }}},
+    /* eq, spare, a=b: 1, checked on 100144 inputs and all 256 at 8 bits */
+    {Op::Eq, Alias::SameAB, Regs::Spare, 1, {{
+        {Opcode::lw,  Zero, Zero, D,    0}
+    }}},
+    /* eq, spare, d=a=b: 1, checked on 100144 inputs and all 256 at 8 bits */
+    {Op::Eq, Alias::All, Regs::Spare, 1, {{
+        {Opcode::lw,  Zero, Zero, D,    0}
+    }}},
+};
+
+} // namespace lowering
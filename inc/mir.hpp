@@ -0,0 +1,236 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "interner.hpp"
+#include "lc2k.hpp"
+#include "lowering.hpp"
+#include "source_map.hpp"
+
+/*
+ * Machine IR: LC2K instructions over registers, the form code is
+ * in between lowering (codegen.cpp), register allocation
+ * (regalloc.cpp) and emission (asm_writer.cpp).
+ *
+ * Registers below FirstVReg are the physical r0..r7; the rest
+ * are virtual. Every function body is straight-line code (LC has
+ * no control flow), and lowering defines each virtual register
+ * exactly once. After allocation only physical registers remain.
+ *
+ * Memory operands are labels; they are printed by name and only
+ * resolved to addresses when a program is assembled.
+ */
+using Reg = uint32_t;
+
+inline constexpr Reg FirstVReg = lc2k::NumRegs;
+inline constexpr Reg NoReg     = UINT32_MAX;
+
+inline bool is_virtual(Reg reg) { return reg >= FirstVReg && reg != NoReg; }
+
+using LabelId = uint32_t;
+
+inline constexpr LabelId NoLabel = UINT32_MAX;
+
+/*
+ * Operands follow the LC2K fields (see lc2k.hpp): lw loads into
+ * b, sw stores b, jalr links into b. Memory and branch offsets
+ * are label + offset, or just offset when label is NoLabel.
+ */
+struct MInstr {
+    Opcode  op;
+    Reg     a      = 0;        // regA
+    Reg     b      = 0;        // regB
+    Reg     d      = 0;        // destReg (add, nor, eq)
+    LabelId label  = NoLabel;
+    int32_t offset = 0;
+    SourceLoc loc  = NoLoc;    // statement it came from, for profiles
+};
+
+/* Registers read by in; returns how many were written to out. */
+inline int uses(const MInstr& in, Reg out[2]) {
+    switch (in.op) {
+        case Opcode::add:
+        case Opcode::nor:
+        case Opcode::eq:
+        case Opcode::sw:
+        case Opcode::beq:  out[0] = in.a; out[1] = in.b; return 2;
+        case Opcode::lw:
+        case Opcode::jalr: out[0] = in.a;                return 1;
+        case Opcode::halt:
+        case Opcode::noop:                               return 0;
+    }
+    return 0;
+}
+
+/* Register written by in, or NoReg. */
+inline Reg def(const MInstr& in) {
+    switch (in.op) {
+        case Opcode::add:
+        case Opcode::nor:
+        case Opcode::eq:   return in.d;
+        case Opcode::lw:
+        case Opcode::jalr: return in.b;
+        default:           return NoReg;
+    }
+}
+
+/* Pointer to the register field def() reads, for rewriting. */
+inline Reg* def_field(MInstr& in) {
+    switch (in.op) {
+        case Opcode::add:
+        case Opcode::nor:
+        case Opcode::eq:   return &in.d;
+        case Opcode::lw:
+        case Opcode::jalr: return &in.b;
+        default:           return nullptr;
+    }
+}
+
+/* jalr linking into r7; its target is in a. */
+inline bool is_call(const MInstr& in) {
+    return in.op == Opcode::jalr && in.b == lc2k::LinkReg;
+}
+
+/* `jalr 7 6`, the return every function ends with. */
+inline bool is_return(const MInstr& in) {
+    return in.op == Opcode::jalr && in.a == lc2k::LinkReg && in.b == lc2k::TrashReg;
+}
+
+inline constexpr int MaxExpansion = lowering::MaxLength;
+
+/*
+ * The LC2K instructions in stands for, written to out: in itself,
+ * or the expansion of a pseudo-instruction. Returns how many.
+ * Both the writer and the assembler go through this, so text and
+ * machine code always agree on addresses.
+ */
+inline int expand(const MInstr& in, MInstr out[MaxExpansion]) {
+    if (in.op != Opcode::eq) {
+        out[0] = in;
+        return 1;
+    }
+
+    /* in.label names a word holding 1; allocation is over, so there is no spare register. */
+    using namespace lowering;
+    const Entry& e = lookup(Op::Eq, alias_of(in.a, in.b, in.d), Regs::None);
+
+    const Reg roles[] = {lc2k::ZeroReg, in.a, in.b, in.d};
+    int n = e.length;
+    for (int k = 0; k < n; k++) {
+        const Step& s = e.steps[k];
+        switch (s.op) {
+            case Opcode::lw:  out[k] = MInstr {.op = s.op, .a = lc2k::ZeroReg, .b = roles[s.z], .label = in.label}; break;
+            case Opcode::beq: out[k] = MInstr {.op = s.op, .a = roles[s.x], .b = roles[s.y], .offset = s.offset};   break;
+            default:          out[k] = MInstr {.op = s.op, .a = roles[s.x], .b = roles[s.y], .d = roles[s.z]};      break;
+        }
+    }
+
+    for (int k = 0; k < n; k++)
+        out[k].loc = in.loc;
+    return n;
+}
+
+/*
+ * What a label names. Each kind prints as its prefix letter and a
+ * per-kind index (F0, K12, ...), which keeps names within the six
+ * characters LC2K assemblers accept for any program that fits in
+ * LC2K memory.
+ */
+#define LCC_LABEL_KINDS(X)                                              \
+    X(Func,   'F')  /* function entry point                          */ \
+    X(Const,  'K')  /* constant word, read-only                      */ \
+    X(Global, 'G')  /* global variable read or written by functions  */ \
+    X(Param,  'P')  /* parameter, only ever written by callers       */ \
+    X(Spill,  'S')  /* register allocator spill slot                 */ \
+    X(Save,   'R')  /* saved return address                          */
+
+#define LCC_LABEL_KIND_ENUM(name, prefix) name,
+
+enum class LabelKind : uint8_t {
+    LCC_LABEL_KINDS(LCC_LABEL_KIND_ENUM)
+    COUNT
+};
+
+#undef LCC_LABEL_KIND_ENUM
+
+#define LCC_LABEL_KIND_PREFIX(name, prefix) prefix,
+
+inline constexpr char LabelPrefix[] = {
+    LCC_LABEL_KINDS(LCC_LABEL_KIND_PREFIX)
+};
+
+#undef LCC_LABEL_KIND_PREFIX
+
+struct Label {
+    LabelKind kind;
+    uint32_t  index;                // within its kind
+    SymbolId  name = NoSymbol;      // source name, for comments
+};
+
+/* A `.fill` word: value, or the address of value_label if set. */
+struct DataWord {
+    LabelId label;
+    int32_t value       = 0;
+    LabelId value_label = NoLabel;
+};
+
+struct MFunction {
+    SymbolId              name  = NoSymbol;   // NoSymbol for the top-level code
+    LabelId               entry = NoLabel;
+    std::vector<LabelId>  params;              // parameter words, in order
+    std::vector<MInstr>   code;
+    std::vector<DataWord> data;                // parameters, spill slots, ...
+    Reg                   next_vreg = FirstVReg;
+    bool                  external  = false;   // no code or data here: entry and params are another object's
+
+    Reg new_vreg() { return this->next_vreg++; }
+
+    /*
+     * Labels from first on are provisional: a function lowered or
+     * allocated alongside others cannot add to MProgram::labels, so
+     * it numbers the labels it needs from first and the program
+     * gets them afterwards, in function order. This rewrites each
+     * provisional label to map[label - first].
+     */
+    void relabel(LabelId first, const std::vector<LabelId>& map) {
+        auto fix = [&](LabelId& label) {
+            if (label != NoLabel && label >= first)
+                label = map[label - first];
+        };
+
+        for (auto& in : this->code)
+            fix(in.label);
+        for (auto& word : this->data) {
+            fix(word.label);
+            fix(word.value_label);
+        }
+    }
+};
+
+/*
+ * A whole program. functions[0] is the top-level code and runs
+ * first; program-wide data (constants, shared globals) goes with
+ * every function's data below the code (see Layout).
+ */
+struct MProgram {
+    std::vector<Label>     labels;
+    std::vector<MFunction> functions;
+    std::vector<DataWord>  data;
+
+    LabelId new_label(LabelKind kind, SymbolId name = NoSymbol) {
+        uint32_t index = this->m_kind_count[static_cast<size_t>(kind)]++;
+        this->labels.push_back(Label {kind, index, name});
+        return static_cast<LabelId>(this->labels.size() - 1);
+    }
+
+    /* Constants and parameters never change while their readers run. */
+    bool is_read_only(LabelId label) const {
+        auto kind = this->labels[label].kind;
+        return kind == LabelKind::Const || kind == LabelKind::Param;
+    }
+
+private:
+    std::array<uint32_t, static_cast<size_t>(LabelKind::COUNT)> m_kind_count {};
+};
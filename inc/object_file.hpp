@@ -0,0 +1,46 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include "mir.hpp"
+
+/*
+ * A relocatable object: one file's allocated MProgram, before
+ * layout, so the linker can place and merge it with others.
+ *
+ * Labels stay symbolic. Those an object defines are the words in
+ * its data and the entries of its functions; the entry and
+ * parameter words of its external functions are undefined, and
+ * name the function they belong to: that name, with the number of
+ * parameters, is the object's symbol table.
+ *
+ * statements records whether the file had top-level statements.
+ * Only the first object of a link runs its top-level code.
+ */
+struct Object {
+    std::string name;               // for errors: the file it was read from
+    bool        statements = false;
+    MProgram    program;
+};
+
+/*
+ * Text format, one record per line, fields separated by spaces;
+ * `-` is NoLabel / NoSymbol. Labels are numbered in order of
+ * their `label` lines.
+ *
+ *   lcc-object 1
+ *   statements <0|1>
+ *   label <prefix> <name>                         per label
+ *   function <name> <entry> <external> <n> <param>...
+ *   i <op> <a> <b> <d> <offset> <label>           its code
+ *   w <label> <value> <value label>               its data
+ *   data                                          program data follows
+ *   w ...
+ *   end
+ */
+void write_object(std::ostream& os, const Object& object);
+
+/* Throws std::runtime_error("Object error: <name>: ...") on malformed input. */
+Object read_object(std::string_view text, std::string_view name);
@@ -1,34 +1,93 @@
+#pragma once
+
+#include <array>
+
 #include "parser_nodes.hpp"
 #include "parser_errs.hpp"
 #include "tokenizer.hpp"
+#include "symbol_table.hpp"
 
+/*
+ * Parses straight from a TokenSource. Tokens are pulled in
+ * batches into a small fixed-size lookahead ring, so memory use
+ * does not grow with the input and parsing starts as soon as the
+ * first batch has been lexed.
+ */
 class Parser {
 public:
-    explicit Parser(std::vector<Token> tokens) 
-        : m_tokens(std::move(tokens)) {}
-    
+    explicit Parser(TokenSource& source)
+        : m_source(source) {}
+
     std::unique_ptr<ProgramNode> parse_program();
 
 private:
-    std::vector<Token> m_tokens;
-    size_t m_pos = 0;
+    /* Ring capacity; must be a power of two larger than the deepest peek(). */
+    static constexpr size_t Lookahead = 64;
+
+    TokenSource&                m_source;
+    std::array<Token, Lookahead> m_ring;
+    size_t                      m_head      = 0;     // index of peek(0)
+    size_t                      m_count     = 0;     // buffered tokens
+    bool                        m_exhausted = false; // source returned 0
+
+    /*
+     * Deepest nesting of parentheses and call arguments. The parser
+     * and every later pass over the AST recurse once per level (long
+     * +/- chains do not count), so deeper input is an error rather
+     * than a stack overflow.
+     */
+    static constexpr size_t MaxNesting = 10000;
+
+    size_t                      m_depth     = 0;     // parse_expr() calls active
+
+    /* Arena of the program being parsed; every node is made here. */
+    AstArena* m_arena = nullptr;
+
+    /*
+     * Child lists are gathered on these stacks, then copied into
+     * the arena in one piece once their length is known. Nested
+     * lists push above their parent's entries, so a list is always
+     * the tail of the stack from the mark taken when it started.
+     */
+    std::vector<ASTNodePtr>              m_node_scratch;
+    std::vector<FunctionDeclNode::Param> m_param_scratch;
+
+    /*
+     * Declarations seen so far, per scope. Parameters map to
+     * their FunctionDeclNode.
+     */
+    SymbolTable<const ASTNode*> m_symbols;
+
+    /* peek()'s reference is only valid until the next peek()/consume(). */
+    const Token& peek   (size_t offset = 0);
+    Token        consume();
 
-    const Token& peek   (size_t offset = 0) const;
-    const Token& consume();
+    /* Tops the ring up until it holds more than `offset` tokens (or input ends). */
+    void         _fill  (size_t offset);
 
     /* Parsing for ASTNodes. */
-    std::unique_ptr<ASTNode>          parse_statement    ();
-
-    std::unique_ptr<FunctionDeclNode> parse_function_decl();
-    std::unique_ptr<FunctionCallNode> parse_function_call();
-    std::unique_ptr<VarDeclNode>      parse_var_decl     ();
-    std::unique_ptr<AssignmentNode>   parse_assignment   ();
-    std::unique_ptr<ExitNode>         parse_exit_stmt    ();
-    std::unique_ptr<ExprStmtNode>     parse_expr_stmt    ();
-    std::unique_ptr<BinaryExprNode>   parse_binary_expr  ();
-    std::unique_ptr<IdentNode>        parse_ident_node   ();
-    std::unique_ptr<IntLiteralNode>   parse_int_literal  ();
-    
+    ASTNodePtr        parse_statement    ();
+
+    FunctionDeclNode* parse_function_decl();
+    FunctionCallNode* parse_function_call();
+    VarDeclNode*      parse_var_decl     ();
+    AssignmentNode*   parse_assignment   ();
+    ExitNode*         parse_exit_stmt    ();
+    ExprStmtNode*     parse_expr_stmt    ();
+    IdentNode*        parse_ident_node   ();
+    IntLiteralNode*   parse_int_literal  ();
+
+    /* Expressions, one function per grammar rule. */
+    ASTNodePtr        parse_expr         ();    // Expr / Equality
+    ASTNodePtr        parse_add_sub      ();    // AddSub
+    ASTNodePtr        parse_factor       ();    // Factor
+
+    BinaryExprNode*   _make_binary(TokenType op, ASTNodePtr left, ASTNodePtr right);
+    NodeList          _take_nodes (size_t mark);
+    std::string_view  _copy_value (const Token&);
+
+    /* Declares name in the current scope; throws if already declared there. */
+    void              _declare    (SymbolId name, const ASTNode* decl);
 
     bool _is_operator_token(Token&) const;
     bool _is_literal_token(Token&) const;
@@ -37,15 +96,15 @@ private:
     /*
      * Determines if a function call starts
      * with current token.
-     * 
+     *
      * Current Logic:
-     * 
+     *
      *  - Current token is an identifier
      *  - Next token is a l_paren token.
      */
-    inline bool _is_func_call() const;
+    inline bool _is_func_call();
 
-    /* 
+    /*
      * Matches current token's type to parameter.
      *  - If matches:        returns true.
      *  - If does not match: returns false.
@@ -53,7 +112,7 @@ private:
     inline bool _match        (TokenType);
     inline bool _match_consume(TokenType);
 
-    /* 
+    /*
      * [[ STRONGER VERSION OF Parser::_match ]]
      * Matches current token's type to parameter.
      *  - If matches:        returns true.
@@ -61,4 +120,4 @@ private:
      */
     inline bool _expect        (TokenType, ParseErrorType);
     inline bool _expect_consume(TokenType, ParseErrorType);
-};
\ No newline at end of file
+};
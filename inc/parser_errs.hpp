@@ -11,6 +11,17 @@ enum class ParseErrorType {
     ExpectedDataType,
     ExpectedIdentifier,
     ExpectedEqual,
+    ExpectedFn,
+    ExpectedExit,
+    ExpectedLParen,
+    ExpectedRParen,
+    ExpectedComma,
+    ExpectedLCurl,
+    ExpectedRCurl,
+    ExpectedExpression,
+    InvalidIntLiteral,
+    Redeclaration,
+    TooDeep,
     COUNT // handy to keep track of number of errors
 };
 
@@ -21,7 +32,18 @@ ParseErrorStrings {{
     "Expected ';'",
     "Expected [data type]",
     "Expected [identifier]",
-    "Expected '='"
+    "Expected '='",
+    "Expected 'fn'",
+    "Expected 'exit'",
+    "Expected '('",
+    "Expected ')'",
+    "Expected ','",
+    "Expected '{'",
+    "Expected '}'",
+    "Expected [expression]",
+    "Invalid integer literal",
+    "Redeclared identifier",
+    "Expression nested too deeply"
 }};
 
 inline std::string to_string(ParseErrorType type) {
@@ -3,151 +3,218 @@
 #include <vector>
 #include <optional>
 #include <memory>
-#include <string>
-#include <sstream>
-#include <ostream>
-
-inline std::string indent_str(int indent) {
-    return std::string(indent * 2, ' '); // 2 spaces per level
-}
+#include <string_view>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "ast_arena.hpp"
+#include "interner.hpp"
+#include "token_type.hpp"
+
+/* Every concrete node type, in NodeKind order. */
+#define LCC_AST_NODES(X) \
+    X(Program)           \
+    X(FunctionDecl)      \
+    X(FunctionCall)      \
+    X(VarDecl)           \
+    X(Assignment)        \
+    X(Exit)              \
+    X(ExprStmt)          \
+    X(BinaryExpr)        \
+    X(Ident)             \
+    X(IntLiteral)
+
+#define LCC_AST_KIND(name) name,
+
+enum class NodeKind : uint8_t {
+    LCC_AST_NODES(LCC_AST_KIND)
+};
 
+#undef LCC_AST_KIND
+
+#define LCC_AST_FORWARD(name) struct name##Node;
+LCC_AST_NODES(LCC_AST_FORWARD)
+#undef LCC_AST_FORWARD
+
+/*
+ * All nodes of a program live in the AstArena owned by its
+ * ProgramNode: children are plain pointers, child lists are
+ * ArenaSpans, identifiers are interned SymbolIds and other
+ * strings are string_views into the arena. Nodes are never
+ * destroyed individually, so they must stay trivially
+ * destructible (no std::string / std::vector members).
+ *
+ * There are no virtual functions: every node records its
+ * NodeKind, and passes dispatch with visit() / node_cast()
+ * below, which switch on the tag.
+ *
+ * offset is where the node's first token starts in the source.
+ */
 struct ASTNode {
-    virtual ~ASTNode() = default;
-    virtual std::string to_string(int indent = 0) const = 0;
+    NodeKind kind;
+    uint32_t offset = 0;
+
+protected:
+    explicit ASTNode(NodeKind k) : kind(k) {}
+    ~ASTNode() = default;
 };
 
-using ASTNodePtr = std::unique_ptr<ASTNode>;
+/* Declares the node's static Kind and tags instances with it. */
+#define LCC_AST_NODE_KIND(name)                                 \
+    static constexpr NodeKind Kind = NodeKind::name;            \
+    name##Node() : ASTNode(Kind) {}
 
-/* Program root */
-struct ProgramNode : ASTNode {
-    std::vector<ASTNodePtr> functions_and_statements;
+using ASTNodePtr = ASTNode*;
+using NodeList   = ArenaSpan<ASTNodePtr>;
 
-    std::string to_string(int indent = 0) const override {
-        std::string s;
-        for (auto& stmt : functions_and_statements) {
-            s += stmt->to_string(indent) + "\n";
-        }
-        return s;
-    }
+/* Program root: owns the arena, so it is the only heap-allocated node. */
+struct ProgramNode final : ASTNode {
+    LCC_AST_NODE_KIND(Program)
+
+    AstArena arena;
+    NodeList functions_and_statements;
 };
 
 /* Function definition */
 struct FunctionDeclNode : ASTNode {
-    std::string return_type;
-    std::string name;
+    LCC_AST_NODE_KIND(FunctionDecl)
+
+    std::string_view return_type;
+    SymbolId name;
 
     struct Param {
-        std::string name;
-        std::string type;
+        SymbolId name;
+        std::string_view type;
     };
 
-    std::vector<Param> params;
-    std::vector<ASTNodePtr> body;
-
-    std::string to_string(int indent = 0) const override {
-        std::ostringstream oss;
-        oss << indent_str(indent) << "fn " << return_type << " " << name << "(";
-        for (size_t i = 0; i < params.size(); i++) {
-            if (i > 0) oss << ", ";
-            oss << params[i].type << " " << params[i].name;
-        }
-        oss << ") {\n";
-        for (auto& stmt : body) {
-            oss << stmt->to_string(indent + 1) << "\n";
-        }
-        oss << indent_str(indent) << "}";
-        return oss.str();
-    }
+    ArenaSpan<Param> params;
+    NodeList body;
 };
 
 struct FunctionCallNode : ASTNode {
-    std::string name;
-    std::vector<ASTNodePtr> args;
-
-    std::string to_string(int indent = 0) const override {
-        std::ostringstream oss;
-        oss << indent_str(indent) << name << "(";
-        for (size_t i = 0; i < args.size(); i++) {
-            if (i > 0) oss << ", ";
-            oss << args[i]->to_string();
-        }
-        oss << ")";
-        return oss.str();
-    }
+    LCC_AST_NODE_KIND(FunctionCall)
+
+    SymbolId name;
+    NodeList args;
 };
 
 /* Statements */
 struct VarDeclNode : ASTNode {
-    std::string name;
-    std::string type;
-    ASTNodePtr value;
+    LCC_AST_NODE_KIND(VarDecl)
 
-    std::string to_string(int indent = 0) const override {
-        return indent_str(indent) + "let " + name + " : " + type + " = " +
-               (value ? value->to_string() : "<null>") + ";";
-    }
+    SymbolId name;
+    std::string_view type;
+    ASTNodePtr value = nullptr;
 };
 
 struct AssignmentNode : ASTNode {
-    std::string name;
-    ASTNodePtr value;
+    LCC_AST_NODE_KIND(Assignment)
 
-    std::string to_string(int indent = 0) const override {
-        return indent_str(indent) + name + " = " +
-               (value ? value->to_string() : "<null>") + ";";
-    }
+    SymbolId name;
+    ASTNodePtr value = nullptr;
 };
 
 struct ExitNode : ASTNode {
-    ASTNodePtr value;
+    LCC_AST_NODE_KIND(Exit)
 
-    std::string to_string(int indent = 0) const override {
-        return indent_str(indent) + "exit " +
-               (value ? value->to_string() : "<null>") + ";";
-    }
+    ASTNodePtr value = nullptr;
 };
 
 struct ExprStmtNode : ASTNode {
-    ASTNodePtr expr;
+    LCC_AST_NODE_KIND(ExprStmt)
 
-    std::string to_string(int indent = 0) const override {
-        return indent_str(indent) +
-               (expr ? expr->to_string() : "<null>");
-    }
+    ASTNodePtr expr = nullptr;
 };
 
 /* Expressions */
 struct BinaryExprNode : ASTNode {
-    std::string op;
-    ASTNodePtr left;
-    ASTNodePtr right;
-
-    std::string to_string(int indent = 0) const override {
-        return indent_str(indent) + "(" +
-               (left ? left->to_string() : "<null>") +
-               " " + op + " " +
-               (right ? right->to_string() : "<null>") + ")";
-    }
+    LCC_AST_NODE_KIND(BinaryExpr)
+
+    TokenType op;        // o_plus, o_sub, o_equal_equal
+    ASTNodePtr left  = nullptr;
+    ASTNodePtr right = nullptr;
 };
 
 struct IdentNode : ASTNode {
-    std::string name;
+    LCC_AST_NODE_KIND(Ident)
 
-    std::string to_string(int indent = 0) const override {
-        return indent_str(indent) + name;
-    }
+    SymbolId name;
 };
 
 struct IntLiteralNode : ASTNode {
+    LCC_AST_NODE_KIND(IntLiteral)
+
     int value;
+};
 
-    std::string to_string(int indent = 0) const override {
-        return indent_str(indent) + std::to_string(value);
+#undef LCC_AST_NODE_KIND
+
+/*
+ * Statically dispatched visit: calls v(n) with node cast to its
+ * concrete type, e.g.
+ *
+ *     visit(*stmt, [](const auto& n) { ... });
+ *
+ * or with an object providing operator() overloads. Every
+ * overload must return the same type.
+ */
+template <typename From, typename To>
+using _copy_const_t = std::conditional_t<std::is_const_v<From>, const To, To>;
+
+#define LCC_AST_VISIT_CASE(name)                                            \
+    case NodeKind::name:                                                    \
+        return std::forward<Visitor>(v)(                                    \
+            static_cast<_copy_const_t<Node, name##Node>&>(base));
+
+template <typename Node, typename Visitor>
+    requires std::is_base_of_v<ASTNode, std::remove_const_t<Node>>
+decltype(auto) visit(Node& node, Visitor&& v) {
+    _copy_const_t<Node, ASTNode>& base = node;
+
+    switch (base.kind) {
+        LCC_AST_NODES(LCC_AST_VISIT_CASE)
     }
-};
+    __builtin_unreachable();
+}
 
-/* Operator<< for any ASTNode */
-inline std::ostream& operator<<(std::ostream& os, const ASTNode& node) {
-    os << node.to_string();
-    return os;
+#undef LCC_AST_VISIT_CASE
+
+/* node as a T if it is one, else nullptr (replaces dynamic_cast). */
+template <typename T>
+T* node_cast(ASTNode* node) {
+    return node && node->kind == T::Kind ? static_cast<T*>(node) : nullptr;
+}
+
+template <typename T>
+const T* node_cast(const ASTNode* node) {
+    return node && node->kind == T::Kind ? static_cast<const T*>(node) : nullptr;
+}
+
+/* Calls fn(child) for each direct child of node, in source order. */
+template <typename Fn>
+void for_each_child(const ASTNode& node, Fn&& fn) {
+    auto each = [&](const NodeList& list) {
+        for (auto* child : list) fn(child);
+    };
+    auto one = [&](const ASTNode* child) {
+        if (child) fn(child);
+    };
+
+    switch (node.kind) {
+        case NodeKind::Program:      each(static_cast<const ProgramNode&>(node).functions_and_statements); break;
+        case NodeKind::FunctionDecl: each(static_cast<const FunctionDeclNode&>(node).body);                break;
+        case NodeKind::FunctionCall: each(static_cast<const FunctionCallNode&>(node).args);                break;
+        case NodeKind::VarDecl:      one (static_cast<const VarDeclNode&>(node).value);                    break;
+        case NodeKind::Assignment:   one (static_cast<const AssignmentNode&>(node).value);                 break;
+        case NodeKind::Exit:         one (static_cast<const ExitNode&>(node).value);                       break;
+        case NodeKind::ExprStmt:     one (static_cast<const ExprStmtNode&>(node).expr);                    break;
+        case NodeKind::BinaryExpr:
+            one(static_cast<const BinaryExprNode&>(node).left);
+            one(static_cast<const BinaryExprNode&>(node).right);
+            break;
+        case NodeKind::Ident:
+        case NodeKind::IntLiteral:
+            break;
+    }
 }
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mir.hpp"
+#include "thread_pool.hpp"
+
+/*
+ * Peephole patterns, in the order a round tries them. Each is
+ * counted when it fires; the name is its stats counter.
+ */
+#define LCC_PEEPHOLE_PATTERNS(X)                                                        \
+    X(StoreLoad,  "store_load")   /* lw of a word the register already holds: gone   */ \
+    X(Noop,       "noop")         /* noop: gone                                      */ \
+    X(SelfMove,   "self_move")    /* add r 0 r, add 0 r r: gone                      */ \
+    X(DoubleNor,  "double_nor")   /* nor a a t ... nor t t d: the second is add a 0 d */ \
+    X(JumpNext,   "jump_next")    /* beq a b 0: gone                                 */ \
+    X(DeadDef,    "dead_def")     /* add / nor / eq / lw into a dead register: gone  */
+
+#define LCC_PEEPHOLE_ENUM(name, str) name,
+
+enum class Pattern : uint8_t {
+    LCC_PEEPHOLE_PATTERNS(LCC_PEEPHOLE_ENUM)
+    COUNT
+};
+
+#undef LCC_PEEPHOLE_ENUM
+
+#define LCC_PEEPHOLE_NAME(name, str) str,
+
+inline constexpr const char* PatternNames[] = {
+    LCC_PEEPHOLE_PATTERNS(LCC_PEEPHOLE_NAME)
+};
+
+#undef LCC_PEEPHOLE_NAME
+
+/*
+ * Rewrites allocated code (physical registers) with the patterns
+ * above until a round changes nothing.
+ *
+ * A round is a forward scan that tracks which register holds
+ * which memory word, then a backward scan over register liveness
+ * that drops dead definitions (which is what finally removes the
+ * first nor of a double negation). Calls, returns and branches
+ * end what the forward scan knows; beq offsets are adjusted for
+ * whatever was removed in between.
+ */
+class Peephole {
+public:
+    using Hits = std::array<size_t, static_cast<size_t>(Pattern::COUNT)>;
+
+    void run(MFunction& fn);
+
+    /* Every function of program, on pool if one is given (one Peephole per thread, hits summed here). */
+    void run(MProgram& program, ThreadPool* pool = nullptr);
+
+    const Hits& hits() const { return this->m_hits; }
+
+private:
+    static constexpr size_t DoubleNorWindow = 8;  // instructions searched for the second nor
+
+    Hits m_hits {};
+
+    std::vector<uint8_t>  m_remove;     // per instruction of the current scan
+    std::vector<uint8_t>  m_target;     // per instruction: some beq jumps here
+    std::vector<uint32_t> m_index;      // per instruction: position after _compact()
+
+    bool _forward(std::vector<MInstr>& code);
+    bool _dead   (std::vector<MInstr>& code);
+    void _targets(const std::vector<MInstr>& code);
+    void _remove (Pattern pattern, size_t i);
+    bool _compact(std::vector<MInstr>& code);      // drops m_remove'd instructions, fixing beq offsets
+};
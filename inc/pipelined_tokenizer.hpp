@@ -0,0 +1,41 @@
+#pragma once
+
+#include <exception>
+#include <string_view>
+#include <thread>
+
+#include "tokenizer.hpp"
+#include "spsc_ring.hpp"
+
+/*
+ * TokenSource that lexes on its own thread.
+ *
+ * A producer thread runs a Tokenizer over the source and pushes
+ * tokens in batches into an SpscRing; read_tokens() pops them on
+ * the consumer (parser) side. The ring is bounded, so a fast lexer
+ * blocks instead of running arbitrarily far ahead of the parser.
+ * The token sequence is exactly the one Tokenizer yields serially.
+ *
+ * Only the producer interns identifiers; a SymbolId received
+ * through the ring is safe to look up on the consumer side.
+ */
+class PipelinedTokenizer : public TokenSource {
+public:
+    static constexpr size_t RingSize = 4096;    // tokens in flight
+    static constexpr size_t Batch    = 256;     // tokens per push
+
+    explicit PipelinedTokenizer(std::string_view src);
+    ~PipelinedTokenizer() override;
+
+    PipelinedTokenizer(const PipelinedTokenizer&)            = delete;
+    PipelinedTokenizer& operator=(const PipelinedTokenizer&) = delete;
+
+    size_t read_tokens(Token* out, size_t max) override;
+
+private:
+    SpscRing<Token, RingSize> m_ring;
+    std::exception_ptr        m_error;      // set by the producer before close()
+    std::thread               m_producer;
+
+    void _produce(std::string_view src);
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "simulator.hpp"
+#include "source_map.hpp"
+
+/*
+ * Reports what a Simulator::profile() run counted in terms of the
+ * LC source, through the assembler's SourceMap:
+ *
+ *  - Flat: instructions per function, self (in its own code) and
+ *    total (including everything it called), then per source
+ *    line, hottest first, with the line's text.
+ *  - Collapsed: one line per calling context, `top-level;f;g 1234`
+ *    with the instructions run in g itself, the input format of
+ *    flamegraph.pl and most flame graph viewers.
+ *
+ * A statement's line is that of its first token; code the
+ * compiler adds (a function's return and saved link, the exit at
+ * the end of the program) counts for the function's declaration
+ * or, for the final exit, for no line at all.
+ */
+class Profiler {
+public:
+    enum class Format { Flat, Collapsed };
+
+    Profiler(const Simulator& sim, const SourceMap& map, const LineMap& lines, std::string_view file)
+        : m_sim(sim), m_map(map), m_lines(lines), m_file(file) {}
+
+    void report(std::ostream& os, Format format) const;
+
+private:
+    const Simulator& m_sim;
+    const SourceMap& m_map;
+    const LineMap&   m_lines;
+    std::string_view m_file;
+
+    void _flat     (std::ostream& os) const;
+    void _collapsed(std::ostream& os) const;
+
+    /* Index into m_map.functions of the code at address, or -1. */
+    int         _function(uint32_t address) const;
+    std::string _name    (int function) const;
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mir.hpp"
+#include "thread_pool.hpp"
+
+/*
+ * Linear-scan register allocation over the registers LC2K leaves
+ * free: r1..r6, and r7 as a last resort (in a function that costs
+ * saving the return address, which calls need anyway).
+ *
+ * Bodies are straight-line code, so every virtual register's live
+ * interval is [definition, last use] and one forward scan meets
+ * interval starts in order. A register is handed out as each
+ * interval starts and returned after its last use. When none is
+ * free, the interval whose next use is furthest away is split:
+ * its value goes to a spill slot (constants and parameters are
+ * simply reloaded from where they came from) and it is reloaded
+ * just before that next use. Calls split every interval that
+ * continues past them, since all registers are caller-saved.
+ *
+ * A spill slot is live from the value's first store to its last
+ * use, and goes back to a free list there; the next value to spill
+ * takes the most recently freed slot before a new word is added.
+ * Slot lifetimes are intervals met in start order, so this uses
+ * as few slots per function as any assignment could.
+ *
+ * run() rewrites every function in place to physical registers.
+ * Functions are allocated independently; labels and data come out
+ * as a serial run would make them.
+ */
+class LinearScan {
+public:
+    explicit LinearScan(MProgram& program, ThreadPool* pool = nullptr)
+        : m_program(program), m_pool(pool) {}
+
+    /* Allocates every function, on pool if one is given. */
+    void run();
+
+    size_t spills () const { return this->_sum(&Allocator::spills);  }   // stores to spill slots
+    size_t reloads() const { return this->_sum(&Allocator::reloads); }   // loads before split uses
+    size_t slots  () const { return this->_sum(&Allocator::slots);   }   // spill slot words added
+    size_t shared () const { return this->_sum(&Allocator::shared);  }   // spilled values given a freed slot
+
+private:
+    static constexpr uint32_t NoUse = UINT32_MAX;
+
+    /*
+     * Allocates one function at a time; run() keeps one per pool
+     * thread. Spill and save words get provisional labels from
+     * first (see MFunction::relabel), which run() turns into
+     * program labels in function order once all are done.
+     */
+    class Allocator {
+    public:
+        Allocator(const MProgram& program, LabelId first)
+            : m_program(program), m_first(first) {}
+
+        /* Returns the labels it made, in provisional order. */
+        std::vector<Label> allocate(MFunction& fn);
+
+        size_t spills  = 0;
+        size_t reloads = 0;
+        size_t slots   = 0;
+        size_t shared  = 0;
+
+    private:
+        const MProgram& m_program;
+        LabelId         m_first;
+        MFunction*      m_fn = nullptr;
+        std::vector<Label> m_labels;        // made for the current function
+
+        std::vector<MInstr>   m_code;           // input, virtual registers
+        std::vector<MInstr>   m_out;            // output, physical registers
+
+        /* Indexed by virtual register (entries below FirstVReg are unused). */
+        std::vector<uint32_t> m_def;            // position of the definition
+        std::vector<uint32_t> m_use_begin;      // uses are m_use_pos[begin[v] .. begin[v + 1])
+        std::vector<uint32_t> m_use_pos;
+        std::vector<uint32_t> m_next;           // index of the next use in m_use_pos
+        std::vector<Reg>      m_where;          // physical register, or NoReg
+        std::vector<LabelId>  m_slot;           // spill slot, or NoLabel
+        std::vector<uint8_t>  m_stored;         // spill slot holds the value
+        std::vector<LabelId>  m_free_slots;     // of values past their last use
+        std::vector<uint8_t>  m_hint;           // preferred physical register, 0 if none
+        std::vector<uint8_t>  m_avoid;          // mask of registers it must not get
+
+        std::array<Reg, lc2k::NumRegs> m_holder;    // virtual register in each physical one
+        bool      m_link_used = false;
+        SourceLoc m_loc       = NoLoc;         // of the instruction being allocated
+
+        void     _analyse    ();
+        void     _instruction(uint32_t pos);
+        void     _save_link  ();
+
+        uint32_t _next_use   (Reg v) const;
+        bool     _remat      (Reg v) const;
+        Reg      _pick       (uint32_t pos, uint8_t excluded, uint8_t hint);
+        void     _evict      (Reg phys);
+        LabelId  _slot       ();
+        LabelId  _new_label  (LabelKind kind);
+        void     _reload     (Reg v, Reg phys);
+        void     _emit       (const MInstr& instr);     // stamps m_loc
+    };
+
+    MProgram&              m_program;
+    ThreadPool*            m_pool;
+    std::vector<Allocator> m_allocators;
+
+    size_t _sum(size_t Allocator::*counter) const;
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+#include "lc2k.hpp"
+
+/*
+ * Why a run stopped. X(name, description).
+ */
+#define LCC_SIM_STATUSES(X)                              \
+    X(Halted,     "halted")                              \
+    X(StepLimit,  "stopped at the instruction limit")    \
+    X(BadPc,      "pc out of range")                     \
+    X(BadAddress, "lw/sw address out of range")
+
+#define LCC_SIM_STATUS_ENUM(name, str) name,
+
+enum class RunStatus : uint8_t {
+    LCC_SIM_STATUSES(LCC_SIM_STATUS_ENUM)
+};
+
+#undef LCC_SIM_STATUS_ENUM
+
+#define LCC_SIM_STATUS_STRING(name, str) case RunStatus::name: return str;
+
+inline const char* to_string(RunStatus status) {
+    switch (status) {
+        LCC_SIM_STATUSES(LCC_SIM_STATUS_STRING)
+    }
+    return "?";
+}
+
+#undef LCC_SIM_STATUS_STRING
+
+/*
+ * Runs an LC2K memory image (see Assembler) in-process.
+ *
+ * Every word of memory is decoded once up front, and again only
+ * when sw overwrites it, so the dispatch loop never looks at
+ * encoded instructions. With GCC / Clang the loop is threaded:
+ * each handler ends in its own indirect jump through a table of
+ * label addresses (computed goto), which predicts far better than
+ * one shared switch. Other compilers get the switch.
+ *
+ * The machine is as EECS370 specifies it: registers and memory
+ * start at 0 apart from the image, execution starts at address 0,
+ * and r0 is an ordinary register (the code generator never
+ * writes it).
+ *
+ * profile() runs the same loop but also counts executions per
+ * address and per calling context. Calls and returns are told
+ * apart by the code generator's conventions (lc2k.hpp): a jalr
+ * linking into r7 calls, `jalr 7 6` returns. Contexts form a tree
+ * rooted at the code entered at address 0; each counts the
+ * instructions run in it, not in its callees. Past MaxDepth
+ * nested calls (runaway recursion) deeper calls stay in the
+ * deepest context.
+ */
+class Simulator {
+public:
+    using Counts    = std::array<uint64_t, 8>;              // per opcode, in encoding order
+    using Registers = std::array<int32_t, lc2k::NumRegs>;
+
+    struct Context {
+        uint32_t parent;            // index into contexts(); the root is its own parent
+        uint32_t entry;             // address called, 0 for the root
+        uint64_t self;              // instructions run in it, callees excluded
+    };
+
+    static constexpr uint32_t MaxDepth = 256;
+
+    explicit Simulator(const std::vector<int32_t>& image);
+
+    /* Runs from the current pc for at most max_steps instructions. */
+    RunStatus run    (uint64_t max_steps = UINT64_MAX);
+    RunStatus profile(uint64_t max_steps = UINT64_MAX);
+
+    uint64_t         instructions() const;                  // executed so far
+    const Counts&    counts()       const { return this->m_counts; }
+    const Registers& registers()    const { return this->m_regs; }
+    uint32_t         pc()           const { return this->m_pc; }
+    RunStatus        status()       const { return this->m_status; }
+
+    /* What profile() runs counted: per address, and per calling context. */
+    const std::vector<uint64_t>& hits()     const { return this->m_hits; }
+    const std::vector<Context>&  contexts() const { return this->m_contexts; }
+
+    /* Status, instruction count, per-opcode counts and registers. */
+    void report(std::ostream& os) const;
+
+private:
+    struct Decoded {
+        uint8_t op, a, b, d;
+        int32_t offset;             // sign-extended
+    };
+
+    std::vector<int32_t> m_memory;
+    std::vector<Decoded> m_decoded;  // per memory word
+    Registers            m_regs {};
+    Counts               m_counts {};
+    uint32_t             m_pc = 0;
+    RunStatus            m_status = RunStatus::Halted;
+
+    /* Profiling state. */
+    std::vector<uint64_t> m_hits;                         // per address
+    std::vector<Context>  m_contexts;
+    std::unordered_map<uint64_t, uint32_t> m_children;    // (context, entry) -> context
+    uint32_t              m_context  = 0;
+    uint32_t              m_depth    = 0;
+    uint32_t              m_overflow = 0;                 // calls past MaxDepth not yet returned
+
+    template <bool Profiled>
+    RunStatus _run(uint64_t max_steps);
+
+    void _call  (uint32_t entry);
+    void _return();
+
+    static Decoded _decode(int32_t word);
+};
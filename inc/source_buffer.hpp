@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <optional>
+#include <cstddef>
+
+/*
+ * Read-only view of an LC source file.
+ *
+ * Regular files are memory-mapped, so tokens produced from
+ * view() can point straight into the mapping without copying.
+ * Inputs that cannot be mapped (pipes, empty files, in-memory
+ * sources) fall back to an owned std::string.
+ *
+ * The buffer must outlive every Token taken from it.
+ */
+class SourceBuffer {
+public:
+    /* Maps (or reads) the file at path. Returns nullopt on failure. */
+    static std::optional<SourceBuffer> open(const std::string& path);
+
+    /* Wraps an in-memory source. */
+    static SourceBuffer from_string(std::string src);
+
+    SourceBuffer(SourceBuffer&&) noexcept;
+    SourceBuffer& operator=(SourceBuffer&&) noexcept;
+
+    SourceBuffer(const SourceBuffer&)            = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+    ~SourceBuffer();
+
+    std::string_view view() const { return {this->m_data, this->m_size}; }
+    size_t           size() const { return this->m_size; }
+    bool             is_mapped() const { return this->m_map != nullptr; }
+
+private:
+    SourceBuffer() = default;
+
+    const char* m_data = nullptr;
+    size_t      m_size = 0;
+
+    void*       m_map  = nullptr;   // mmap base, or nullptr if owned
+    std::string m_owned;            // fallback storage
+
+    void _release();
+};
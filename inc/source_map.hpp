@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "interner.hpp"
+
+/* A byte offset into the source file (see Token::offset). */
+using SourceLoc = uint32_t;
+
+inline constexpr SourceLoc NoLoc = UINT32_MAX;
+
+/*
+ * Line starts of a source, built in one pass over its text, for
+ * turning SourceLocs into 1-based line and column numbers. The
+ * text must outlive the map.
+ */
+class LineMap {
+public:
+    struct Position {
+        uint32_t line;
+        uint32_t column;
+    };
+
+    explicit LineMap(std::string_view src);
+
+    Position         position (SourceLoc loc) const;
+    std::string_view line_text(uint32_t line) const;     // without the newline
+    size_t           lines    () const { return this->m_starts.size(); }
+
+private:
+    std::string_view      m_src;
+    std::vector<uint32_t> m_starts;         // offset of each line's first byte
+};
+
+/*
+ * Where the code at each address of an assembled program came
+ * from (Assembler::source_map()).
+ *
+ * Locations are stored as runs: a run covers its address up to
+ * the next run's, so the instructions of one statement cost one
+ * entry. The jump at 0 and the data after it (see Layout) have
+ * no location, nor do addresses past code_end. Functions are
+ * listed by address; the top-level code's range starts at 0, over
+ * the jump and the data, and has no name.
+ */
+struct SourceMap {
+    struct Run {
+        uint32_t  address;
+        SourceLoc loc;
+    };
+
+    struct Function {
+        uint32_t begin;                     // [begin, end)
+        uint32_t end;
+        SymbolId name;                      // NoSymbol for the top-level code
+    };
+
+    std::vector<Run>      runs;
+    std::vector<Function> functions;
+    uint32_t              code_end = 0;
+
+    /* Appends a run unless loc continues the last one. */
+    void add(uint32_t address, SourceLoc loc);
+
+    SourceLoc       loc     (uint32_t address) const;  // NoLoc for data
+    const Function* function(uint32_t address) const;  // nullptr for data
+};
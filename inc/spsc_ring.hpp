@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Bounded lock-free single-producer/single-consumer ring.
+ *
+ * head and tail are free-running counters on separate cache
+ * lines; each side caches the other's counter and only re-reads
+ * it when the ring looks full (producer) or empty (consumer).
+ *
+ * The blocking push()/pop() sleep on the counters with C++20
+ * atomic wait/notify, which gives the producer back-pressure.
+ * The top bit of each counter is a flag: on tail it means the
+ * producer has closed the ring, on head that the consumer has
+ * gone away (so a blocked producer can give up).
+ */
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+
+    static constexpr size_t Mask     = Capacity - 1;
+    static constexpr size_t FlagBit  = size_t(1) << (sizeof(size_t) * 8 - 1);
+
+public:
+    /* Producer: copies as many of items as fit; never blocks. */
+    size_t try_push(const T* items, size_t count) {
+        size_t tail = this->m_tail.load(std::memory_order_relaxed) & ~FlagBit;
+
+        if (Capacity - (tail - this->m_head_cache) < count)
+            this->m_head_cache = this->m_head.load(std::memory_order_acquire) & ~FlagBit;
+
+        count = std::min(count, Capacity - (tail - this->m_head_cache));
+        for (size_t i = 0; i < count; i++)
+            this->m_items[(tail + i) & Mask] = items[i];
+
+        if (count) {
+            this->m_tail.store(tail + count, std::memory_order_release);
+            this->m_tail.notify_one();
+        }
+        return count;
+    }
+
+    /* Consumer: takes up to max items; never blocks. */
+    size_t try_pop(T* out, size_t max) {
+        size_t head = this->m_head.load(std::memory_order_relaxed) & ~FlagBit;
+
+        if (this->m_tail_cache - head < max)
+            this->m_tail_cache = this->m_tail.load(std::memory_order_acquire) & ~FlagBit;
+
+        size_t count = std::min(max, this->m_tail_cache - head);
+        for (size_t i = 0; i < count; i++)
+            out[i] = this->m_items[(head + i) & Mask];
+
+        if (count) {
+            this->m_head.store(head + count, std::memory_order_release);
+            this->m_head.notify_one();
+        }
+        return count;
+    }
+
+    /* Producer: pushes all items, waiting for room. False if the consumer cancelled. */
+    bool push(const T* items, size_t count) {
+        while (true) {
+            size_t pushed = this->try_push(items, count);
+            items += pushed;
+            count -= pushed;
+            if (!count)
+                return true;
+
+            size_t head = this->m_head.load(std::memory_order_acquire);
+            if (head & FlagBit)
+                return false;
+            if (head == this->m_head_cache)
+                this->m_head.wait(head, std::memory_order_acquire);
+        }
+    }
+
+    /* Consumer: waits for at least one item. 0 once the ring is closed and drained. */
+    size_t pop(T* out, size_t max) {
+        while (true) {
+            if (size_t count = this->try_pop(out, max))
+                return count;
+
+            size_t tail = this->m_tail.load(std::memory_order_acquire);
+            if (tail & FlagBit)
+                return this->try_pop(out, max);
+            if (tail == this->m_tail_cache)
+                this->m_tail.wait(tail, std::memory_order_acquire);
+        }
+    }
+
+    /* Producer: no more items will be pushed. */
+    void close() {
+        this->m_tail.fetch_or(FlagBit, std::memory_order_release);
+        this->m_tail.notify_one();
+    }
+
+    /* Consumer: stop wanting items; unblocks the producer. */
+    void cancel() {
+        this->m_head.fetch_or(FlagBit, std::memory_order_release);
+        this->m_head.notify_one();
+    }
+
+private:
+    alignas(64) std::atomic<size_t> m_head {0};
+    size_t                          m_tail_cache = 0;   // consumer's view of tail
+
+    alignas(64) std::atomic<size_t> m_tail {0};
+    size_t                          m_head_cache = 0;   // producer's view of head
+
+    alignas(64) std::array<T, Capacity> m_items;
+};
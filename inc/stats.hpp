@@ -0,0 +1,114 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/*
+ * Per-phase compile statistics: wall time, allocation count and
+ * bytes allocated, plus named counters (tokens, nodes, ...).
+ *
+ * A phase is registered the first time a PhaseTimer runs for it
+ * and phases are reported in that order; running the same phase
+ * again accumulates. Time and allocations are exclusive: while a
+ * nested phase runs, nothing is charged to the enclosing one, so
+ * the lexer pulled from inside the parser is reported on its own.
+ *
+ * Allocations are counted by the global operator new in
+ * stats.cpp, from every thread, and charged to whatever phase the
+ * main thread is in. Phases and counters are main-thread only:
+ * PhaseTimers on other threads (the pool compiling several files)
+ * do nothing, and the main thread can pause() its own while it
+ * runs jobs for the pool.
+ *
+ * Until enable() is called PhaseTimer does nothing and the
+ * allocator hook costs one relaxed load per allocation.
+ *
+ * Phase and counter names must be string literals (or otherwise
+ * outlive the Stats object); they are stored as views.
+ */
+class Stats {
+public:
+    enum class Format { Text, Json };
+
+    struct Counter {
+        std::string_view name;
+        uint64_t         value;
+    };
+
+    struct Phase {
+        std::string_view     name;
+        double               seconds = 0;
+        uint64_t             allocs  = 0;
+        uint64_t             bytes   = 0;
+        std::vector<Counter> counters;
+    };
+
+    static Stats& global();
+
+    void enable();
+    bool enabled() const { return this->m_enabled; }
+
+    /* Disables and forgets every phase, for a process (lcc --server) that reports more than once. */
+    void reset();
+
+    /* Enabled, on the thread that called enable(), and not paused. */
+    bool recording() const {
+        return this->m_enabled && std::this_thread::get_id() == this->m_owner && !this->m_paused;
+    }
+
+    void pause () { this->m_paused = true;  }
+    void resume() { this->m_paused = false; }
+
+    /* Prefer PhaseTimer over calling these directly. */
+    void enter(std::string_view phase);
+    void leave();
+
+    /* Adds value to phase's counter, registering either if new. */
+    void count(std::string_view phase, std::string_view counter, uint64_t value);
+
+    const std::vector<Phase>& phases() const { return this->m_phases; }
+
+    void report(std::ostream& os, Format format) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    bool                m_enabled = false;
+    bool                m_paused  = false;
+    std::thread::id     m_owner;
+    std::vector<Phase>  m_phases;
+    std::vector<size_t> m_stack;            // active phases, indices into m_phases
+
+    /* Totals at the last enter()/leave(), charged to the top of m_stack. */
+    Clock::time_point   m_mark;
+    uint64_t            m_mark_allocs = 0;
+    uint64_t            m_mark_bytes  = 0;
+
+    size_t _phase (std::string_view name);
+    void   _charge();
+};
+
+/* Charges the enclosing scope to phase (when stats are enabled). */
+class PhaseTimer {
+public:
+    explicit PhaseTimer(std::string_view phase)
+        : m_active(Stats::global().recording()) {
+        if (this->m_active)
+            Stats::global().enter(phase);
+    }
+
+    ~PhaseTimer() {
+        if (this->m_active)
+            Stats::global().leave();
+    }
+
+    PhaseTimer(const PhaseTimer&)            = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+    bool m_active;
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include "interner.hpp"
+
+/*
+ * Scoped map from SymbolId to a declaration (Decl is typically
+ * a node pointer or a small slot index).
+ *
+ * Each scope is a flat open-addressing table keyed directly by
+ * the id, so a lookup is a few integer compares per scope. Popped
+ * scopes keep their storage and are reused by the next push.
+ */
+template <typename Decl>
+class SymbolTable {
+    static_assert(std::is_trivially_copyable_v<Decl>);
+
+public:
+    SymbolTable() { this->push_scope(); }   // global scope
+
+    void push_scope() {
+        if (this->m_depth == this->m_scopes.size())
+            this->m_scopes.emplace_back();
+        this->m_scopes[this->m_depth++].clear();
+    }
+
+    void pop_scope() {
+        assert(this->m_depth > 1 && "Cannot pop the global scope");
+        this->m_depth--;
+    }
+
+    size_t depth() const { return this->m_depth; }
+
+    /* Declares id in the innermost scope. False if it is already declared there. */
+    bool declare(SymbolId id, Decl decl) {
+        return this->m_scopes[this->m_depth - 1].insert(id, decl);
+    }
+
+    /* Innermost declaration of id, searching outwards. */
+    std::optional<Decl> lookup(SymbolId id) const {
+        for (size_t i = this->m_depth; i-- > 0; ) {
+            if (auto* decl = this->m_scopes[i].find(id))
+                return *decl;
+        }
+        return std::nullopt;
+    }
+
+    /* Declaration of id in the innermost scope only. */
+    std::optional<Decl> lookup_local(SymbolId id) const {
+        if (auto* decl = this->m_scopes[this->m_depth - 1].find(id))
+            return *decl;
+        return std::nullopt;
+    }
+
+private:
+    struct Scope {
+        struct Slot {
+            SymbolId id = NoSymbol;
+            Decl     decl {};
+        };
+
+        std::vector<Slot> slots;
+        size_t            count = 0;
+
+        void clear() {
+            if (this->count)
+                std::fill(this->slots.begin(), this->slots.end(), Slot {});
+            this->count = 0;
+        }
+
+        const Decl* find(SymbolId id) const {
+            if (this->count == 0)
+                return nullptr;
+
+            size_t mask = this->slots.size() - 1;
+            for (size_t i = id & mask; ; i = (i + 1) & mask) {
+                if (this->slots[i].id == id)       return &this->slots[i].decl;
+                if (this->slots[i].id == NoSymbol) return nullptr;
+            }
+        }
+
+        bool insert(SymbolId id, Decl decl) {
+            if ((this->count + 1) * 2 > this->slots.size())
+                this->_grow();
+
+            size_t mask = this->slots.size() - 1;
+            for (size_t i = id & mask; ; i = (i + 1) & mask) {
+                if (this->slots[i].id == id)
+                    return false;
+                if (this->slots[i].id == NoSymbol) {
+                    this->slots[i] = Slot {id, decl};
+                    this->count++;
+                    return true;
+                }
+            }
+        }
+
+        void _grow() {
+            std::vector<Slot> old = std::move(this->slots);
+            this->slots.assign(old.empty() ? 16 : old.size() * 2, Slot {});
+            this->count = 0;
+
+            for (auto& slot : old) {
+                if (slot.id != NoSymbol)
+                    this->insert(slot.id, slot.decl);
+            }
+        }
+    };
+
+    std::vector<Scope> m_scopes;
+    size_t             m_depth = 0;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "lc2k.hpp"
+
+/*
+ * A stand-alone assembler for LC2K assembly text in the EECS370
+ * format, the one AsmWriter writes:
+ *
+ *   [label] <white> opcode <white> fields... [<white> comment]
+ *
+ * A label starts in the first column; labels are resolved in a
+ * second pass over the parsed lines. Numeric fields are decimal.
+ * lw/sw offsets and `.fill` values may name labels (the label's
+ * address); a beq label is relative to the next instruction.
+ *
+ * lcc never needs it to produce code: Assembler encodes an
+ * MProgram directly. It is the reference that path is checked
+ * against (`lcc --mc=check`), going through the text like a
+ * separate assembler would.
+ *
+ * Throws std::runtime_error("Assembler error: line N: ...").
+ */
+class TextAssembler {
+public:
+    explicit TextAssembler(std::string_view text)
+        : m_text(text) {}
+
+    std::vector<int32_t> assemble();
+
+private:
+    struct Line {
+        uint32_t                        number;     // 1-based, for errors
+        std::string_view                op;
+        std::array<std::string_view, 3> fields;
+        int                             count;      // fields present
+    };
+
+    std::string_view                               m_text;
+    std::vector<Line>                              m_lines;
+    std::unordered_map<std::string_view, uint32_t> m_labels;   // address of each
+
+    void     _parse ();
+    int32_t  _encode(const Line& line, uint32_t pc) const;
+    uint32_t _reg   (const Line& line, int field) const;
+    int64_t  _value (const Line& line, int field, bool* named = nullptr) const;    // number or label address
+
+    [[noreturn]] static void _error(uint32_t line, const std::string& msg);
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Work-stealing pool for independent jobs (lcc runs one per input
+ * file, and the backend one per function; see parallel_for()).
+ *
+ * Each worker has its own deque of tasks; threads that are not
+ * workers share one more. run(count, job) pushes job(0) ...
+ * job(count - 1) onto the calling thread's deque and works until
+ * all of them have finished: a thread takes its own newest task
+ * first and, when its deque is empty, steals the oldest task of
+ * another. Idle workers steal the same way, so the jobs queued
+ * behind one long job are taken by whichever threads are free.
+ *
+ * A job may call run() itself. While waiting, a caller keeps
+ * running queued tasks (its own or stolen), so nested parallelism
+ * never blocks a thread that could make progress.
+ *
+ * Jobs should report their own errors; if one throws anyway, the
+ * others still run and run() rethrows the first exception.
+ */
+class ThreadPool {
+public:
+    /* threads counts the caller of run(): a pool of 1 runs jobs inline. */
+    explicit ThreadPool(size_t threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&)            = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void run(size_t count, const std::function<void(size_t)>& job);
+
+    size_t threads() const { return this->m_workers.size() + 1; }
+    size_t steals () const { return this->m_steals.load(std::memory_order_relaxed); }
+
+    /* One thread per hardware thread the machine reports (at least 1). */
+    static size_t hardware_threads();
+
+private:
+    struct Batch;
+
+    struct Task {
+        Batch* batch;
+        size_t index;
+    };
+
+    struct alignas(64) Queue {
+        std::mutex       mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> m_queues;       // [0] for outside threads, then one per worker
+    std::vector<std::thread>            m_workers;
+
+    std::mutex              m_mutex;                    // guards sleeping, not the queues
+    std::condition_variable m_wake;                     // work queued, a batch finished, or stopping
+    std::atomic<size_t>     m_queued {0};               // tasks in any deque
+    std::atomic<size_t>     m_steals {0};
+    bool                    m_stop = false;
+
+    size_t _self   () const;                            // the calling thread's deque
+    bool   _take   (size_t self, Task& task);
+    void   _execute(const Task& task);
+    void   _worker (size_t self);
+};
+
+/*
+ * Runs job(slot, i) for every i in [0, count): on pool, as up to
+ * pool->threads() tasks that each take the next index in turn, or
+ * in order on the calling thread when pool is null. Running jobs
+ * never share a slot (< slots(pool)), so a pass can keep scratch
+ * state per slot instead of per index.
+ */
+void parallel_for(ThreadPool* pool, size_t count, const std::function<void(size_t slot, size_t index)>& job);
+
+inline size_t slots(const ThreadPool* pool) {
+    return pool ? pool->threads() : 1;
+}
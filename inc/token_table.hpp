@@ -0,0 +1,191 @@
+#pragma once
+
+#include <array>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+#include "token_type.hpp"
+
+/*
+ * Compile-time keyword and symbol classifiers.
+ *
+ * Both tables are built by constexpr code from the token lists
+ * in token_type.hpp, so nothing is constructed at startup and
+ * the Tokenizer never builds or hashes a std::string:
+ *
+ *  - Words (keywords, data types) go through a perfect hash on
+ *    (length, first two chars, last char) followed by a single
+ *    compare. The seed is searched for at compile time.
+ *
+ *  - Symbols (operators, breaks) are matched longest-first by
+ *    a small DFA built from the spellings.
+ *
+ * Being constexpr, the tables are read-only data: Tokenizers on
+ * any number of threads share them without synchronisation.
+ */
+namespace token_table {
+
+struct Spelling {
+    std::string_view text;
+    TokenType        type;
+};
+
+#define LCC_TOKEN_SPELLING(name, spelling) Spelling {spelling, name},
+
+inline constexpr std::array Words {
+    LCC_KEYWORD_TOKENS  (LCC_TOKEN_SPELLING)
+    LCC_DATA_TYPE_TOKENS(LCC_TOKEN_SPELLING)
+};
+
+inline constexpr std::array Symbols {
+    LCC_OPERATOR_TOKENS(LCC_TOKEN_SPELLING)
+    LCC_BREAK_TOKENS   (LCC_TOKEN_SPELLING)
+};
+
+#undef LCC_TOKEN_SPELLING
+
+/* ---- Words: perfect hash ---- */
+
+constexpr size_t _bit_ceil(size_t n) {
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+constexpr size_t _log2(size_t n) {
+    size_t b = 0;
+    while ((size_t(1) << b) < n) ++b;
+    return b;
+}
+
+inline constexpr size_t WordSlots = _bit_ceil(Words.size() * 2);
+inline constexpr size_t WordBits  = _log2(WordSlots);
+
+constexpr size_t _min_word_len() {
+    size_t n = Words[0].text.size();
+    for (auto& w : Words) n = w.text.size() < n ? w.text.size() : n;
+    return n;
+}
+
+constexpr size_t _max_word_len() {
+    size_t n = 0;
+    for (auto& w : Words) n = w.text.size() > n ? w.text.size() : n;
+    return n;
+}
+
+inline constexpr size_t MinWordLen = _min_word_len();
+inline constexpr size_t MaxWordLen = _max_word_len();
+
+constexpr uint32_t word_hash(std::string_view s, uint32_t seed) {
+    uint32_t h = static_cast<uint32_t>(s.size());
+    h = h * 31 + static_cast<unsigned char>(s[0]);
+    h = h * 31 + static_cast<unsigned char>(s[s.size() > 1 ? 1 : 0]);
+    h = h * 31 + static_cast<unsigned char>(s[s.size() - 1]);
+    return (h * seed) >> (32 - WordBits);
+}
+
+constexpr bool _is_perfect(uint32_t seed) {
+    std::array<bool, WordSlots> used {};
+    for (auto& w : Words) {
+        auto slot = word_hash(w.text, seed);
+        if (used[slot]) return false;
+        used[slot] = true;
+    }
+    return true;
+}
+
+constexpr uint32_t _find_seed() {
+    for (uint32_t seed = 0x9E3779B1u; seed < 0x9E3779B1u + 200000; seed += 2) {
+        if (_is_perfect(seed))
+            return seed;
+    }
+    return 0;
+}
+
+inline constexpr uint32_t WordSeed = _find_seed();
+
+static_assert(WordSeed != 0,
+              "No perfect hash seed for the keyword set; widen word_hash().");
+
+constexpr std::array<Spelling, WordSlots> _build_word_table() {
+    std::array<Spelling, WordSlots> table {};
+    for (auto& slot : table) slot = Spelling {"", m_ident};
+    for (auto& w : Words) table[word_hash(w.text, WordSeed)] = w;
+    return table;
+}
+
+inline constexpr auto WordTable = _build_word_table();
+
+/* Keyword / data type for word, or m_ident if it is a plain identifier. */
+constexpr TokenType classify_word(std::string_view word) {
+    if (word.size() < MinWordLen || word.size() > MaxWordLen)
+        return m_ident;
+
+    auto& entry = WordTable[word_hash(word, WordSeed)];
+    return entry.text == word ? entry.type : m_ident;
+}
+
+/* ---- Symbols: longest-match DFA ---- */
+
+constexpr size_t _symbol_states() {
+    size_t n = 1;
+    for (auto& s : Symbols) n += s.text.size();
+    return n;
+}
+
+struct SymbolDfa {
+    static constexpr size_t States = _symbol_states();
+
+    /* next[state][ch] == 0 means no transition (state 0 is the start). */
+    std::array<std::array<uint8_t, 256>, States> next {};
+    std::array<TokenType, States>                accept {};
+};
+
+static_assert(SymbolDfa::States < 256, "Symbol DFA state does not fit in uint8_t");
+
+constexpr SymbolDfa _build_symbol_dfa() {
+    SymbolDfa dfa {};
+    for (auto& a : dfa.accept) a = m_unknown;
+
+    uint8_t states = 1;
+    for (auto& sym : Symbols) {
+        uint8_t state = 0;
+        for (char c : sym.text) {
+            auto& edge = dfa.next[state][static_cast<unsigned char>(c)];
+            if (!edge) edge = states++;
+            state = edge;
+        }
+        dfa.accept[state] = sym.type;
+    }
+    return dfa;
+}
+
+inline constexpr SymbolDfa SymbolMachine = _build_symbol_dfa();
+
+struct SymbolMatch {
+    TokenType type;
+    size_t    length;    // 0 if nothing matched
+};
+
+/* Longest symbol that prefixes src. */
+constexpr SymbolMatch match_symbol(std::string_view src) {
+    SymbolMatch best {m_unknown, 0};
+    uint8_t state = 0;
+
+    for (size_t i = 0; i < src.size(); i++) {
+        state = SymbolMachine.next[state][static_cast<unsigned char>(src[i])];
+        if (!state) break;
+        if (SymbolMachine.accept[state] != m_unknown)
+            best = {SymbolMachine.accept[state], i + 1};
+    }
+    return best;
+}
+
+/* The tables are fully evaluated at compile time. */
+static_assert(classify_word("let")  == k_let);
+static_assert(classify_word("lets") == m_ident);
+static_assert(match_symbol("==").type == o_equal_equal);
+static_assert(match_symbol("=1").length == 1);
+
+} // namespace token_table
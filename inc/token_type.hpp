@@ -1,81 +1,115 @@
 #pragma once
 
+/*
+ * Every token kind is listed exactly once, in the groups below.
+ * The TokenType enum, to_string() and the Tokenizer's keyword
+ * and symbol classifiers (token_table.hpp) are all generated
+ * from these lists, so adding a keyword or operator here is
+ * all it takes for the lexer to recognise it.
+ *
+ * X(name, spelling) -- spelling is "" for tokens without a
+ * fixed spelling (literals, identifiers, ...).
+ */
+
+/* Keywords. */
+#define LCC_KEYWORD_TOKENS(X)                                         \
+    X(k_exit,        "exit")  /* 'exit' keyword, e.g. exit(0)      */ \
+    X(k_func,        "fn")    /* 'fn'   keyword, e.g. fn [name] ... */ \
+    X(k_let,         "let")                                           \
+    X(k_if,          "if")
+
+/* Operators */
+#define LCC_OPERATOR_TOKENS(X)                                        \
+    X(o_plus,        "+")                                             \
+    X(o_sub,         "-")                                             \
+    X(o_equal,       "=")                                             \
+    X(o_equal_equal, "==")
+
+/* Data Types. */
+#define LCC_DATA_TYPE_TOKENS(X)                                       \
+    X(d_int,         "int")
+
+/* Literals. */
+#define LCC_LITERAL_TOKENS(X)                                         \
+    X(l_int,         "")                                              \
+    X(l_float,       "")
+
+/* Misc. */
+#define LCC_MISC_TOKENS(X)                                            \
+    X(m_ident,       "")                                              \
+    X(m_keybreak,    "")                                              \
+    X(m_unknown,     "")                                              \
+    X(m_eof,         "")      /* end of input, never stored in the AST */
+
+/* Token breaks. */
+#define LCC_BREAK_TOKENS(X)                                           \
+    X(b_lparen,      "(")                                             \
+    X(b_rparen,      ")")                                             \
+    X(b_colon,       ":")                                             \
+    X(b_semi,        ";")                                             \
+    X(b_left_curl,   "{")                                             \
+    X(b_right_curl,  "}")                                             \
+    X(b_comma,       ",")
+
+#define LCC_TOKEN_ENUM(name, spelling) name,
+
 enum TokenType {
-    /* Keywords. */
     _K_TYPE_BEGIN,
-    k_exit,             /* 'exit' keyword, e.g. exit(0) */
-    k_func,             /* 'fn'   keyword, e.g. fn [name] ... */
-    k_let,
-    k_if,
+    LCC_KEYWORD_TOKENS(LCC_TOKEN_ENUM)
     _K_TYPE_END,
 
-    /* Operators */
     _O_TYPE_BEGIN,
-    o_plus,
-    o_sub,
-    o_equal,
-    o_equal_equal,
+    LCC_OPERATOR_TOKENS(LCC_TOKEN_ENUM)
     _O_TYPE_END,
 
-    /* Data Types. */
     _D_TYPE_BEGIN,
-    d_int,
+    LCC_DATA_TYPE_TOKENS(LCC_TOKEN_ENUM)
     _D_TYPE_END,
 
-    /* Literals. */
     _L_TYPE_BEGIN,
-    l_int,
-    l_float,
+    LCC_LITERAL_TOKENS(LCC_TOKEN_ENUM)
     _L_TYPE_END,
 
-    /* Misc. */
     _M_TYPE_BEGIN,
-    m_ident,
-    m_keybreak,
-    m_unknown,
+    LCC_MISC_TOKENS(LCC_TOKEN_ENUM)
     _M_TYPE_END,
 
-    /* Token breaks. */
     _B_TYPE_BEGIN,
-    b_lparen,
-    b_rparen,
-    b_colon,
-    b_semi,
-    b_left_curl,
-    b_right_curl,
-    b_comma,
+    LCC_BREAK_TOKENS(LCC_TOKEN_ENUM)
     _B_TYPE_END
 };
 
+#undef LCC_TOKEN_ENUM
+
+#define LCC_TOKEN_NAME_CASE(name, spelling) case name: return #name;
+
 inline const char* to_string(TokenType type) {
     switch (type) {
-        case k_exit:        return "k_exit";
-        case k_func:        return "k_func";
-        case k_let:         return "k_let";
-        case k_if:          return "k_if";
-
-        case o_plus:        return "o_plus";
-        case o_sub:         return "o_sub";
-        case o_equal:       return "o_equal";
-        case o_equal_equal: return "o_equal_equal";
+        LCC_KEYWORD_TOKENS  (LCC_TOKEN_NAME_CASE)
+        LCC_OPERATOR_TOKENS (LCC_TOKEN_NAME_CASE)
+        LCC_DATA_TYPE_TOKENS(LCC_TOKEN_NAME_CASE)
+        LCC_LITERAL_TOKENS  (LCC_TOKEN_NAME_CASE)
+        LCC_MISC_TOKENS     (LCC_TOKEN_NAME_CASE)
+        LCC_BREAK_TOKENS    (LCC_TOKEN_NAME_CASE)
 
-        case d_int:         return "d_int";
+        default:            return "unknown_token_type";
+    }
+}
 
-        case l_int:         return "l_int";
-        case l_float:       return "l_float";
+#undef LCC_TOKEN_NAME_CASE
 
-        case m_ident:       return "m_ident";
-        case m_keybreak:    return "m_keybreak";
-        case m_unknown:     return "m_unknown";
+#define LCC_TOKEN_SPELLING_CASE(name, spelling) case name: return spelling;
 
-        case b_lparen:      return "b_lparen";
-        case b_rparen:      return "b_rparen";
-        case b_colon:       return "b_colon";
-        case b_semi:        return "b_semi";
-        case b_left_curl:   return "b_left_curl";
-        case b_right_curl:  return "b_right_curl";
-        case b_comma:       return "b_comma";
+/* Source spelling of keywords, operators and breaks; "" otherwise. */
+inline const char* to_spelling(TokenType type) {
+    switch (type) {
+        LCC_KEYWORD_TOKENS  (LCC_TOKEN_SPELLING_CASE)
+        LCC_OPERATOR_TOKENS (LCC_TOKEN_SPELLING_CASE)
+        LCC_DATA_TYPE_TOKENS(LCC_TOKEN_SPELLING_CASE)
+        LCC_BREAK_TOKENS    (LCC_TOKEN_SPELLING_CASE)
 
-        default:            return "unknown_token_type";
+        default:            return "";
     }
 }
+
+#undef LCC_TOKEN_SPELLING_CASE
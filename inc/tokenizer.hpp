@@ -1,10 +1,9 @@
 #pragma once
 
 #include <fstream>
+#include <string_view>
 #include <vector>
 #include <optional>
-#include <unordered_set>
-#include <unordered_map>
 #include <iostream>
 #include <cstdint>
 #include <cctype>
@@ -12,20 +11,48 @@
 #include <cassert>
 
 #include "token_type.hpp"
+#include "token_table.hpp"
+#include "interner.hpp"
 
+/*
+ * A Token does not own its text: value points into the
+ * source buffer handed to the Tokenizer, so the buffer
+ * must outlive every token taken from it.
+ *
+ * Identifiers (m_ident) also carry their interned SymbolId.
+ * offset is where value starts in the source, in bytes.
+ */
 struct Token {
-    std::string value;
+    std::string_view value;
     TokenType type;
+    SymbolId symbol = NoSymbol;
+    uint32_t offset = 0;
 
     explicit operator bool() const {
         return !value.empty();
     }
 };
 
-class Tokenizer {
+/*
+ * Anything the Parser can pull tokens from. Tokens are handed
+ * over in batches so the per-token cost of the indirection is
+ * amortised.
+ */
+class TokenSource {
 public:
-    explicit Tokenizer(std::string src) 
-        : m_src(std::move(src)) {}
+    virtual ~TokenSource() = default;
+
+    /* Writes up to max tokens to out; returns 0 once input is exhausted. */
+    virtual size_t read_tokens(Token* out, size_t max) = 0;
+};
+
+class Tokenizer : public TokenSource {
+public:
+    explicit Tokenizer(std::string_view src)
+        : m_src(src) {}
+
+    /* Batched tokenizer: pull up to max tokens (TokenSource). */
+    size_t read_tokens(Token* out, size_t max) override;
 
     /* Batch tokenizer: consumes all tokens. */
     std::vector<Token> tokenize();
@@ -38,11 +65,7 @@ public:
     void reset();
 
 private:
-    // keyword and symbol tables
-    static std::unordered_map<std::string, TokenType> m_keywords;
-    static std::unordered_map<std::string, TokenType> m_keybreak;
-
-    std::string m_src;
+    std::string_view m_src;
     size_t m_pos = 0;               // char position in source
     std::optional<Token> m_peeked;    // cache for peeked token
 
@@ -50,19 +73,19 @@ private:
     inline std::optional<char> peek(uint32_t offset = 0);
     inline std::optional<char> consume();
 
-    std::optional<std::string> read_token();
-    std::optional<TokenType>   classify_token(const std::string&);
+    /* Scans and classifies the next token in one pass. */
+    std::optional<Token> read_token();
 
     /* Tokenizer internals. */
-    inline TokenType   _get_keyword       (const std::string);
-    inline void        _consume_whitespace();
-    inline std::string _parse_number      ();
-    inline std::string _parse_alpha       ();
-    inline std::string _parse_symbol      ();
+    inline void  _consume_whitespace();
+    inline Token _parse_number      ();
+    inline Token _parse_alpha       ();
+    inline Token _parse_symbol      ();
+
+    /* Position just past the run starting at m_pos (see char_scan.hpp). */
+    inline size_t _scan_to(const char* (*skip)(const char*, const char*));
 
     /* Helpers */
     inline bool __is_alpha     (char c);
     inline bool __is_number    (char c);
-    inline bool __is_numeric   (const std::string&);
-    inline bool __is_whitespace(const std::string&);
 };
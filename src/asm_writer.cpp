@@ -0,0 +1,112 @@
+#include "asm_writer.hpp"
+
+#include <cassert>
+
+#include "layout.hpp"
+
+void AsmWriter::write() {
+    /* Nothing is written for a program LC2K cannot hold. */
+    Layout layout(this->m_program);
+
+    if (layout.has_jump()) {
+        this->_instruction(NoLabel, layout.jump());
+        for (const DataWord* word : layout.data())
+            this->_data(*word);
+    }
+
+    for (auto& fn : this->m_program.functions) {
+        LabelId label = fn.entry;
+        for (auto& in : fn.code) {
+            this->_instruction(label, in);
+            label = NoLabel;
+        }
+    }
+}
+
+void AsmWriter::_instruction(LabelId label, const MInstr& in) {
+    auto offset = [&](const MInstr& mem) {
+        assert(mem.label == NoLabel || mem.offset == 0);
+        if (mem.label != NoLabel)
+            this->_label_name(mem.label);
+        else
+            this->m_os << mem.offset;
+    };
+
+    switch (in.op) {
+        case Opcode::add:
+        case Opcode::nor:
+            this->_label(label);
+            this->m_os << '\t' << to_string(in.op) << '\t' << in.a << '\t' << in.b << '\t' << in.d;
+            break;
+
+        case Opcode::lw:
+        case Opcode::sw:
+        case Opcode::beq:
+            this->_label(label);
+            this->m_os << '\t' << to_string(in.op) << '\t' << in.a << '\t' << in.b << '\t';
+            offset(in);
+            if (in.label != NoLabel)
+                this->_comment(in.label);
+            break;
+
+        case Opcode::jalr:
+            this->_label(label);
+            this->m_os << '\t' << to_string(in.op) << '\t' << in.a << '\t' << in.b;
+            break;
+
+        case Opcode::halt:
+        case Opcode::noop:
+            this->_label(label);
+            this->m_os << '\t' << to_string(in.op);
+            break;
+
+        case Opcode::eq: {
+            MInstr seq[MaxExpansion];
+            int n = expand(in, seq);
+            for (int k = 0; k < n; k++)
+                this->_instruction(k == 0 ? label : NoLabel, seq[k]);
+            return;
+        }
+    }
+
+    this->m_os.put('\n');
+    this->m_words++;
+}
+
+void AsmWriter::_data(const DataWord& word) {
+    this->_label(word.label);
+    this->m_os << "\t.fill\t";
+
+    if (word.value_label != NoLabel)
+        this->_label_name(word.value_label);
+    else
+        this->m_os << word.value;
+
+    this->_comment(word.label);
+    this->m_os.put('\n');
+    this->m_words++;
+}
+
+/* The label column: name or nothing. */
+void AsmWriter::_label(LabelId label) {
+    if (label != NoLabel)
+        this->_label_name(label);
+}
+
+void AsmWriter::_label_name(LabelId label) {
+    const Label& l = this->m_program.labels[label];
+    this->m_os << LabelPrefix[static_cast<size_t>(l.kind)] << l.index;
+}
+
+void AsmWriter::_comment(LabelId label) {
+    const Label& l = this->m_program.labels[label];
+
+    switch (l.kind) {
+        case LabelKind::Spill: this->m_os << "\tspill";          return;
+        case LabelKind::Save:  this->m_os << "\treturn address"; return;
+        default:               break;
+    }
+
+    if (l.name != NoSymbol)
+        this->m_os << '\t' << spelling(l.name);
+}
@@ -0,0 +1,97 @@
+#include "assembler.hpp"
+
+#include <charconv>
+#include <stdexcept>
+#include <string>
+
+std::vector<int32_t> Assembler::assemble() {
+    this->m_layout.emplace(this->m_program);
+
+    std::vector<int32_t> image;
+    image.reserve(this->m_layout->size());
+
+    this->m_map = SourceMap {};
+
+    /* The jump and the data belong to no statement; the top-level code's range starts at 0 over them. */
+    if (this->m_layout->has_jump()) {
+        this->m_map.add(0, NoLoc);
+        image.push_back(this->_encode(this->m_layout->jump(), 0));
+
+        for (const DataWord* word : this->m_layout->data())
+            image.push_back(this->_data(*word));
+    }
+
+    MInstr seq[MaxExpansion];
+    for (auto& fn : this->m_program.functions) {
+        uint32_t begin = &fn == &this->m_program.functions[0] ? 0 : static_cast<uint32_t>(image.size());
+
+        for (auto& in : fn.code) {
+            this->m_map.add(static_cast<uint32_t>(image.size()), in.loc);
+
+            int n = expand(in, seq);
+            for (int k = 0; k < n; k++)
+                image.push_back(this->_encode(seq[k], static_cast<uint32_t>(image.size())));
+        }
+
+        this->m_map.functions.push_back(SourceMap::Function {begin, static_cast<uint32_t>(image.size()), fn.name});
+    }
+    this->m_map.code_end = static_cast<uint32_t>(image.size());
+
+    return image;
+}
+
+int32_t Assembler::_encode(const MInstr& in, uint32_t pc) const {
+    uint32_t word = static_cast<uint32_t>(in.op) << 22 | (in.a & 7) << 19 | (in.b & 7) << 16;
+
+    switch (in.op) {
+        case Opcode::add:
+        case Opcode::nor:
+            word |= in.d & 7;
+            break;
+
+        case Opcode::lw:
+        case Opcode::sw:
+        case Opcode::beq: {
+            int64_t offset = this->m_layout->offset(in, pc);
+            if (offset < lc2k::MinOffset || offset > lc2k::MaxOffset)
+                throw std::runtime_error("Assembler error: offset " + std::to_string(offset) +
+                                         " at address " + std::to_string(pc) + " does not fit in 16 bits");
+            word |= static_cast<uint32_t>(offset) & 0xffff;
+            break;
+        }
+
+        case Opcode::jalr:
+            break;
+
+        case Opcode::halt:
+        case Opcode::noop:
+            word = static_cast<uint32_t>(in.op) << 22;
+            break;
+
+        case Opcode::eq:
+            throw std::runtime_error("Assembler error: unexpanded pseudo-instruction");
+    }
+
+    return static_cast<int32_t>(word);
+}
+
+int32_t Assembler::_data(const DataWord& word) const {
+    if (word.value_label != NoLabel)
+        return static_cast<int32_t>(this->m_layout->address(word.value_label));
+    return word.value;
+}
+
+void write_machine_code(std::ostream& os, const std::vector<int32_t>& image) {
+    char  buffer[1 << 14];
+    char* at = buffer;
+
+    for (int32_t word : image) {
+        if (buffer + sizeof(buffer) - at < 16) {
+            os.write(buffer, at - buffer);
+            at = buffer;
+        }
+        at    = std::to_chars(at, buffer + sizeof(buffer), word).ptr;
+        *at++ = '\n';
+    }
+    os.write(buffer, at - buffer);
+}
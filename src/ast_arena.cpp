@@ -0,0 +1,63 @@
+#include "ast_arena.hpp"
+
+AstArena::~AstArena() {
+    this->release();
+}
+
+void AstArena::release() {
+    while (this->m_head) {
+        Block* prev = this->m_head->prev;
+        ::operator delete(this->m_head);
+        this->m_head = prev;
+    }
+
+    this->m_cur        = nullptr;
+    this->m_end        = nullptr;
+    this->m_next_block = AstArena::InitialBlock;
+    this->m_blocks     = 0;
+    this->m_used       = 0;
+    this->m_objects    = 0;
+}
+
+void* AstArena::allocate(size_t size, size_t align) {
+    auto cur     = reinterpret_cast<uintptr_t>(this->m_cur);
+    auto aligned = (cur + align - 1) & ~(uintptr_t)(align - 1);
+
+    if (!this->m_cur || aligned + size > reinterpret_cast<uintptr_t>(this->m_end)) {
+        this->_grow(size + align);
+        cur     = reinterpret_cast<uintptr_t>(this->m_cur);
+        aligned = (cur + align - 1) & ~(uintptr_t)(align - 1);
+    }
+
+    this->m_cur   = reinterpret_cast<char*>(aligned + size);
+    this->m_used += size;
+
+    return reinterpret_cast<void*>(aligned);
+}
+
+std::string_view AstArena::copy_string(std::string_view str) {
+    if (str.empty())
+        return {};
+
+    auto* data = static_cast<char*>(this->allocate(str.size(), 1));
+    std::memcpy(data, str.data(), str.size());
+    return {data, str.size()};
+}
+
+void AstArena::_grow(size_t min_size) {
+    size_t size = this->m_next_block;
+    while (size < min_size + sizeof(Block))
+        size *= 2;
+
+    /* Through operator new so --stats sees arena growth. */
+    auto* block = static_cast<Block*>(::operator new(size));
+
+    block->prev  = this->m_head;
+    this->m_head = block;
+    this->m_cur  = reinterpret_cast<char*>(block + 1);
+    this->m_end  = reinterpret_cast<char*>(block) + size;
+
+    this->m_blocks++;
+    if (this->m_next_block < AstArena::MaxBlock)
+        this->m_next_block *= 2;
+}
@@ -0,0 +1,295 @@
+#include "ast_printer.hpp"
+
+#include <algorithm>
+
+static constexpr std::string_view Spaces = "                                ";
+
+void AstPrinter::print(const ASTNode& node) {
+    visit(node, *this);
+
+    /* Structured dumps are one line per print(). */
+    if (!this->_text())
+        this->m_os.put('\n');
+}
+
+void AstPrinter::operator()(const ProgramNode& node) {
+    if (this->_text()) {
+        for (auto* stmt : node.functions_and_statements) {
+            visit(*stmt, *this);
+            this->m_os.put('\n');
+        }
+        return;
+    }
+
+    this->_begin("Program");
+    this->_key("body");
+    this->_list(node.functions_and_statements);
+    this->_end();
+}
+
+void AstPrinter::operator()(const FunctionDeclNode& node) {
+    if (this->_text()) {
+        this->_indent();
+        this->m_os << "fn " << node.return_type << ' ' << spelling(node.name) << '(';
+        for (size_t i = 0; i < node.params.size(); i++) {
+            if (i > 0) this->m_os << ", ";
+            this->m_os << spelling(node.params[i].name) << " : " << node.params[i].type;
+        }
+        this->m_os << ") {\n";
+
+        this->m_indent++;
+        for (auto* stmt : node.body) {
+            visit(*stmt, *this);
+            this->m_os.put('\n');
+        }
+        this->m_indent--;
+
+        this->_indent();
+        this->m_os.put('}');
+        return;
+    }
+
+    bool json = this->m_format == Format::Json;
+
+    this->_begin("FunctionDecl");
+    this->_key("name");
+    this->_string(spelling(node.name));
+    this->_key("return_type");
+    this->_string(node.return_type);
+    this->_key("params");
+    this->m_os.put(json ? '[' : '(');
+    for (size_t i = 0; i < node.params.size(); i++) {
+        if (i > 0) this->m_os.put(json ? ',' : ' ');
+        this->_begin("Param");
+        this->_key("name");
+        this->_string(spelling(node.params[i].name));
+        this->_key("type");
+        this->_string(node.params[i].type);
+        this->_end();
+    }
+    this->m_os.put(json ? ']' : ')');
+    this->_key("body");
+    this->_list(node.body);
+    this->_end();
+}
+
+void AstPrinter::operator()(const FunctionCallNode& node) {
+    if (this->_text()) {
+        this->m_os << spelling(node.name) << '(';
+        for (size_t i = 0; i < node.args.size(); i++) {
+            if (i > 0) this->m_os << ", ";
+            this->_expr(node.args[i]);
+        }
+        this->m_os.put(')');
+        return;
+    }
+
+    this->_begin("FunctionCall");
+    this->_key("name");
+    this->_string(spelling(node.name));
+    this->_key("args");
+    this->_list(node.args);
+    this->_end();
+}
+
+void AstPrinter::operator()(const VarDeclNode& node) {
+    if (this->_text()) {
+        this->_indent();
+        this->m_os << "let " << spelling(node.name) << " : " << node.type << " = ";
+        this->_expr(node.value);
+        this->m_os.put(';');
+        return;
+    }
+
+    this->_begin("VarDecl");
+    this->_key("name");
+    this->_string(spelling(node.name));
+    this->_key("type");
+    this->_string(node.type);
+    this->_key("value");
+    this->_node(node.value);
+    this->_end();
+}
+
+void AstPrinter::operator()(const AssignmentNode& node) {
+    if (this->_text()) {
+        this->_indent();
+        this->m_os << spelling(node.name) << " = ";
+        this->_expr(node.value);
+        this->m_os.put(';');
+        return;
+    }
+
+    this->_begin("Assignment");
+    this->_key("name");
+    this->_string(spelling(node.name));
+    this->_key("value");
+    this->_node(node.value);
+    this->_end();
+}
+
+void AstPrinter::operator()(const ExitNode& node) {
+    if (this->_text()) {
+        this->_indent();
+        this->m_os << "exit(";
+        this->_expr(node.value);
+        this->m_os << ");";
+        return;
+    }
+
+    this->_begin("Exit");
+    this->_key("value");
+    this->_node(node.value);
+    this->_end();
+}
+
+void AstPrinter::operator()(const ExprStmtNode& node) {
+    if (this->_text()) {
+        this->_indent();
+        this->_expr(node.expr);
+        this->m_os.put(';');
+        return;
+    }
+
+    this->_begin("ExprStmt");
+    this->_key("expr");
+    this->_node(node.expr);
+    this->_end();
+}
+
+/*
+ * A +/- chain is left-deep and as long as the source, so the left
+ * operands are not recursed into: the operators down the left
+ * spine are opened outermost first, the innermost left operand is
+ * printed, then each operator is closed with its right operand.
+ */
+void AstPrinter::operator()(const BinaryExprNode& node) {
+    size_t         mark = this->m_spine.size();
+    const ASTNode* left = &node;
+    while (auto* binary = node_cast<BinaryExprNode>(left)) {
+        this->m_spine.push_back(binary);
+        left = binary->left;
+    }
+
+    if (this->_text()) {
+        for (size_t i = mark; i < this->m_spine.size(); i++)
+            this->m_os.put('(');
+        this->_expr(left);
+
+        while (this->m_spine.size() > mark) {
+            const BinaryExprNode* binary = this->m_spine.back();
+            this->m_spine.pop_back();
+
+            this->m_os << ' ' << to_spelling(binary->op) << ' ';
+            this->_expr(binary->right);
+            this->m_os.put(')');
+        }
+        return;
+    }
+
+    for (size_t i = mark; i < this->m_spine.size(); i++) {
+        this->_begin("BinaryExpr");
+        this->_key("op");
+        this->_string(to_spelling(this->m_spine[i]->op));
+        this->_key("left");
+    }
+    this->_node(left);
+
+    while (this->m_spine.size() > mark) {
+        const BinaryExprNode* binary = this->m_spine.back();
+        this->m_spine.pop_back();
+
+        this->_key("right");
+        this->_node(binary->right);
+        this->_end();
+    }
+}
+
+void AstPrinter::operator()(const IdentNode& node) {
+    if (this->_text()) {
+        this->m_os << spelling(node.name);
+        return;
+    }
+
+    this->_begin("Ident");
+    this->_key("name");
+    this->_string(spelling(node.name));
+    this->_end();
+}
+
+void AstPrinter::operator()(const IntLiteralNode& node) {
+    if (this->_text()) {
+        this->m_os << node.value;
+        return;
+    }
+
+    this->_begin("IntLiteral");
+    this->_key("value");
+    this->m_os << node.value;
+    this->_end();
+}
+
+/* Text helpers */
+void AstPrinter::_indent() {
+    size_t width = this->m_indent * 2; // 2 spaces per level
+
+    while (width > 0) {
+        size_t chunk = std::min(width, Spaces.size());
+        this->m_os.write(Spaces.data(), chunk);
+        width -= chunk;
+    }
+}
+
+void AstPrinter::_expr(const ASTNode* node) {
+    if (node)
+        visit(*node, *this);
+    else
+        this->m_os << "<null>";
+}
+
+/* Structured helpers */
+void AstPrinter::_begin(const char* kind) {
+    if (this->m_format == Format::Json)
+        this->m_os << "{\"kind\":\"" << kind << '"';
+    else
+        this->m_os << '(' << kind;
+}
+
+void AstPrinter::_key(const char* key) {
+    if (this->m_format == Format::Json)
+        this->m_os << ",\"" << key << "\":";
+    else
+        this->m_os << " :" << key << ' ';
+}
+
+void AstPrinter::_end() {
+    this->m_os.put(this->m_format == Format::Json ? '}' : ')');
+}
+
+void AstPrinter::_string(std::string_view str) {
+    this->m_os.put('"');
+    for (char c : str) {
+        if (c == '"' || c == '\\')
+            this->m_os.put('\\');
+        this->m_os.put(c);
+    }
+    this->m_os.put('"');
+}
+
+void AstPrinter::_node(const ASTNode* node) {
+    if (node)
+        visit(*node, *this);
+    else
+        this->m_os << (this->m_format == Format::Json ? "null" : "nil");
+}
+
+void AstPrinter::_list(const NodeList& nodes) {
+    bool json = this->m_format == Format::Json;
+
+    this->m_os.put(json ? '[' : '(');
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (i > 0) this->m_os.put(json ? ',' : ' ');
+        this->_node(nodes[i]);
+    }
+    this->m_os.put(json ? ']' : ')');
+}
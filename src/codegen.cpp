@@ -0,0 +1,271 @@
+#include "codegen.hpp"
+
+#include <cassert>
+
+MProgram CodeGen::generate() {
+    this->_declare_functions();
+    this->_assign_slots();
+
+    /* functions[0] is the top-level code, then one per FunctionDeclNode. */
+    size_t count = this->m_program.functions.size();
+    this->m_out.functions.resize(count);
+    this->m_first_local = static_cast<LabelId>(this->m_out.labels.size());
+
+    std::vector<std::vector<int32_t>> words(count);
+    parallel_for(this->m_pool, count, [&](size_t, size_t i) {
+        words[i] = Lowering(*this, static_cast<uint32_t>(i), this->m_out.functions[i]).run();
+    });
+
+    for (size_t i = 0; i < count; i++)
+        this->_merge_constants(this->m_out.functions[i], words[i]);
+
+    return std::move(this->m_out);
+}
+
+void CodeGen::_declare_functions() {
+    this->m_slots.assign(this->m_program.vars.size(), NoLabel);
+    this->m_functions.resize(this->m_program.functions.size());
+
+    for (uint32_t i = 1; i < this->m_program.functions.size(); i++) {
+        const IrFunction& ir   = this->m_program.functions[i];
+        Function&         func = this->m_functions[i];
+
+        func.entry   = this->m_out.new_label(LabelKind::Func,  ir.name);
+        func.address = this->m_out.new_label(LabelKind::Const, ir.name);
+        this->m_out.data.push_back(DataWord {.label = func.address, .value_label = func.entry});
+
+        for (VarId param : ir.params) {
+            func.params.push_back(this->m_out.new_label(LabelKind::Param, this->m_program.vars[param].name));
+            this->m_slots[param] = func.params.back();
+        }
+    }
+}
+
+void CodeGen::_assign_slots() {
+    for (uint32_t i = 1; i < this->m_program.functions.size(); i++) {
+        const IrFunction& ir = this->m_program.functions[i];
+
+        for (auto* list : {&ir.reads, &ir.writes}) {
+            for (VarId var : *list) {
+                if (this->m_slots[var] != NoLabel)
+                    continue;
+
+                this->m_slots[var] = this->m_out.new_label(LabelKind::Global, this->m_program.vars[var].name);
+                this->m_out.data.push_back(DataWord {.label = this->m_slots[var]});
+            }
+        }
+    }
+}
+
+/* Gives fn's constant words their labels: an earlier function's for the same value, or a new one. */
+void CodeGen::_merge_constants(MFunction& fn, const std::vector<int32_t>& words) {
+    if (words.empty())
+        return;
+
+    std::vector<LabelId> map;
+    map.reserve(words.size());
+
+    for (int32_t value : words) {
+        auto [it, inserted] = this->m_constants.try_emplace(value, NoLabel);
+        if (inserted) {
+            it->second = this->m_out.new_label(LabelKind::Const);
+            this->m_out.data.push_back(DataWord {.label = it->second, .value = value});
+        }
+        map.push_back(it->second);
+    }
+
+    fn.relabel(this->m_first_local, map);
+}
+
+/* LOWERING */
+
+CodeGen::Lowering::Lowering(const CodeGen& gen, uint32_t index, MFunction& fn)
+    : m_gen(gen), m_ir(gen.m_program.functions[index]), m_index(index), m_fn(fn) {}
+
+std::vector<int32_t> CodeGen::Lowering::run() {
+    const Function& func = this->m_gen.m_functions[this->m_index];
+
+    this->m_values.assign(this->m_ir.next_value, NoReg);
+
+    if (this->m_index > 0) {
+        this->m_fn.name   = this->m_ir.name;
+        this->m_fn.entry  = func.entry;
+        this->m_fn.params = func.params;
+    }
+
+    /* Its entry and parameter words are another object's; the linker resolves them. */
+    if (this->m_ir.external) {
+        this->m_fn.external = true;
+        return {};
+    }
+
+    for (LabelId param : func.params)
+        this->m_fn.data.push_back(DataWord {.label = param});
+
+    /* Blocks after the first are only there without optimization; they never run. */
+    for (auto& block : this->m_ir.blocks)
+        for (auto& in : block.code)
+            this->_instruction(in);
+
+    return std::move(this->m_words);
+}
+
+void CodeGen::Lowering::_instruction(const IrInstr& in) {
+    auto value = [&](Value v) {
+        assert(this->m_values[v] != NoReg && "Value used before its definition");
+        return this->m_values[v];
+    };
+
+    this->m_loc = in.loc;
+
+    switch (in.op) {
+        case IrOp::Const:
+            this->m_values[in.dest] = this->_constant(in.imm);
+            break;
+
+        case IrOp::Add: {
+            Reg dest = this->m_fn.new_vreg();
+            this->_emit(MInstr {.op = Opcode::add, .a = value(in.a), .b = value(in.b), .d = dest});
+            this->m_values[in.dest] = dest;
+            break;
+        }
+
+        case IrOp::Sub: {
+            Reg left = value(in.a);
+            this->m_values[in.dest] = left == lc2k::ZeroReg ? this->_lowered(lowering::Op::Neg, value(in.b), lc2k::ZeroReg)
+                                                            : this->_lowered(lowering::Op::Sub, left, value(in.b));
+            break;
+        }
+
+        case IrOp::Eq: {
+            Reg dest = this->m_fn.new_vreg();
+            this->_emit(MInstr {.op = Opcode::eq, .a = value(in.a), .b = value(in.b), .d = dest,
+                                .label = this->_constant_word(1)});
+            this->m_values[in.dest] = dest;
+            break;
+        }
+
+        case IrOp::Load:
+            this->m_values[in.dest] = this->_load(in.var);
+            break;
+
+        case IrOp::Store:
+            this->_store(in.var, value(in.a));
+            break;
+
+        case IrOp::Call:
+            this->_call(in);
+            break;
+
+        case IrOp::Exit:
+            this->_emit(MInstr {.op = Opcode::add, .a = value(in.a), .b = lc2k::ZeroReg, .d = lc2k::ExitReg});
+            this->_emit(MInstr {.op = Opcode::halt});
+            break;
+
+        case IrOp::Ret:
+            this->_emit(MInstr {.op = Opcode::jalr, .a = lc2k::LinkReg, .b = lc2k::TrashReg});
+            break;
+    }
+}
+
+Reg CodeGen::Lowering::_load(VarId var) {
+    const IrVar& v    = this->m_gen.m_program.vars[var];
+    LabelId      slot = this->m_gen.m_slots[var];
+
+    if (v.kind == IrVar::Global && slot != NoLabel) {
+        Reg reg = this->m_fn.new_vreg();
+        this->_emit(MInstr {.op = Opcode::lw, .a = lc2k::ZeroReg, .b = reg, .label = slot});
+        return reg;
+    }
+
+    auto it = this->m_var_regs.find(var);
+    if (it != this->m_var_regs.end())
+        return it->second;
+
+    /* A parameter not assigned yet: the caller's argument. */
+    assert(v.kind == IrVar::Param && "Variable read before it was written");
+    Reg reg = this->m_fn.new_vreg();
+    this->_emit(MInstr {.op = Opcode::lw, .a = lc2k::ZeroReg, .b = reg, .label = slot});
+    this->m_var_regs[var] = reg;
+    return reg;
+}
+
+void CodeGen::Lowering::_store(VarId var, Reg value) {
+    if (this->m_gen.m_program.vars[var].kind == IrVar::Global && this->m_gen.m_slots[var] != NoLabel)
+        this->_emit(MInstr {.op = Opcode::sw, .a = lc2k::ZeroReg, .b = value, .label = this->m_gen.m_slots[var]});
+    else
+        this->m_var_regs[var] = value;      // parameter words stay read-only (see is_read_only)
+}
+
+void CodeGen::Lowering::_call(const IrInstr& in) {
+    const Function& callee = this->m_gen.m_functions[in.callee];
+
+    for (uint32_t i = 0; i < in.args_count; i++)
+        this->_emit(MInstr {.op = Opcode::sw, .a = lc2k::ZeroReg,
+                            .b = this->m_values[this->m_ir.args[in.args_begin + i]],
+                            .label = callee.params[i]});
+
+    Reg target = this->m_fn.new_vreg();
+    this->_emit(MInstr {.op = Opcode::lw,   .a = lc2k::ZeroReg, .b = target, .label = callee.address});
+    this->_emit(MInstr {.op = Opcode::jalr, .a = target, .b = lc2k::LinkReg});
+}
+
+/* EMISSION HELPERS */
+
+/* A register holding value; the allocator rematerialises these instead of spilling. */
+Reg CodeGen::Lowering::_constant(int32_t value) {
+    if (value == 0)
+        return lc2k::ZeroReg;
+
+    auto [it, inserted] = this->m_constant_regs.try_emplace(value, NoReg);
+    if (!inserted)
+        return it->second;
+
+    Reg reg = this->m_fn.new_vreg();
+    if (value == -1)
+        this->_emit(MInstr {.op = Opcode::nor, .a = lc2k::ZeroReg, .b = lc2k::ZeroReg, .d = reg});
+    else
+        this->_emit(MInstr {.op = Opcode::lw, .a = lc2k::ZeroReg, .b = reg, .label = this->_constant_word(value)});
+
+    it->second = reg;
+    return reg;
+}
+
+/* A provisional label; _merge_constants() shares it with other functions' afterwards. */
+LabelId CodeGen::Lowering::_constant_word(int32_t value) {
+    auto [it, inserted] = this->m_word_labels.try_emplace(value, NoLabel);
+    if (inserted) {
+        it->second = this->m_gen.m_first_local + static_cast<LabelId>(this->m_words.size());
+        this->m_words.push_back(value);
+    }
+    return it->second;
+}
+
+Reg CodeGen::Lowering::_lowered(lowering::Op op, Reg a, Reg b) {
+    using namespace lowering;
+
+    /* Fresh vregs never alias, except an operand used twice, which the register setting has an entry for. */
+    const Entry& e = op != Op::Neg && a == b ? lookup(op, Alias::SameAB, Regs::None)
+                                             : lookup(op, Alias::Distinct, Regs::Ssa);
+    assert(e.length > 0);
+
+    Reg  roles[S2 + 1] = {lc2k::ZeroReg, a, b};
+    bool bound[S2 + 1] = {true, true, true};
+    auto reg = [&](Role role) {
+        if (!bound[role]) {
+            roles[role] = this->m_fn.new_vreg();
+            bound[role] = true;
+        }
+        return roles[role];
+    };
+
+    for (int i = 0; i < e.length; i++) {
+        const Step& s = e.steps[i];
+        assert(s.op != Opcode::beq && s.z != T);
+        if (s.op == Opcode::lw)
+            this->_emit(MInstr {.op = Opcode::lw, .a = lc2k::ZeroReg, .b = reg(s.z), .label = this->_constant_word(1)});
+        else
+            this->_emit(MInstr {.op = s.op, .a = reg(s.x), .b = reg(s.y), .d = reg(s.z)});
+    }
+    return reg(D);
+}
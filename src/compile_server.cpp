@@ -0,0 +1,315 @@
+#include "compile_server.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/* Largest message either end accepts; sources and listings are far smaller. */
+static constexpr uint64_t MaxMessage = uint64_t(1) << 32;
+
+static std::string system_error(const std::string& what) {
+    return "Server error: " + what + ": " + std::strerror(errno);
+}
+
+/* MESSAGES */
+
+class MessageWriter {
+public:
+    void u64(uint64_t value) { this->m_bytes.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+
+    void str(const std::string& s) {
+        this->u64(s.size());
+        this->m_bytes += s;
+    }
+
+    /* The message, behind its byte count. */
+    std::string finish() {
+        std::string framed(sizeof(uint64_t), '\0');
+        uint64_t    size = this->m_bytes.size();
+        std::memcpy(framed.data(), &size, sizeof(size));
+        return framed + this->m_bytes;
+    }
+
+private:
+    std::string m_bytes;
+};
+
+class MessageReader {
+public:
+    explicit MessageReader(const std::string& bytes)
+        : m_bytes(bytes) {}
+
+    uint64_t u64() {
+        uint64_t value;
+        this->_need(sizeof(value));
+        std::memcpy(&value, this->m_bytes.data() + this->m_pos, sizeof(value));
+        this->m_pos += sizeof(value);
+        return value;
+    }
+
+    std::string str() {
+        uint64_t size = this->u64();
+        this->_need(size);
+        std::string s = this->m_bytes.substr(this->m_pos, size);
+        this->m_pos += size;
+        return s;
+    }
+
+private:
+    const std::string& m_bytes;
+    size_t             m_pos = 0;
+
+    void _need(uint64_t size) const {
+        if (size > this->m_bytes.size() - this->m_pos)
+            throw std::runtime_error("Server error: truncated message");
+    }
+};
+
+static void write_all(int fd, const std::string& bytes) {
+    for (size_t done = 0; done < bytes.size(); ) {
+        ssize_t n = ::send(fd, bytes.data() + done, bytes.size() - done, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            throw std::runtime_error(system_error("send"));
+        done += static_cast<size_t>(n);
+    }
+}
+
+static void read_all(int fd, char* out, size_t size) {
+    for (size_t done = 0; done < size; ) {
+        ssize_t n = ::recv(fd, out + done, size - done, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            throw std::runtime_error(system_error("recv"));
+        if (n == 0)
+            throw std::runtime_error("Server error: connection closed");
+        done += static_cast<size_t>(n);
+    }
+}
+
+static std::string read_message(int fd) {
+    uint64_t size;
+    read_all(fd, reinterpret_cast<char*>(&size), sizeof(size));
+    if (size > MaxMessage)
+        throw std::runtime_error("Server error: message of " + std::to_string(size) + " bytes");
+
+    std::string bytes(size, '\0');
+    read_all(fd, bytes.data(), size);
+    return bytes;
+}
+
+static sockaddr_un socket_address(const std::string& path) {
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+        throw std::runtime_error("Server error: socket path too long: " + path);
+
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+
+/* Whether the process at the other end of fd runs as this user. */
+static bool same_user(int fd) {
+    ucred     cred {};
+    socklen_t size = sizeof(cred);
+    return ::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &size) == 0 && cred.uid == ::getuid();
+}
+
+/*
+ * A connected socket, or -1 if nothing listens at path. Anything
+ * else at path (another user's socket, a file, a server running
+ * as someone else) is an error: its answers cannot be trusted.
+ */
+static int connect_to(const std::string& path) {
+    sockaddr_un address = socket_address(path);
+
+    struct stat st {};
+    if (::lstat(path.c_str(), &st) < 0)
+        return -1;
+    if (!S_ISSOCK(st.st_mode) || st.st_uid != ::getuid())
+        throw std::runtime_error("Server error: " + path + " is not a socket of this user");
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        throw std::runtime_error(system_error("socket"));
+
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        ::close(fd);
+        return -1;
+    }
+
+    if (!same_user(fd)) {
+        ::close(fd);
+        throw std::runtime_error("Server error: the server on " + path + " runs as another user");
+    }
+    return fd;
+}
+
+/*
+ * Makes the directory the socket goes in, readable by this user
+ * only, if it does not exist. One that does must be this user's,
+ * or shared and sticky like /tmp, where others cannot replace the
+ * socket.
+ */
+static void socket_directory(const std::string& path) {
+    size_t      slash = path.find_last_of('/');
+    std::string dir   = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+
+    if (::mkdir(dir.c_str(), 0700) < 0 && errno != EEXIST)
+        throw std::runtime_error(system_error("cannot create " + dir));
+
+    struct stat st {};
+    if (::lstat(dir.c_str(), &st) < 0)
+        throw std::runtime_error(system_error(dir));
+    if (!S_ISDIR(st.st_mode) || (st.st_uid != ::getuid() && !(st.st_uid == 0 && (st.st_mode & S_ISVTX))))
+        throw std::runtime_error("Server error: " + dir + " belongs to another user");
+}
+
+/* SERVER */
+
+/* Set by SIGINT and SIGTERM; accept() returns EINTR and serve() ends. */
+static volatile std::sig_atomic_t Stopping = 0;
+
+static void on_stop(int) {
+    Stopping = 1;
+}
+
+CompileServer::CompileServer(const std::string& path)
+    : m_path(path) {
+    sockaddr_un address = socket_address(path);
+    socket_directory(path);
+
+    /* A socket nobody answers on is left over from a server that died. */
+    if (int other = connect_to(path); other >= 0) {
+        ::close(other);
+        throw std::runtime_error("Server error: a server is already listening on " + path);
+    }
+    ::unlink(path.c_str());
+
+    this->m_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (this->m_fd < 0)
+        throw std::runtime_error(system_error("socket"));
+
+    if (::bind(this->m_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        ::chmod(path.c_str(), 0600) < 0 || ::listen(this->m_fd, SOMAXCONN) < 0) {
+        std::string message = system_error("cannot listen on " + path);
+        ::close(this->m_fd);
+        throw std::runtime_error(message);
+    }
+}
+
+CompileServer::~CompileServer() {
+    if (this->m_fd >= 0) {
+        ::close(this->m_fd);
+        ::unlink(this->m_path.c_str());
+    }
+}
+
+void CompileServer::serve(const Handler& handler) {
+    /* No SA_RESTART: a signal has to interrupt accept(). */
+    struct sigaction stop {};
+    stop.sa_handler = on_stop;
+    ::sigemptyset(&stop.sa_mask);
+    ::sigaction(SIGINT,  &stop, nullptr);
+    ::sigaction(SIGTERM, &stop, nullptr);
+
+    while (!Stopping) {
+        int conn = ::accept4(this->m_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (conn < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            throw std::runtime_error(system_error("accept"));
+        }
+
+        /* Only this user's own lcc processes are answered. */
+        if (!same_user(conn)) {
+            ::close(conn);
+            continue;
+        }
+
+        /* A client that went away, or a request that failed outright, only loses its own answer. */
+        try {
+            this->_answer(conn, handler);
+            this->m_served++;
+        } catch (const std::exception&) {
+        }
+        ::close(conn);
+    }
+}
+
+void CompileServer::_answer(int conn, const Handler& handler) {
+    /* Clients send their whole request as soon as they connect; one that does not cannot hold up the rest. */
+    timeval timeout {.tv_sec = ReceiveTimeout, .tv_usec = 0};
+    ::setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    std::string   bytes = read_message(conn);
+    MessageReader reader(bytes);
+
+    CompileRequest request;
+    request.cwd = reader.str();
+    if (reader.u64())
+        request.input = reader.str();
+    for (uint64_t n = reader.u64(); n > 0; n--)
+        request.args.push_back(reader.str());
+
+    CompileResponse response = handler(request);
+
+    MessageWriter writer;
+    writer.u64(static_cast<uint64_t>(response.status));
+    writer.str(response.out);
+    writer.str(response.err);
+    write_all(conn, writer.finish());
+}
+
+/* CLIENT */
+
+std::optional<CompileResponse> send_compile_request(const std::string& path, const CompileRequest& request) {
+    MessageWriter writer;
+    writer.str(request.cwd);
+    writer.u64(request.input.has_value());
+    if (request.input)
+        writer.str(*request.input);
+    writer.u64(request.args.size());
+    for (auto& arg : request.args)
+        writer.str(arg);
+
+    int fd = connect_to(path);
+    if (fd < 0)
+        return std::nullopt;
+
+    CompileResponse response;
+    try {
+        write_all(fd, writer.finish());
+
+        std::string   bytes = read_message(fd);
+        MessageReader reader(bytes);
+        response.status = static_cast<int>(reader.u64());
+        response.out    = reader.str();
+        response.err    = reader.str();
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+
+    ::close(fd);
+    return response;
+}
+
+std::string default_socket_path() {
+    if (const char* path = std::getenv("LCC_SOCKET"); path && *path)
+        return path;
+    if (const char* dir = std::getenv("XDG_RUNTIME_DIR"); dir && *dir)
+        return std::string(dir) + "/lcc.sock";
+    return "/tmp/lcc-" + std::to_string(::getuid()) + "/lcc.sock";
+}
@@ -0,0 +1,281 @@
+#include "const_fold.hpp"
+
+#include <algorithm>
+#include <utility>
+
+void ConstantFolder::run() {
+    for (auto* stmt : this->m_program.functions_and_statements)
+        this->_statement(*stmt);
+}
+
+void ConstantFolder::_statement(ASTNode& node) {
+    switch (node.kind) {
+        case NodeKind::FunctionDecl:
+            for (auto* stmt : static_cast<FunctionDeclNode&>(node).body)
+                this->_statement(*stmt);
+            break;
+
+        case NodeKind::VarDecl: {
+            auto& var = static_cast<VarDeclNode&>(node);
+            var.value = this->_expr(var.value);
+            break;
+        }
+
+        case NodeKind::Assignment: {
+            auto& assign = static_cast<AssignmentNode&>(node);
+            assign.value = this->_expr(assign.value);
+            break;
+        }
+
+        case NodeKind::Exit: {
+            auto& exit = static_cast<ExitNode&>(node);
+            exit.value = this->_expr(exit.value);
+            break;
+        }
+
+        case NodeKind::ExprStmt: {
+            auto& stmt = static_cast<ExprStmtNode&>(node);
+            stmt.expr = this->_expr(stmt.expr);
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+/* node, or what replaces it. */
+ASTNodePtr ConstantFolder::_expr(ASTNodePtr node) {
+    switch (node->kind) {
+        case NodeKind::BinaryExpr: {
+            auto& binary = static_cast<BinaryExprNode&>(*node);
+            if (binary.op == TokenType::o_equal_equal)
+                return this->_equality(binary);
+            return this->_chain(binary);
+        }
+
+        case NodeKind::FunctionCall:
+            for (auto*& arg : static_cast<FunctionCallNode&>(*node).args)
+                arg = this->_expr(arg);
+            return node;
+
+        default:
+            return node;
+    }
+}
+
+ASTNodePtr ConstantFolder::_equality(BinaryExprNode& node) {
+    node.left  = this->_expr(node.left);
+    node.right = this->_expr(node.right);
+
+    auto* left  = node_cast<IntLiteralNode>(node.left);
+    auto* right = node_cast<IntLiteralNode>(node.right);
+
+    if (left && right) {
+        left->value = left->value == right->value;
+        this->m_removed++;
+        return left;
+    }
+
+    if (this->_same(node.left, node.right)) {
+        auto* one   = this->m_program.arena.make<IntLiteralNode>();
+        one->offset = node.offset;
+        one->value  = 1;
+        this->m_removed++;
+        return one;
+    }
+
+    return &node;
+}
+
+ASTNodePtr ConstantFolder::_chain(BinaryExprNode& root) {
+    size_t term_mark    = this->m_terms.size();
+    size_t op_mark      = this->m_ops.size();
+    size_t literal_mark = this->m_literals.size();
+
+    uint32_t sum = 0;      // wraps like LC2K's 32-bit add
+    this->_flatten(root, sum);
+
+    auto terms_begin = this->m_terms.begin() + term_mark;
+    bool pure = std::all_of(terms_begin, this->m_terms.end(),
+                            [&](const Term& t) { return this->_pure(t.node); });
+
+    /* x - x: pair up reads of the same variable with opposite signs. */
+    if (pure) {
+        auto& plus  = this->m_plus;
+        auto& minus = this->m_minus;
+        plus .clear();
+        minus.clear();
+
+        for (size_t i = term_mark; i < this->m_terms.size(); i++) {
+            if (auto* ident = node_cast<IdentNode>(this->m_terms[i].node))
+                (this->m_terms[i].negative ? minus : plus).emplace_back(ident->name, i);
+        }
+        std::sort(plus.begin(),  plus.end());
+        std::sort(minus.begin(), minus.end());
+
+        for (size_t p = 0, m = 0; p < plus.size() && m < minus.size(); ) {
+            if      (plus[p].first < minus[m].first) p++;
+            else if (minus[m].first < plus[p].first) m++;
+            else {
+                this->m_terms[plus [p++].second].node = nullptr;
+                this->m_terms[minus[m++].second].node = nullptr;
+            }
+        }
+
+        this->m_terms.erase(std::remove_if(terms_begin, this->m_terms.end(),
+                                           [](const Term& t) { return !t.node; }),
+                            this->m_terms.end());
+        terms_begin = this->m_terms.begin() + term_mark;
+
+        /* Start with a positive term rather than 0 - x. */
+        auto positive = std::find_if(terms_begin, this->m_terms.end(),
+                                     [](const Term& t) { return !t.negative; });
+        if (positive != this->m_terms.end())
+            std::rotate(terms_begin, positive, positive + 1);
+    }
+
+    /* Rebuild left-deep, reusing the chain's own operator and literal nodes. */
+    size_t next_op = op_mark;
+    auto make = [&](TokenType op, ASTNodePtr left, ASTNodePtr right) -> ASTNodePtr {
+        BinaryExprNode* node = next_op < this->m_ops.size() ? this->m_ops[next_op++]
+                                                             : this->m_program.arena.make<BinaryExprNode>();
+        node->offset = left->offset;
+        node->op     = op;
+        node->left   = left;
+        node->right  = right;
+        return node;
+    };
+
+    auto constant = [&]() -> ASTNodePtr {
+        IntLiteralNode* literal = this->m_literals.size() > literal_mark ? this->m_literals[literal_mark]
+                                                                         : this->m_program.arena.make<IntLiteralNode>();
+        literal->offset = root.offset;
+        literal->value  = static_cast<int32_t>(sum);
+        return literal;
+    };
+
+    ASTNodePtr result;
+    auto       term = terms_begin;
+
+    if (term == this->m_terms.end() || term->negative) {
+        result = constant();
+        sum    = 0;
+    } else {
+        result = (term++)->node;
+    }
+
+    for (; term != this->m_terms.end(); term++)
+        result = make(term->negative ? TokenType::o_sub : TokenType::o_plus, result, term->node);
+
+    if (sum != 0)
+        result = make(TokenType::o_plus, result, constant());
+
+    size_t ops = this->m_ops.size() - op_mark;
+    this->m_removed += ops > next_op - op_mark ? ops - (next_op - op_mark) : 0;
+
+    this->m_terms   .resize(term_mark);
+    this->m_ops     .resize(op_mark);
+    this->m_literals.resize(literal_mark);
+
+    return result;
+}
+
+/*
+ * Collects the signed leaves of a +/- chain, summing literals into
+ * constant. Chains are left-deep and can be as long as the source,
+ * so they are walked from m_walk rather than by recursion.
+ */
+void ConstantFolder::_flatten(BinaryExprNode& root, uint32_t& constant) {
+    size_t mark = this->m_walk.size();
+    this->m_walk.push_back(Term {&root, false});
+
+    while (this->m_walk.size() > mark) {
+        auto [node, negative] = this->m_walk.back();
+        this->m_walk.pop_back();
+
+        if (_is_chain(node)) {
+            auto& binary = static_cast<BinaryExprNode&>(*node);
+            this->m_ops.push_back(&binary);
+
+            /* Right first, so the left side comes off the stack first. */
+            this->m_walk.push_back(Term {binary.right, negative != (binary.op == TokenType::o_sub)});
+            this->m_walk.push_back(Term {binary.left,  negative});
+            continue;
+        }
+
+        /* Folds nested chains, which walk above mark and leave m_walk as they found it. */
+        node = this->_expr(node);
+
+        if (auto* literal = node_cast<IntLiteralNode>(node)) {
+            uint32_t value = static_cast<uint32_t>(literal->value);
+            constant += negative ? 0u - value : value;
+            this->m_literals.push_back(literal);
+            continue;
+        }
+
+        this->m_terms.push_back(Term {node, negative});
+    }
+}
+
+bool ConstantFolder::_is_chain(const ASTNode* node) {
+    auto* binary = node_cast<BinaryExprNode>(node);
+    return binary && (binary->op == TokenType::o_plus || binary->op == TokenType::o_sub);
+}
+
+bool ConstantFolder::_pure(const ASTNode* node) {
+    if (node->kind == NodeKind::Ident || node->kind == NodeKind::IntLiteral)
+        return true;
+
+    auto& stack = this->m_visit;
+    stack.assign(1, node);
+
+    while (!stack.empty()) {
+        const ASTNode* next = stack.back();
+        stack.pop_back();
+
+        if (next->kind == NodeKind::FunctionCall)
+            return false;
+        for_each_child(*next, [&](const ASTNode* child) { stack.push_back(child); });
+    }
+    return true;
+}
+
+bool ConstantFolder::_same(const ASTNode* a, const ASTNode* b) {
+    auto& stack = this->m_pairs;
+    stack.assign(1, {a, b});
+
+    while (!stack.empty()) {
+        auto [x, y] = stack.back();
+        stack.pop_back();
+
+        if (x->kind != y->kind)
+            return false;
+
+        switch (x->kind) {
+            case NodeKind::Ident:
+                if (static_cast<const IdentNode*>(x)->name != static_cast<const IdentNode*>(y)->name)
+                    return false;
+                break;
+
+            case NodeKind::IntLiteral:
+                if (static_cast<const IntLiteralNode*>(x)->value != static_cast<const IntLiteralNode*>(y)->value)
+                    return false;
+                break;
+
+            case NodeKind::BinaryExpr: {
+                auto* bx = static_cast<const BinaryExprNode*>(x);
+                auto* by = static_cast<const BinaryExprNode*>(y);
+                if (bx->op != by->op)
+                    return false;
+                stack.push_back({bx->left,  by->left});
+                stack.push_back({bx->right, by->right});
+                break;
+            }
+
+            default:
+                return false;       // calls may differ between evaluations
+        }
+    }
+    return true;
+}
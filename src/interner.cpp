@@ -0,0 +1,125 @@
+#include "interner.hpp"
+
+#include <cassert>
+#include <stdexcept>
+
+static constexpr size_t InitialSlots = 64;     // per shard
+
+Interner& Interner::global() {
+    static Interner interner;
+    return interner;
+}
+
+Interner::Interner()
+    : m_pages(new std::atomic<Entry*>[Interner::MaxPages]) {
+    for (size_t page = 0; page < Interner::MaxPages; page++)
+        this->m_pages[page].store(nullptr, std::memory_order_relaxed);
+
+    for (auto& shard : this->m_shards)
+        shard.slots.assign(InitialSlots, NoSymbol);
+}
+
+Interner::~Interner() {
+    for (size_t page = 0; page < Interner::MaxPages; page++)
+        delete[] this->m_pages[page].load(std::memory_order_relaxed);
+}
+
+Interner::Entry& Interner::_entry(SymbolId id) const {
+    Entry* page = this->m_pages[id >> Interner::PageBits].load(std::memory_order_acquire);
+    return page[id & (Interner::PageSize - 1)];
+}
+
+Interner::Entry& Interner::_new_entry(SymbolId id) {
+    auto&  slot = this->m_pages[id >> Interner::PageBits];
+    Entry* page = slot.load(std::memory_order_acquire);
+
+    /* Threads in different shards may reach a new page together; one allocation wins. */
+    if (!page) {
+        Entry* fresh = new Entry[Interner::PageSize];
+        if (slot.compare_exchange_strong(page, fresh, std::memory_order_acq_rel))
+            page = fresh;
+        else
+            delete[] fresh;
+    }
+
+    return page[id & (Interner::PageSize - 1)];
+}
+
+SymbolId Interner::intern(std::string_view text) {
+    uint32_t hash  = Interner::_hash(text);
+    Shard&   shard = this->m_shards[hash >> (32 - Interner::ShardBits)];
+
+    std::lock_guard lock(shard.mutex);
+    size_t          mask = shard.slots.size() - 1;
+
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+        SymbolId id = shard.slots[i];
+
+        if (id == NoSymbol) {
+            size_t next = this->m_count.fetch_add(1, std::memory_order_relaxed);
+            if ((next >> Interner::PageBits) >= Interner::MaxPages) {
+                /* Give the id back, so the count stays the number of names held. */
+                this->m_count.fetch_sub(1, std::memory_order_relaxed);
+                throw std::length_error("Interner: too many identifiers");
+            }
+
+            id = static_cast<SymbolId>(next);
+            this->_new_entry(id) = Entry {shard.storage.copy_string(text), hash};
+            shard.slots[i] = id;
+
+            /* Keep load factor under 1/2. */
+            if (++shard.count * 2 > shard.slots.size())
+                this->_rehash(shard);
+            return id;
+        }
+
+        auto& entry = this->_entry(id);
+        if (entry.hash == hash && entry.text == text)
+            return id;
+    }
+}
+
+void Interner::clear() {
+    for (size_t page = 0; page < Interner::MaxPages; page++)
+        delete[] this->m_pages[page].exchange(nullptr, std::memory_order_relaxed);
+
+    for (auto& shard : this->m_shards) {
+        shard.storage.release();
+        shard.slots.assign(InitialSlots, NoSymbol);
+        shard.count = 0;
+    }
+
+    this->m_count.store(1, std::memory_order_relaxed);
+}
+
+std::string_view Interner::spelling(SymbolId id) const {
+    assert(id != NoSymbol);
+    return this->_entry(id).text;
+}
+
+uint32_t Interner::_hash(std::string_view text) {
+    /* FNV-1a */
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void Interner::_rehash(Shard& shard) const {
+    std::vector<SymbolId> slots(shard.slots.size() * 2, NoSymbol);
+    size_t mask = slots.size() - 1;
+
+    for (SymbolId id : shard.slots) {
+        if (id == NoSymbol)
+            continue;
+
+        size_t i = this->_entry(id).hash & mask;
+        while (slots[i] != NoSymbol)
+            i = (i + 1) & mask;
+        slots[i] = id;
+    }
+
+    shard.slots = std::move(slots);
+}
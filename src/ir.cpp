@@ -0,0 +1,93 @@
+#include "ir.hpp"
+
+#include <algorithm>
+
+#include "thread_pool.hpp"
+
+void compute_effects(IrProgram& program, ThreadPool* pool) {
+    std::vector<std::vector<uint32_t>> callees(program.functions.size());
+
+    auto unique = [](std::vector<uint32_t>& list) {
+        std::sort(list.begin(), list.end());
+        list.erase(std::unique(list.begin(), list.end()), list.end());
+    };
+
+    parallel_for(pool, program.functions.size(), [&](size_t, size_t f) {
+        IrFunction& fn = program.functions[f];
+        fn.reads .clear();
+        fn.writes.clear();
+        fn.returns = f > 0 && !fn.blocks[0].code.empty() && fn.blocks[0].code.back().op == IrOp::Ret;
+
+        for (auto& block : fn.blocks) {
+            for (auto& in : block.code) {
+                bool global = (in.op == IrOp::Load || in.op == IrOp::Store) &&
+                              program.vars[in.var].kind == IrVar::Global;
+
+                if (global && in.op == IrOp::Load)
+                    fn.reads.push_back(in.var);
+                else if (global)
+                    fn.writes.push_back(in.var);
+                else if (in.op == IrOp::Call && in.callee != f)
+                    callees[f].push_back(in.callee);
+            }
+        }
+
+        unique(fn.reads);
+        unique(fn.writes);
+        unique(callees[f]);
+    });
+
+    /* Other files only reach these globals through functions of this one. */
+    for (uint32_t f = 1; f < program.functions.size(); f++) {
+        if (!program.functions[f].external)
+            continue;
+        for (uint32_t g = 1; g < program.functions.size(); g++)
+            if (!program.functions[g].external)
+                callees[f].push_back(g);
+    }
+
+    /* A function that calls one that does not return does not return either. */
+    std::vector<std::vector<uint32_t>> callers(program.functions.size());
+    std::vector<uint32_t>              stuck;
+
+    for (uint32_t f = 1; f < program.functions.size(); f++) {
+        if (program.functions[f].external)
+            continue;                   // returns; its callbacks may not run at all
+        for (uint32_t callee : callees[f])
+            callers[callee].push_back(f);
+        if (!program.functions[f].returns)
+            stuck.push_back(f);
+    }
+
+    while (!stuck.empty()) {
+        uint32_t callee = stuck.back();
+        stuck.pop_back();
+
+        for (uint32_t caller : callers[callee]) {
+            if (program.functions[caller].returns) {
+                program.functions[caller].returns = false;
+                stuck.push_back(caller);
+            }
+        }
+    }
+
+    /* The top-level code is nobody's callee; its own accesses are enough. */
+    for (bool changed = true; changed; ) {
+        changed = false;
+        for (uint32_t f = 1; f < program.functions.size(); f++) {
+            IrFunction& fn     = program.functions[f];
+            size_t      reads  = fn.reads.size();
+            size_t      writes = fn.writes.size();
+
+            for (uint32_t callee : callees[f]) {
+                auto& from = program.functions[callee];
+                fn.reads .insert(fn.reads .end(), from.reads .begin(), from.reads .end());
+                fn.writes.insert(fn.writes.end(), from.writes.begin(), from.writes.end());
+            }
+
+            unique(fn.reads);
+            unique(fn.writes);
+            changed |= fn.reads.size() != reads || fn.writes.size() != writes;
+        }
+    }
+}
@@ -0,0 +1,557 @@
+#include "ir_builder.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <string>
+
+static std::runtime_error codegen_error(CodegenErrorType err, SymbolId name) {
+    return std::runtime_error("Codegen error: " + to_string(err) +
+                              " '" + std::string(spelling(name)) + "'");
+}
+
+IrProgram IrBuilder::build() {
+    /* functions[0] is the top-level code, then one per FunctionDeclNode. */
+    this->m_out.functions.emplace_back();
+    this->m_decls.push_back(nullptr);
+
+    for (auto* stmt : this->m_program.functions_and_statements) {
+        auto* decl = node_cast<FunctionDeclNode>(stmt);
+        if (!decl)
+            continue;
+
+        uint32_t index = static_cast<uint32_t>(this->m_out.functions.size());
+        this->m_out.functions.emplace_back().name = decl->name;
+        this->m_decls.push_back(decl);
+        this->m_globals.declare(decl->name, Binding {Binding::Function, index});
+    }
+
+    this->m_out.functions[0].blocks.emplace_back();
+    this->m_first_var.assign(this->m_decls.size(), 0);
+
+    /* The top-level code, in order; each function gets its VarIds where it stands. */
+    Translator  top(*this, 0, 0);
+    uint32_t    declared = 1;           // functions reached
+    std::string top_error;
+
+    for (auto* stmt : this->m_program.functions_and_statements) {
+        if (auto* decl = node_cast<FunctionDeclNode>(stmt)) {
+            this->m_first_var[declared++] = this->_reserve(*decl);
+            if (this->m_externals)
+                this->_prescan(*decl);
+            continue;
+        }
+
+        try {
+            top.statement(*stmt);
+        } catch (const std::runtime_error& e) {
+            top_error = e.what();       // later functions are not reached
+            break;
+        }
+    }
+
+    /* Then the bodies; an error in one of them came before the top-level code's. */
+    std::vector<std::string> errors(declared);
+    std::vector<size_t>      reordered(declared);
+    parallel_for(this->m_pool, declared - 1, [&](size_t, size_t i) {
+        uint32_t   index = static_cast<uint32_t>(i + 1);
+        Translator body(*this, index, this->m_first_var[index]);
+
+        try {
+            body.function(*this->m_decls[index]);
+        } catch (const std::runtime_error& e) {
+            errors[index] = e.what();
+        }
+        reordered[index] = body.reordered();
+    });
+
+    for (auto& error : errors)
+        if (!error.empty())
+            throw std::runtime_error(error);
+    if (!top_error.empty())
+        throw std::runtime_error(top_error);
+
+    top.finish();
+
+    this->m_reordered = top.reordered();
+    for (size_t count : reordered)
+        this->m_reordered += count;
+
+    compute_effects(this->m_out, this->m_pool);
+    return std::move(this->m_out);
+}
+
+/* Parameters, then one variable per `let` of the body. */
+uint32_t IrBuilder::_reserve(const FunctionDeclNode& node) {
+    size_t count = node.params.size();
+    for (auto* stmt : node.body)
+        count += stmt->kind == NodeKind::VarDecl;
+
+    auto first = static_cast<uint32_t>(this->m_out.vars.size());
+    this->m_out.vars.resize(first + count);
+    return first;
+}
+
+/*
+ * Declares the external functions node calls, as translating it
+ * in place would: in call order, for names neither its variables
+ * declared so far nor the globals above it bind.
+ */
+void IrBuilder::_prescan(const FunctionDeclNode& node) {
+    SymbolTable<Binding> locals;
+
+    for (auto& param : node.params)
+        locals.declare(param.name, Binding {Binding::Variable, 0});
+
+    for (auto* stmt : node.body) {
+        switch (stmt->kind) {
+            case NodeKind::VarDecl: {
+                auto& var = static_cast<const VarDeclNode&>(*stmt);
+                this->_prescan(*var.value, locals);
+                locals.declare(var.name, Binding {Binding::Variable, 0});
+                break;
+            }
+            case NodeKind::Assignment: this->_prescan(*static_cast<const AssignmentNode&>(*stmt).value, locals); break;
+            case NodeKind::Exit:       this->_prescan(*static_cast<const ExitNode&>(*stmt).value, locals);       break;
+            case NodeKind::ExprStmt:   this->_prescan(*static_cast<const ExprStmtNode&>(*stmt).expr, locals);    break;
+            default:                   break;
+        }
+    }
+}
+
+/* The calls in node, in evaluation order, from an explicit stack: +/- chains are as long as the source. */
+void IrBuilder::_prescan(const ASTNode& node, SymbolTable<Binding>& locals) {
+    auto& stack = this->m_prescan;
+    stack.assign(1, &node);
+
+    while (!stack.empty()) {
+        const ASTNode* next = stack.back();
+        stack.pop_back();
+
+        /* Children go on in reverse, so they come off in order. */
+        if (auto* call = node_cast<FunctionCallNode>(next)) {
+            if (!locals.lookup(call->name) && !this->m_globals.lookup(call->name))
+                this->_external(call->name, static_cast<uint32_t>(call->args.size()));
+            for (size_t i = call->args.size(); i > 0; i--)
+                stack.push_back(call->args[i - 1]);
+        } else if (auto* binary = node_cast<BinaryExprNode>(next)) {
+            stack.push_back(binary->right);
+            stack.push_back(binary->left);
+        }
+    }
+}
+
+/*
+ * The external function name, declared by its first call with
+ * that many parameters. Function bodies only ever find theirs:
+ * the prescan declared them, so the list is fixed while they run.
+ */
+uint32_t IrBuilder::_external(SymbolId name, uint32_t params) {
+    if (auto it = this->m_external_index.find(name); it != this->m_external_index.end())
+        return it->second;
+
+    auto index = static_cast<uint32_t>(this->m_out.functions.size());
+    this->m_external_index.emplace(name, index);
+    this->m_decls.push_back(nullptr);
+
+    IrFunction& fn = this->m_out.functions.emplace_back();
+    fn.name     = name;
+    fn.external = true;
+    for (uint32_t i = 0; i < params; i++) {
+        fn.params.push_back(static_cast<VarId>(this->m_out.vars.size()));
+        this->m_out.vars.push_back(IrVar {IrVar::Param, NoSymbol});
+    }
+    fn.blocks.emplace_back().code.push_back(IrInstr {.op = IrOp::Ret});
+
+    return index;
+}
+
+/* TRANSLATOR */
+
+IrBuilder::Translator::Translator(IrBuilder& builder, uint32_t index, VarId first_var)
+    : m_builder(builder), m_index(index), m_top(index == 0), m_next_var(first_var) {}
+
+void IrBuilder::Translator::function(const FunctionDeclNode& node) {
+    this->_fn().blocks.emplace_back();
+
+    for (auto& param : node.params)
+        this->_fn().params.push_back(this->_declare_var(IrVar::Param, param.name));
+
+    for (auto* stmt : node.body)
+        this->statement(*stmt);
+
+    /* The return belongs to the function, not its last statement. */
+    this->m_loc = node.offset;
+    if (!this->_terminated())
+        this->_emit(IrInstr {.op = IrOp::Ret});
+}
+
+void IrBuilder::Translator::finish() {
+    this->m_loc = NoLoc;
+    if (!this->_terminated())
+        this->_emit(IrInstr {.op = IrOp::Exit, .a = this->_emit(IrInstr {.op = IrOp::Const})});
+}
+
+void IrBuilder::Translator::statement(const ASTNode& node) {
+    /* Code after an exit still has to be valid; it goes in a block of its own. */
+    if (this->_terminated())
+        this->_fn().blocks.emplace_back();
+
+    this->m_loc = node.offset;
+    this->m_labels.clear();
+
+    switch (node.kind) {
+        case NodeKind::VarDecl: {
+            auto& var = static_cast<const VarDeclNode&>(node);
+            Value value = this->_expr(*var.value);
+            auto  kind  = this->m_top ? IrVar::Global : IrVar::Local;
+            this->_emit(IrInstr {.op = IrOp::Store, .a = value, .var = this->_declare_var(kind, var.name)});
+            break;
+        }
+
+        case NodeKind::Assignment: {
+            auto& assign = static_cast<const AssignmentNode&>(node);
+            Value value = this->_expr(*assign.value);
+            this->_emit(IrInstr {.op = IrOp::Store, .a = value, .var = this->_resolve_var(assign.name)});
+            break;
+        }
+
+        case NodeKind::Exit:
+            this->_emit(IrInstr {.op = IrOp::Exit, .a = this->_expr(*static_cast<const ExitNode&>(node).value)});
+            break;
+
+        case NodeKind::ExprStmt:
+            this->_expr(*static_cast<const ExprStmtNode&>(node).expr);
+            break;
+
+        default:
+            assert(false && "Not a statement");
+    }
+}
+
+Value IrBuilder::Translator::_expr(const ASTNode& node) {
+    switch (node.kind) {
+        case NodeKind::IntLiteral:
+            return this->_emit(IrInstr {.op = IrOp::Const, .imm = static_cast<const IntLiteralNode&>(node).value});
+
+        case NodeKind::Ident:
+            return this->_emit(IrInstr {.op = IrOp::Load,
+                                        .var = this->_resolve_var(static_cast<const IdentNode&>(node).name)});
+
+        case NodeKind::FunctionCall:
+            return this->_call(static_cast<const FunctionCallNode&>(node));
+
+        case NodeKind::BinaryExpr: {
+            auto& binary = static_cast<const BinaryExprNode&>(node);
+            if (this->m_builder.m_reorder)
+                return binary.op == TokenType::o_equal_equal ? this->_equality(binary) : this->_chain(binary);
+            return this->_in_order(binary);
+        }
+
+        default:
+            assert(false && "Not an expression");
+            return NoValue;
+    }
+}
+
+/*
+ * node's operators in source order, left operand first. Chains are
+ * left-deep and as long as the source, so the left operands are
+ * gathered on m_spine instead of being recursed into; only right
+ * operands recurse, as deep as the source nests parentheses.
+ */
+Value IrBuilder::Translator::_in_order(const BinaryExprNode& node) {
+    size_t         mark = this->m_spine.size();
+    const ASTNode* left = &node;
+    while (auto* binary = node_cast<BinaryExprNode>(left)) {
+        this->m_spine.push_back(binary);
+        left = binary->left;
+    }
+
+    /* Right operands push their own spines above mark and pop them again. */
+    Value value = this->_expr(*left);
+    while (this->m_spine.size() > mark) {
+        const BinaryExprNode* binary = this->m_spine.back();
+        this->m_spine.pop_back();
+
+        IrOp op;
+        switch (binary->op) {
+            case TokenType::o_plus:        op = IrOp::Add; break;
+            case TokenType::o_sub:         op = IrOp::Sub; break;
+            case TokenType::o_equal_equal: op = IrOp::Eq;  break;
+            default:
+                assert(false && "Unknown binary operator");
+                op = IrOp::Add;
+        }
+        Value right = this->_expr(*binary->right);
+        value = this->_emit(IrInstr {.op = op, .a = value, .b = right});
+    }
+    return value;
+}
+
+Value IrBuilder::Translator::_call(const FunctionCallNode& node) {
+    auto     binding = this->_lookup(node.name);
+    uint32_t callee;
+
+    if (!binding && this->m_builder.m_externals) {
+        callee = this->m_builder._external(node.name, static_cast<uint32_t>(node.args.size()));
+    } else {
+        if (!binding)
+            throw codegen_error(CodegenErrorType::UndeclaredFunction, node.name);
+        if (binding->kind != Binding::Function)
+            throw codegen_error(CodegenErrorType::NotAFunction, node.name);
+        callee = binding->index;
+    }
+
+    auto*  decl   = this->m_builder.m_decls[callee];
+    size_t params = decl ? decl->params.size() : this->m_builder.m_out.functions[callee].params.size();
+    if (node.args.size() != params)
+        throw codegen_error(CodegenErrorType::ArgumentCount, node.name);
+
+    /* Arguments may contain calls themselves; gather them before the call's own. */
+    std::vector<Value> args;
+    args.reserve(node.args.size());
+    for (auto* arg : node.args)
+        args.push_back(this->_expr(*arg));
+
+    IrInstr call {.op = IrOp::Call, .callee = callee,
+                  .args_begin = static_cast<uint32_t>(this->_fn().args.size()),
+                  .args_count = static_cast<uint32_t>(args.size())};
+    this->_fn().args.insert(this->_fn().args.end(), args.begin(), args.end());
+    this->_emit(call);
+
+    return this->_emit(IrInstr {.op = IrOp::Const});
+}
+
+Value IrBuilder::Translator::_equality(const BinaryExprNode& node) {
+    Label left  = this->_label(*node.left);
+    Label right = this->_label(*node.right);
+
+    Value a, b;
+    if (left.pure && right.pure && right.need > left.need) {
+        b = this->_expr(*node.right);
+        a = this->_expr(*node.left);
+        this->m_reordered++;
+    } else {
+        a = this->_expr(*node.left);
+        b = this->_expr(*node.right);
+    }
+    return this->_emit(IrInstr {.op = IrOp::Eq, .a = a, .b = b});
+}
+
+Value IrBuilder::Translator::_chain(const BinaryExprNode& node) {
+    size_t mark = this->m_terms.size();
+    this->_flatten(node);
+    this->m_reordered += this->_order(mark);
+
+    /* Terms evaluate nested chains, which push past end and resize back. */
+    size_t end = this->m_terms.size();
+    Value  sum = NoValue;
+    for (size_t i = mark; i < end; i++) {
+        Term  term  = this->m_terms[i];
+        Value value = this->_expr(*term.node);
+
+        if (i > mark)
+            sum = this->_emit(IrInstr {.op = term.negative ? IrOp::Sub : IrOp::Add, .a = sum, .b = value});
+        else if (term.negative)
+            sum = this->_emit(IrInstr {.op = IrOp::Sub, .a = this->_emit(IrInstr {.op = IrOp::Const}), .b = value});
+        else
+            sum = value;
+    }
+
+    this->m_terms.resize(mark);
+    return sum;
+}
+
+IrBuilder::Label IrBuilder::Translator::_label(const ASTNode& node) {
+    switch (node.kind) {
+        case NodeKind::IntLiteral:
+            return Label {static_cast<const IntLiteralNode&>(node).value == 0 ? 0u : 1u, true};     // 0 is r0
+
+        case NodeKind::Ident:
+            return Label {1, true};
+
+        default:
+            break;
+    }
+
+    if (auto it = this->m_labels.find(&node); it == this->m_labels.end())
+        this->_label_tree(node);
+    return this->m_labels.at(&node);
+}
+
+/*
+ * Labels node and every call and expression below it, children
+ * before parents, from an explicit stack: chains are as long as
+ * the source. Operators inside a chain get no label of their own;
+ * the chain is labelled once, at its root, from its terms.
+ */
+void IrBuilder::Translator::_label_tree(const ASTNode& node) {
+    auto&  stack = this->m_pending;
+    size_t mark  = stack.size();
+    stack.push_back(Pending {&node, false, false});
+
+    while (stack.size() > mark) {
+        Pending next = stack.back();
+        stack.pop_back();
+
+        if (next.node->kind == NodeKind::IntLiteral || next.node->kind == NodeKind::Ident ||
+            this->m_labels.count(next.node))
+            continue;
+
+        auto* binary = node_cast<BinaryExprNode>(next.node);
+        bool  chain  = binary && binary->op != TokenType::o_equal_equal;
+
+        if (!next.ready) {
+            stack.push_back(Pending {next.node, true, next.inner});
+            if (binary) {
+                stack.push_back(Pending {binary->right, false, chain});
+                stack.push_back(Pending {binary->left,  false, chain});
+            } else if (auto* call = node_cast<FunctionCallNode>(next.node)) {
+                for (auto* arg : call->args)
+                    stack.push_back(Pending {arg, false, false});
+            }
+            continue;
+        }
+
+        if (!(chain && next.inner))
+            this->m_labels.emplace(next.node, this->_label_node(*next.node));
+    }
+}
+
+/* node's label, from its children's; see _label_tree(). */
+IrBuilder::Label IrBuilder::Translator::_label_node(const ASTNode& node) {
+    if (auto* call = node_cast<FunctionCallNode>(&node)) {
+        /* Arguments are evaluated in order and held until the call; it evaluates to a constant. */
+        uint32_t need = 1, i = 0;
+        for (auto* arg : call->args)
+            need = std::max(need, this->_label(*arg).need + i++);
+        return Label {need, false};
+    }
+
+    assert(node.kind == NodeKind::BinaryExpr && "Not an expression");
+
+    auto& binary = static_cast<const BinaryExprNode&>(node);
+    Label label;
+    if (binary.op == TokenType::o_equal_equal) {
+        Label left  = this->_label(*binary.left);
+        Label right = this->_label(*binary.right);
+        label.pure  = left.pure && right.pure;
+
+        /* Both orders need the larger side's registers; equal sides need one more to hold the first. */
+        if (!label.pure)
+            label.need = std::max(left.need, right.need + 1);
+        else
+            label.need = left.need == right.need ? left.need + 1 : std::max(left.need, right.need);
+    } else {
+        size_t mark = this->m_terms.size();
+        this->_flatten(binary);
+        this->_order(mark);
+
+        /* Summed left to right, every term but the first also needs the running sum. */
+        label = Label {0, true};
+        for (size_t i = mark; i < this->m_terms.size(); i++) {
+            label.need  = std::max(label.need, this->m_terms[i].label.need + (i > mark));
+            label.pure &= this->m_terms[i].label.pure;
+        }
+        this->m_terms.resize(mark);
+    }
+    return label;
+}
+
+/* Appends the signed terms of the chain at root to m_terms, in source order, without recursing on the chain. */
+void IrBuilder::Translator::_flatten(const BinaryExprNode& root) {
+    size_t mark = this->m_walk.size();
+    this->m_walk.emplace_back(&root, false);
+
+    while (this->m_walk.size() > mark) {
+        auto [node, negative] = this->m_walk.back();
+        this->m_walk.pop_back();
+
+        auto* binary = node_cast<BinaryExprNode>(node);
+        if (binary && (binary->op == TokenType::o_plus || binary->op == TokenType::o_sub)) {
+            /* Right first, so the left side comes off the stack first. */
+            this->m_walk.emplace_back(binary->right, negative != (binary->op == TokenType::o_sub));
+            this->m_walk.emplace_back(binary->left,  negative);
+            continue;
+        }
+
+        this->m_terms.push_back(Term {node, negative, this->_label(*node)});
+    }
+}
+
+bool IrBuilder::Translator::_order(size_t mark) {
+    auto begin = this->m_terms.begin() + static_cast<ptrdiff_t>(mark);
+    auto end   = this->m_terms.end();
+
+    if (!std::all_of(begin, end, [](const Term& t) { return t.label.pure; }))
+        return false;
+
+    /* The heaviest terms go first, then a positive term leads if there is one, sparing the 0 - x. */
+    auto heavier = [](const Term& x, const Term& y) { return x.label.need > y.label.need; };
+    bool moved   = false;
+    if (!std::is_sorted(begin, end, heavier)) {
+        std::stable_sort(begin, end, heavier);
+        moved = true;
+    }
+    if (begin->negative) {
+        auto positive = std::find_if(begin, end, [](const Term& t) { return !t.negative; });
+        if (positive != end) {
+            std::rotate(begin, positive, positive + 1);
+            moved = true;
+        }
+    }
+    return moved;
+}
+
+/* A function's own variables, then functions and the globals declared above it. */
+std::optional<IrBuilder::Binding> IrBuilder::Translator::_lookup(SymbolId name) const {
+    if (!this->m_top) {
+        if (auto local = this->m_locals.lookup(name))
+            return local;
+    }
+
+    auto global = this->m_builder.m_globals.lookup(name);
+    if (global && global->kind == Binding::Variable && !this->m_top &&
+        global->index >= this->m_builder.m_first_var[this->m_index])
+        return std::nullopt;
+    return global;
+}
+
+bool IrBuilder::Translator::_terminated() const {
+    auto& code = this->_fn().blocks.back().code;
+    return !code.empty() && code.back().terminator();
+}
+
+VarId IrBuilder::Translator::_declare_var(IrVar::Kind kind, SymbolId name) {
+    auto& vars = this->m_builder.m_out.vars;
+    VarId var;
+
+    if (this->m_top) {
+        var = static_cast<VarId>(vars.size());
+        vars.push_back(IrVar {kind, name});
+        this->m_builder.m_globals.declare(name, Binding {Binding::Variable, var});
+    } else {
+        var       = this->m_next_var++;
+        vars[var] = IrVar {kind, name};
+        this->m_locals.declare(name, Binding {Binding::Variable, var});
+    }
+    return var;
+}
+
+VarId IrBuilder::Translator::_resolve_var(SymbolId name) {
+    auto var = this->_lookup(name);
+    if (!var)
+        throw codegen_error(CodegenErrorType::UndeclaredIdentifier, name);
+    if (var->kind == Binding::Function)
+        throw codegen_error(CodegenErrorType::NotAVariable, name);
+    return var->index;
+}
+
+Value IrBuilder::Translator::_emit(IrInstr instr) {
+    if (instr.pure())
+        instr.dest = this->_fn().new_value();
+    instr.loc = this->m_loc;
+
+    this->_fn().blocks.back().code.push_back(instr);
+    return instr.dest;
+}
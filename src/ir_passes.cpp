@@ -0,0 +1,229 @@
+#include "ir_passes.hpp"
+
+#include <algorithm>
+
+#include "ir_printer.hpp"
+
+enum : uint8_t { Unknown, Live, Dead };
+
+void IrOptimizer::run(std::ostream* dump) {
+    struct Pass {
+        const char* name;
+        size_t (IrOptimizer::*run)(IrFunction&, Scratch&) const;
+        size_t IrOptimizer::*counter;
+    };
+
+    static constexpr Pass Passes[] = {
+        {"copy propagation",          &IrOptimizer::_propagate_copies, &IrOptimizer::m_forwarded},
+        {"dead store elimination",    &IrOptimizer::_dead_stores,      &IrOptimizer::m_dead_stores},
+        {"dead code elimination",     &IrOptimizer::_dead_code,        &IrOptimizer::m_dead_code},
+    };
+
+    this->m_scratch.resize(slots(this->m_pool));
+    for (auto& scratch : this->m_scratch) {
+        scratch.known.assign(this->m_program.vars.size(), NoValue);
+        scratch.live .assign(this->m_program.vars.size(), Unknown);
+    }
+
+    if (dump) {
+        *dump << "; built\n";
+        IrPrinter(*dump, this->m_program).print();
+    }
+
+    for (bool changed = true; changed; ) {
+        changed = false;
+
+        for (auto& pass : Passes) {
+            std::vector<size_t> counts(this->m_scratch.size());
+            parallel_for(this->m_pool, this->m_program.functions.size(), [&](size_t slot, size_t f) {
+                counts[slot] += (this->*pass.run)(this->m_program.functions[f], this->m_scratch[slot]);
+            });
+
+            size_t count = 0;
+            for (size_t n : counts)
+                count += n;
+
+            if (count == 0)
+                continue;
+
+            this->*pass.counter += count;
+            changed = true;
+            compute_effects(this->m_program, this->m_pool);
+
+            if (dump) {
+                *dump << "\n; after " << pass.name << " (" << count << ")\n";
+                IrPrinter(*dump, this->m_program).print();
+            }
+        }
+    }
+}
+
+size_t IrOptimizer::_propagate_copies(IrFunction& fn, Scratch& s) const {
+    size_t count = 0;
+    s.replace.assign(fn.next_value, NoValue);
+
+    auto resolve = [&](Value& value) {
+        if (value != NoValue && s.replace[value] != NoValue)
+            value = s.replace[value];
+    };
+
+    for (auto& block : fn.blocks) {
+        s.remove.assign(block.code.size(), false);
+
+        for (size_t i = 0; i < block.code.size(); i++) {
+            IrInstr& in = block.code[i];
+            resolve(in.a);
+            resolve(in.b);
+
+            switch (in.op) {
+                case IrOp::Load:
+                    if (s.known[in.var] != NoValue) {
+                        s.replace[in.dest] = s.known[in.var];
+                        s.remove[i] = true;
+                        count++;
+                    } else {
+                        s.known[in.var] = in.dest;
+                        s.touched.push_back(in.var);
+                    }
+                    break;
+
+                case IrOp::Store:
+                    s.known[in.var] = in.a;
+                    s.touched.push_back(in.var);
+                    break;
+
+                case IrOp::Call:
+                    for (uint32_t k = 0; k < in.args_count; k++)
+                        resolve(fn.args[in.args_begin + k]);
+                    for (VarId var : this->m_program.functions[in.callee].writes)
+                        s.known[var] = NoValue;
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        IrOptimizer::_compact(block.code, s.remove);
+
+        for (VarId var : s.touched)
+            s.known[var] = NoValue;
+        s.touched.clear();
+    }
+
+    return count;
+}
+
+size_t IrOptimizer::_dead_stores(IrFunction& fn, Scratch& s) const {
+    size_t count = 0;
+
+    for (auto& block : fn.blocks) {
+        bool returns = !block.code.empty() && block.code.back().op == IrOp::Ret;
+
+        /* Whether a store to var now would be observed. */
+        auto live = [&](VarId var) {
+            if (s.live[var] == Unknown)
+                return returns && this->m_program.vars[var].kind == IrVar::Global;
+            return s.live[var] == Live;
+        };
+
+        auto set = [&](VarId var, uint8_t state) {
+            if (s.live[var] == Unknown)
+                s.touched.push_back(var);
+            s.live[var] = state;
+        };
+
+        s.remove.assign(block.code.size(), false);
+
+        for (size_t i = block.code.size(); i-- > 0; ) {
+            IrInstr& in = block.code[i];
+
+            switch (in.op) {
+                case IrOp::Store:
+                    if (!live(in.var)) {
+                        s.remove[i] = true;
+                        count++;
+                    } else {
+                        set(in.var, Dead);
+                    }
+                    break;
+
+                case IrOp::Load:
+                    set(in.var, Live);
+                    break;
+
+                case IrOp::Call: {
+                    /* Straight-line code: a callee that returns has done all its writes. */
+                    auto& callee = this->m_program.functions[in.callee];
+                    for (VarId var : callee.writes)
+                        set(var, Dead);
+                    for (VarId var : callee.reads)
+                        set(var, Live);
+                    break;
+                }
+
+                default:
+                    break;
+            }
+        }
+
+        IrOptimizer::_compact(block.code, s.remove);
+
+        for (VarId var : s.touched)
+            s.live[var] = Unknown;
+        s.touched.clear();
+    }
+
+    return count;
+}
+
+size_t IrOptimizer::_dead_code(IrFunction& fn, Scratch& s) const {
+    size_t count = 0;
+
+    for (size_t b = 1; b < fn.blocks.size(); b++)
+        count += fn.blocks[b].code.size();
+    fn.blocks.resize(1);
+
+    auto& code = fn.blocks[0].code;
+    s.used  .assign(fn.next_value, false);
+    s.remove.assign(code.size(), false);
+
+    /* Nothing after a call that never returns runs either. */
+    for (size_t i = 0; i < code.size(); i++) {
+        if (code[i].op == IrOp::Call && !this->m_program.functions[code[i].callee].returns) {
+            std::fill(s.remove.begin() + i + 1, s.remove.end(), true);
+            break;
+        }
+    }
+
+    for (size_t i = code.size(); i-- > 0; ) {
+        const IrInstr& in = code[i];
+
+        if (s.remove[i])
+            continue;
+
+        if (in.pure() && !s.used[in.dest]) {
+            s.remove[i] = true;
+            continue;
+        }
+
+        if (in.a != NoValue) s.used[in.a] = true;
+        if (in.b != NoValue) s.used[in.b] = true;
+        for (uint32_t k = 0; k < in.args_count; k++)
+            s.used[fn.args[in.args_begin + k]] = true;
+    }
+
+    return count + IrOptimizer::_compact(code, s.remove);
+}
+
+size_t IrOptimizer::_compact(std::vector<IrInstr>& code, const std::vector<uint8_t>& remove) {
+    size_t out = 0;
+    for (size_t i = 0; i < code.size(); i++) {
+        if (!remove[i])
+            code[out++] = code[i];
+    }
+
+    size_t removed = code.size() - out;
+    code.resize(out);
+    return removed;
+}
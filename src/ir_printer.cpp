@@ -0,0 +1,117 @@
+#include "ir_printer.hpp"
+
+#include <unordered_map>
+
+IrPrinter::IrPrinter(std::ostream& os, const IrProgram& program)
+    : m_os(os), m_program(program) {
+    std::unordered_map<SymbolId, uint32_t> uses;
+    for (auto& var : program.vars)
+        uses[var.name]++;
+
+    this->m_shared.reserve(program.vars.size());
+    for (auto& var : program.vars)
+        this->m_shared.push_back(uses[var.name] > 1);
+}
+
+void IrPrinter::print() {
+    for (size_t i = 0; i < this->m_program.functions.size(); i++) {
+        if (i > 0)
+            this->m_os.put('\n');
+        this->print(this->m_program.functions[i]);
+    }
+}
+
+void IrPrinter::print(const IrFunction& fn) {
+    if (fn.external) {
+        this->m_os << "extern fn " << spelling(fn.name) << '/' << fn.params.size() << '\n';
+        return;
+    }
+
+    if (fn.name == NoSymbol) {
+        this->m_os << "top-level";
+    } else {
+        this->m_os << "fn " << spelling(fn.name) << '(';
+        for (size_t i = 0; i < fn.params.size(); i++) {
+            if (i > 0) this->m_os << ", ";
+            this->_var(fn.params[i]);
+        }
+        this->m_os.put(')');
+
+        if (!fn.reads.empty() || !fn.writes.empty()) {
+            this->m_os << "\t; reads";
+            this->_vars(fn.reads);
+            this->m_os << "  writes";
+            this->_vars(fn.writes);
+        }
+    }
+    this->m_os.put('\n');
+
+    for (size_t b = 0; b < fn.blocks.size(); b++) {
+        this->m_os << "bb" << b << ":\n";
+        for (auto& in : fn.blocks[b].code)
+            this->_instr(fn, in);
+    }
+}
+
+void IrPrinter::_instr(const IrFunction& fn, const IrInstr& in) {
+    this->m_os << "    ";
+    if (in.dest != NoValue)
+        this->m_os << '%' << in.dest << " = ";
+    this->m_os << to_string(in.op);
+
+    switch (in.op) {
+        case IrOp::Const:
+            this->m_os << ' ' << in.imm;
+            break;
+
+        case IrOp::Add:
+        case IrOp::Sub:
+        case IrOp::Eq:
+            this->m_os << " %" << in.a << ", %" << in.b;
+            break;
+
+        case IrOp::Load:
+            this->m_os.put(' ');
+            this->_var(in.var);
+            break;
+
+        case IrOp::Store:
+            this->m_os.put(' ');
+            this->_var(in.var);
+            this->m_os << ", %" << in.a;
+            break;
+
+        case IrOp::Call:
+            this->m_os << ' ' << spelling(this->m_program.functions[in.callee].name) << '(';
+            for (uint32_t i = 0; i < in.args_count; i++) {
+                if (i > 0) this->m_os << ", ";
+                this->m_os << '%' << fn.args[in.args_begin + i];
+            }
+            this->m_os.put(')');
+            break;
+
+        case IrOp::Exit:
+            this->m_os << " %" << in.a;
+            break;
+
+        case IrOp::Ret:
+            break;
+    }
+
+    this->m_os.put('\n');
+}
+
+void IrPrinter::_var(VarId var) {
+    this->m_os << '$' << spelling(this->m_program.vars[var].name);
+    if (this->m_shared[var])
+        this->m_os << '.' << var;
+}
+
+void IrPrinter::_vars(const std::vector<VarId>& vars) {
+    if (vars.empty())
+        this->m_os << " -";
+    for (VarId var : vars) {
+        this->m_os.put(' ');
+        this->_var(var);
+    }
+}
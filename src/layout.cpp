@@ -0,0 +1,104 @@
+#include "layout.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+Layout::Layout(const MProgram& program)
+    : m_program(program) {
+    this->m_address.assign(program.labels.size(), Undefined);
+    this->_order_data();
+
+    if (this->m_data.size() > static_cast<size_t>(lc2k::MaxOffset))
+        throw std::runtime_error("Assembler error: program has " + std::to_string(this->m_data.size()) +
+                                 " data words, lw and sw reach " + std::to_string(lc2k::MaxOffset));
+
+    uint32_t pc = this->has_jump() ? 1 : 0;
+    for (const DataWord* word : this->m_data)
+        this->m_address[word->label] = pc++;
+
+    MInstr seq[MaxExpansion];
+    for (auto& fn : program.functions) {
+        if (fn.entry != NoLabel && !fn.code.empty())
+            this->m_address[fn.entry] = pc;
+        for (auto& in : fn.code)
+            pc += expand(in, seq);
+    }
+
+    this->m_size = pc;
+    this->_check();
+}
+
+MInstr Layout::jump() const {
+    return MInstr {.op = Opcode::beq, .a = lc2k::ZeroReg, .b = lc2k::ZeroReg,
+                   .offset = static_cast<int32_t>(this->m_data.size())};
+}
+
+/* By how many instructions name each word; ties keep program data, then each function's, in order. */
+void Layout::_order_data() {
+    std::vector<uint32_t> uses(this->m_program.labels.size(), 0);
+    for (auto& fn : this->m_program.functions)
+        for (auto& in : fn.code)
+            if (in.label != NoLabel)
+                uses[in.label]++;
+
+    for (auto& word : this->m_program.data)
+        this->m_data.push_back(&word);
+    for (auto& fn : this->m_program.functions)
+        for (auto& word : fn.data)
+            this->m_data.push_back(&word);
+
+    std::stable_sort(this->m_data.begin(), this->m_data.end(), [&](const DataWord* x, const DataWord* y) {
+        return uses[x->label] > uses[y->label];
+    });
+}
+
+uint32_t Layout::address(LabelId label) const {
+    uint32_t address = this->m_address[label];
+    if (address == Undefined) {
+        const Label& l = this->m_program.labels[label];
+        throw std::runtime_error(std::string("Assembler error: undefined label ") +
+                                 LabelPrefix[static_cast<size_t>(l.kind)] + std::to_string(l.index));
+    }
+    return address;
+}
+
+int64_t Layout::offset(const MInstr& in, uint32_t pc) const {
+    int64_t offset = in.offset;
+    if (in.label != NoLabel) {
+        offset += this->address(in.label);
+        if (in.op == Opcode::beq)
+            offset -= static_cast<int64_t>(pc) + 1;
+    }
+    return offset;
+}
+
+/* Everything the encoder would reject, before a single line of text is written. */
+void Layout::_check() const {
+    if (this->m_size > lc2k::MemorySize)
+        throw std::runtime_error("Assembler error: program needs " + std::to_string(this->m_size) +
+                                 " words of memory, LC2K has " + std::to_string(lc2k::MemorySize));
+
+    uint32_t pc = this->has_jump() ? 1 + static_cast<uint32_t>(this->m_data.size()) : 0;
+    MInstr   seq[MaxExpansion];
+
+    for (auto& fn : this->m_program.functions) {
+        for (auto& in : fn.code) {
+            int n = expand(in, seq);
+            for (int k = 0; k < n; k++, pc++) {
+                const MInstr& e = seq[k];
+                if (e.op != Opcode::lw && e.op != Opcode::sw && e.op != Opcode::beq)
+                    continue;
+
+                int64_t offset = this->offset(e, pc);
+                if (offset < lc2k::MinOffset || offset > lc2k::MaxOffset)
+                    throw std::runtime_error("Assembler error: offset " + std::to_string(offset) +
+                                             " at address " + std::to_string(pc) + " does not fit in 16 bits");
+            }
+        }
+    }
+
+    for (const DataWord* word : this->m_data)
+        if (word->value_label != NoLabel)
+            this->address(word->value_label);
+}
@@ -1,47 +1,778 @@
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <unordered_map>
 
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "source_buffer.hpp"
 #include "tokenizer.hpp"
+#include "pipelined_tokenizer.hpp"
 #include "parser.hpp"
+#include "ast_printer.hpp"
+#include "const_fold.hpp"
+#include "ir_builder.hpp"
+#include "ir_passes.hpp"
+#include "ir_printer.hpp"
+#include "codegen.hpp"
+#include "regalloc.hpp"
+#include "peephole.hpp"
+#include "asm_writer.hpp"
+#include "object_file.hpp"
+#include "linker.hpp"
+#include "assembler.hpp"
+#include "text_assembler.hpp"
+#include "simulator.hpp"
+#include "profiler.hpp"
+#include "stats.hpp"
+#include "thread_pool.hpp"
+#include "compile_server.hpp"
 
 static inline std::string CRIT = "Critical";
 static inline std::string ERR  = "Error";
 static inline std::string WARN = "Warn";
 static inline std::string INFO = "Info";
 
-static inline void print_message(const std::string& type, const std::string& msg) {
-    std::cout << "[LCC] " << type << ": " << msg << "\n";
+static inline void print_message(std::ostream& os, const std::string& type, const std::string& msg) {
+    os << "[LCC] " << type << ": " << msg << "\n";
 }
 
-static inline void print_exit(const std::string& type, const std::string& msg) {
-    print_message(type, msg);
-    exit(1);
+/* Ends the command with a message of type; thrown rather than exiting, so lcc --server survives it. */
+struct Fatal : std::runtime_error {
+    std::string type;
+
+    Fatal(const std::string& type, const std::string& msg)
+        : std::runtime_error(msg), type(type) {}
+};
+
+struct Options {
+    std::vector<std::string> inputs;    // compiled in parallel when there are several; "-" is stdin
+    std::vector<std::string> objects;   // --link: the objects, entry first
+    size_t             jobs         = 0;       // -j: threads for files and functions, 0 = one per hardware thread
+    bool               compile_only = false;   // -c: write an object instead of a program
+    bool               link         = false;   // link objects instead of compiling
+    bool               pipeline     = false;   // lex on a separate thread
+    bool               print_ast    = false;   // print the AST instead of compiling
+    bool               print_ir     = false;   // print the IR instead of compiling
+    bool               ir_passes    = false;   // ... after every pass
+    bool               optimize     = true;    // -O0 turns the AST and IR passes, and expression reordering, off
+    bool               machine_code = false;   // write machine code (.mc) instead of assembly
+    bool               check_mc     = false;   // ... and check it against the assembly, assembled as text
+    bool               run          = false;   // run the program instead of printing it
+    uint64_t           max_steps    = UINT64_MAX;
+    bool               profile      = false;   // ... and report where it spent its time
+    Profiler::Format   profile_format = Profiler::Format::Flat;
+    AstPrinter::Format ast_format   = AstPrinter::Format::Text;
+    bool               stats        = false;   // per-phase report on stderr
+    Stats::Format      stats_format = Stats::Format::Text;
+    const std::string* stdin_text   = nullptr; // the source for "-" if not std::cin (a client's)
+};
+
+/*
+ * Charges token reads to the "lex" phase and counts them. Only
+ * installed with --stats, so the normal path has no extra timer
+ * calls. With --pipeline "lex" is the time spent waiting on the
+ * lexer thread, not the lexer's own work.
+ */
+class CountingTokenSource : public TokenSource {
+public:
+    explicit CountingTokenSource(TokenSource& inner)
+        : m_inner(inner) {}
+
+    size_t read_tokens(Token* out, size_t max) override {
+        PhaseTimer timer("lex");
+        size_t count = this->m_inner.read_tokens(out, max);
+        this->m_count += count;
+        return count;
+    }
+
+    size_t count() const { return this->m_count; }
+
+private:
+    TokenSource& m_inner;
+    size_t       m_count = 0;
+};
+
+static Options parse_args(const std::vector<std::string>& args) {
+    Options opts;
+
+    for (size_t i = 0; i < args.size(); i++) {
+        const std::string& arg = args[i];
+
+        if (arg == "--pipeline")
+            opts.pipeline = true;
+        else if (arg == "--ast" || arg == "--ast=text") {
+            opts.print_ast  = true;
+            opts.ast_format = AstPrinter::Format::Text;
+        }
+        else if (arg == "--ast=sexpr") {
+            opts.print_ast  = true;
+            opts.ast_format = AstPrinter::Format::SExpr;
+        }
+        else if (arg == "--ast=json") {
+            opts.print_ast  = true;
+            opts.ast_format = AstPrinter::Format::Json;
+        }
+        else if (arg == "--ir")
+            opts.print_ir = true;
+        else if (arg == "--ir=passes") {
+            opts.print_ir  = true;
+            opts.ir_passes = true;
+        }
+        else if (arg == "--mc" || arg == "--mc=check") {
+            opts.machine_code = true;
+            opts.check_mc     = arg == "--mc=check";
+        }
+        else if (arg == "-c")
+            opts.compile_only = true;
+        else if (arg == "--link")
+            opts.link = true;
+        else if (arg == "--run")
+            opts.run = true;
+        else if (arg == "--profile" || arg == "--profile=flat" || arg == "--profile=collapsed") {
+            opts.run            = true;
+            opts.profile        = true;
+            opts.profile_format = arg == "--profile=collapsed" ? Profiler::Format::Collapsed
+                                                               : Profiler::Format::Flat;
+        }
+        else if (arg.rfind("--max-steps=", 0) == 0) {
+            try {
+                opts.max_steps = std::stoull(arg.substr(12));
+            } catch (const std::exception&) {
+                throw Fatal(ERR, "Bad instruction limit " + arg);
+            }
+        }
+        else if (arg.rfind("-j", 0) == 0) {
+            std::string count = arg.size() > 2 ? arg.substr(2) : i + 1 < args.size() ? args[++i] : "";
+            size_t      limit = ThreadPool::hardware_threads();
+
+            /* Signed, so -j-3 is refused rather than wrapped; all of it must be the number. */
+            long long jobs = 0;
+            size_t    used = 0;
+            try {
+                jobs = std::stoll(count, &used);
+            } catch (const std::exception&) {
+                used = 0;
+            }
+            if (used == 0 || used != count.size())
+                throw Fatal(ERR, "Bad job count " + count);
+            if (jobs < 1 || static_cast<unsigned long long>(jobs) > limit)
+                throw Fatal(ERR, "Job count " + count + " is not between 1 and " + std::to_string(limit));
+            opts.jobs = static_cast<size_t>(jobs);
+        }
+        else if (arg == "-O0" || arg == "-O1")
+            opts.optimize = arg == "-O1";
+        else if (arg == "--stats" || arg == "--time-report")
+            opts.stats = true;
+        else if (arg == "--stats=json") {
+            opts.stats        = true;
+            opts.stats_format = Stats::Format::Json;
+        }
+        else if (arg.rfind("-", 0) == 0 && arg != "-")
+            throw Fatal(ERR, "Unknown option " + arg);
+        else if (opts.link)
+            opts.objects.push_back(arg);
+        else
+            opts.inputs.push_back(arg);
+    }
+
+    if (opts.link ? opts.objects.empty() : opts.inputs.empty())
+        throw Fatal(CRIT, "No input files");
+    if (opts.link && (opts.compile_only || !opts.inputs.empty()))
+        throw Fatal(ERR, "--link takes objects, not sources");
+    if (opts.link && (opts.print_ast || opts.print_ir || opts.profile))
+        throw Fatal(ERR, "--link cannot print the AST or IR, or profile");
+    if (opts.compile_only && (opts.run || opts.machine_code))
+        throw Fatal(ERR, "-c writes an object; link it to run it");
+    if (opts.inputs.size() > 1 && std::count(opts.inputs.begin(), opts.inputs.end(), "-"))
+        throw Fatal(ERR, "Only a single input can be read from stdin");
+
+    return opts;
 }
 
-int main(int argc, char **argv) {
-    if (argc < 2)
-        print_exit(CRIT, "No input files");
+static std::vector<int32_t> assemble(Assembler& assembler) {
+    PhaseTimer timer("assemble");
+    return assembler.assemble();
+}
+
+/* The text path: write the assembly, assemble it as a separate assembler would, compare. */
+static void check_machine_code(const MProgram& program, const std::vector<int32_t>& image) {
+    PhaseTimer timer("check");
+
+    std::ostringstream text;
+    AsmWriter(text, program).write();
+
+    std::vector<int32_t> reference;
+    try {
+        reference = TextAssembler(text.view()).assemble();
+    } catch (const std::runtime_error& e) {
+        throw std::runtime_error(std::string("Machine code check: ") + e.what());
+    }
+
+    size_t n = std::min(image.size(), reference.size());
+    for (size_t address = 0; address < n; address++) {
+        if (image[address] != reference[address])
+            throw std::runtime_error("Machine code check: address " + std::to_string(address) + " is " +
+                                     std::to_string(image[address]) + ", assembled from text " +
+                                     std::to_string(reference[address]));
+    }
+    if (image.size() != reference.size())
+        throw std::runtime_error("Machine code check: " + std::to_string(image.size()) +
+                                 " words, assembled from text " + std::to_string(reference.size()));
+}
+
+/*
+ * Runs, or writes as machine code or assembly, a finished program.
+ * source is the file it was compiled from (named input), for
+ * --profile; NULL for a linked program.
+ */
+static void emit(const Options& opts, const MProgram& program, const SourceBuffer* source,
+                 const std::string& input, std::ostream& out) {
+    Stats& stats = Stats::global();
+
+    if (opts.run) {
+        Assembler            assembler(program);
+        std::vector<int32_t> image = assemble(assembler);
+
+        Simulator sim(image);
+        {
+            PhaseTimer timer("run");
+            if (opts.profile)
+                sim.profile(opts.max_steps);
+            else
+                sim.run(opts.max_steps);
+        }
+
+        /* Collapsed stacks go to flame graph tools as they are. */
+        if (!opts.profile || opts.profile_format == Profiler::Format::Flat)
+            sim.report(out);
+
+        if (opts.profile) {
+            PhaseTimer timer("output");
+            LineMap lines(source->view());
+            if (opts.profile_format == Profiler::Format::Flat)
+                out << '\n';
+            Profiler(sim, assembler.source_map(), lines, input).report(out, opts.profile_format);
+        }
+        out.flush();
+
+        if (opts.stats) {
+            stats.count("assemble", "words",        image.size());
+            stats.count("run",      "instructions", sim.instructions());
+        }
+    } else if (opts.machine_code) {
+        Assembler            assembler(program);
+        std::vector<int32_t> image = assemble(assembler);
+
+        if (opts.check_mc)
+            check_machine_code(program, image);
+
+        {
+            PhaseTimer timer("output");
+            write_machine_code(out, image);
+            out.flush();
+        }
+
+        if (opts.stats)
+            stats.count("output", "words", image.size());
+    } else {
+        AsmWriter writer(out, program);
+        {
+            PhaseTimer timer("output");
+            writer.write();
+            out.flush();
+        }
+
+        if (opts.stats)
+            stats.count("output", "words", writer.words());
+    }
+}
+
+/* lcc --link: read the objects, link them, and emit the program to out. Throws like compile(). */
+static void link(const Options& opts, std::ostream& out) {
+    Stats&              stats = Stats::global();
+    std::vector<Object> objects;
+
+    {
+        PhaseTimer timer("read");
+        for (auto& path : opts.objects) {
+            std::optional<SourceBuffer> text = SourceBuffer::open(path);
+            if (!text)
+                throw std::runtime_error("Cannot open file " + path);
+
+            objects.push_back(read_object(text->view(), path));
+        }
+    }
+
+    Linker   linker(std::move(objects));
+    MProgram program;
+    {
+        PhaseTimer timer("link");
+        program = linker.link();
+    }
+
+    if (opts.stats) {
+        stats.count("link", "objects",  opts.objects.size());
+        stats.count("link", "stripped", linker.stripped());
+        stats.count("link", "merged",   linker.merged());
+    }
+
+    emit(opts, program, nullptr, "", out);
+}
+
+/*
+ * Compiles one file, writing what opts ask for to out. Throws
+ * std::runtime_error with the message to report; nothing here
+ * exits, so several files can compile at once on the pool.
+ * Within the file, IR construction, the IR passes, lowering,
+ * allocation and peephole run per function on pool too; the
+ * output is the same for any number of threads.
+ */
+static void compile(const Options& opts, const std::string& input, std::ostream& out, ThreadPool* pool) {
+    Stats& stats = Stats::global();
+
+    /* Tokens are views into this buffer; keep it alive until the end. */
+    std::optional<SourceBuffer> source;
+    {
+        PhaseTimer timer("read");
+        if (input != "-")
+            source = SourceBuffer::open(input);
+        else if (opts.stdin_text)
+            source = SourceBuffer::from_string(*opts.stdin_text);
+        else
+            source = SourceBuffer::from_string(std::string(std::istreambuf_iterator<char>(std::cin), {}));
+    }
+
+    if (!source)
+        throw std::runtime_error("Cannot open file " + input);
+
+    if (opts.stats)
+        stats.count("read", "bytes", source->size());
+
+    /* The parser pulls tokens as it goes; no token vector is built. */
+    std::unique_ptr<TokenSource> tokens;
+    if (opts.pipeline)
+        tokens = std::make_unique<PipelinedTokenizer>(source->view());
+    else
+        tokens = std::make_unique<Tokenizer>(source->view());
+
+    std::unique_ptr<CountingTokenSource> counted;
+    if (opts.stats)
+        counted = std::make_unique<CountingTokenSource>(*tokens);
+
+    Parser parser(counted ? static_cast<TokenSource&>(*counted) : *tokens);
+    std::unique_ptr<ProgramNode> prog;
+
+    /* A parse error unwinds through tokens, joining a pipelined lexer. */
+    {
+        PhaseTimer timer("parse");
+        prog = parser.parse_program();
+    }
+
+    if (opts.stats) {
+        stats.count("lex",   "tokens", counted->count());
+        stats.count("parse", "nodes",  prog->arena.object_count() + 1);
+        stats.count("parse", "arena_bytes", prog->arena.bytes_used());
+    }
+
+    if (opts.print_ast) {
+        PhaseTimer timer("output");
+        AstPrinter(out, opts.ast_format).print(*prog);
+        out.flush();
+    } else {
+        if (opts.optimize) {
+            ConstantFolder folder(*prog);
+            {
+                PhaseTimer timer("fold");
+                folder.run();
+            }
+
+            if (opts.stats)
+                stats.count("fold", "removed", folder.removed());
+        }
+
+        IrProgram ir;
+        /* An object may call functions other files define. */
+        IrBuilder builder(*prog, opts.optimize, opts.compile_only, pool);
+
+        {
+            PhaseTimer timer("irgen");
+            ir = builder.build();
+        }
+
+        if (opts.stats && opts.optimize)
+            stats.count("irgen", "reordered", builder.reordered());
+
+        if (opts.optimize) {
+            IrOptimizer optimizer(ir, pool);
+            {
+                PhaseTimer timer("opt");
+                optimizer.run(opts.ir_passes ? &out : nullptr);
+            }
+
+            if (opts.stats) {
+                stats.count("opt", "forwarded",   optimizer.forwarded());
+                stats.count("opt", "dead_stores", optimizer.dead_stores());
+                stats.count("opt", "dead_code",   optimizer.dead_code());
+            }
+        }
+
+        if (opts.print_ir) {
+            PhaseTimer timer("output");
+            if (!opts.ir_passes || !opts.optimize)      // the pass dump ends with the final IR
+                IrPrinter(out, ir).print();
+            out.flush();
+        } else {
+            bool statements = std::any_of(prog->functions_and_statements.begin(),
+                                          prog->functions_and_statements.end(),
+                                          [](auto* stmt) { return !node_cast<FunctionDeclNode>(stmt); });
 
-    std::ifstream in_file(argv[1]);
+            MProgram program;
+            {
+                PhaseTimer timer("codegen");
+                program = CodeGen(ir, pool).generate();
+            }
 
-    if (!in_file.is_open())
-        print_exit(ERR, std::string("Cannot open file ") + argv[1]);
-    
-    std::string source(
-        (std::istreambuf_iterator<char>(in_file)),
-        std::istreambuf_iterator<char>()
-    );
+            LinearScan allocator(program, pool);
+            {
+                PhaseTimer timer("regalloc");
+                allocator.run();
+            }
+
+            Peephole peephole;
+            if (opts.optimize) {
+                PhaseTimer timer("peephole");
+                peephole.run(program, pool);
+            }
+
+            if (opts.stats) {
+                stats.count("codegen",  "functions", program.functions.size());
+                stats.count("regalloc", "spills",    allocator.spills());
+                stats.count("regalloc", "reloads",   allocator.reloads());
+                stats.count("regalloc", "slots",       allocator.slots());
+                stats.count("regalloc", "slots_saved", allocator.shared());
+                for (size_t i = 0; opts.optimize && i < peephole.hits().size(); i++)
+                    stats.count("peephole", PatternNames[i], peephole.hits()[i]);
+            }
+
+            if (opts.compile_only) {
+                PhaseTimer timer("output");
+                write_object(out, Object{input, statements, std::move(program)});
+                out.flush();
+            } else {
+                emit(opts, program, &*source, input, out);
+            }
+        }
+    }
+}
+
+/* Where compile_all() writes input's output: its name with the extension replaced. */
+static std::string output_path(const Options& opts, const std::string& input) {
+    size_t slash = input.find_last_of('/');
+    size_t dot   = input.find_last_of('.');
+    std::string stem = dot != std::string::npos && (slash == std::string::npos || dot > slash)
+                     ? input.substr(0, dot) : input;
+
+    return stem + (opts.compile_only ? ".o" : opts.machine_code ? ".mc" : ".as");
+}
+
+/*
+ * lcc a.lc b.lc ...: compiles every file on a work-stealing pool
+ * and returns how many failed.
+ *
+ * Assembly, machine code and objects go next to each source
+ * (a.lc -> a.as, a.mc, a.o). Reports (--ast, --ir, --run) are
+ * buffered and printed under a header per file. Reports and
+ * errors come out in command-line order, whichever file finishes
+ * first.
+ */
+static size_t compile_all(const Options& opts, ThreadPool& pool, std::ostream& out) {
+    Stats& stats   = Stats::global();
+    size_t n       = opts.inputs.size();
+    bool   reports = opts.print_ast || opts.print_ir || opts.run;
+
+    /* Counters are main-thread only; per-file ones would race. */
+    Options each = opts;
+    each.stats   = false;
+
+    std::vector<std::string> outputs(n);
+    std::vector<std::string> errors (n);
+
+    size_t steals = pool.steals();
+    {
+        PhaseTimer timer("compile");
+        stats.pause();
+        pool.run(n, [&](size_t i) {
+            const std::string& input = opts.inputs[i];
+            std::ostringstream text;
+
+            try {
+                compile(each, input, text, &pool);
+
+                if (reports) {
+                    outputs[i] = std::move(text).str();
+                } else {
+                    std::string   path = output_path(opts, input);
+                    std::ofstream file(path, std::ios::binary);
+                    if (!(file << text.view()) || !file.flush())
+                        throw std::runtime_error("Cannot write file " + path);
+                }
+            } catch (const std::runtime_error& e) {
+                errors[i] = input + ": " + e.what();
+            }
+        });
+        stats.resume();
+    }
+
+    size_t failed = 0;
+    {
+        PhaseTimer timer("output");
+        for (size_t i = 0; i < n; i++) {
+            if (!errors[i].empty()) {
+                print_message(out, ERR, errors[i]);
+                failed++;
+            } else if (reports) {
+                out << "==> " << opts.inputs[i] << " <==\n" << outputs[i];
+            }
+        }
+        out.flush();
+    }
+
+    if (opts.stats) {
+        stats.count("compile", "files",   n);
+        stats.count("compile", "failed",  failed);
+        stats.count("compile", "threads", pool.threads());
+        stats.count("compile", "steals",  pool.steals() - steals);
+    }
+
+    return failed;
+}
+
+/* Thread pools by size, made on first use; lcc --server keeps them between requests. */
+class PoolCache {
+public:
+    ThreadPool& get(size_t jobs) {
+        size_t threads = jobs ? jobs : ThreadPool::hardware_threads();
+
+        auto& pool = this->m_pools[threads];
+        if (!pool)
+            pool = std::make_unique<ThreadPool>(threads);
+        return *pool;
+    }
+
+private:
+    std::map<size_t, std::unique_ptr<ThreadPool>> m_pools;
+};
+
+/*
+ * Runs one lcc command line (args, without the program name),
+ * writing what it prints to out and its --stats report to err.
+ * stdin_text is the source for a "-" input, or NULL for std::cin.
+ * Returns the exit status.
+ */
+static int run_command(const std::vector<std::string>& args, const std::string* stdin_text,
+                       std::ostream& out, std::ostream& err, PoolCache& pools) {
+    Stats&  stats  = Stats::global();
+    Options opts;
+    size_t  failed = 0;
+
+    try {
+        opts            = parse_args(args);
+        opts.stdin_text = stdin_text;
+
+        if (opts.stats)
+            stats.enable();
+
+        if (opts.link)
+            link(opts, out);
+        else if (opts.inputs.size() == 1)
+            /* One file: its functions go through the backend in parallel instead. */
+            compile(opts, opts.inputs[0], out, &pools.get(opts.jobs));
+        else
+            failed = compile_all(opts, pools.get(opts.jobs), out);
+    } catch (const Fatal& e) {
+        print_message(out, e.type, e.what());
+        return 1;
+    } catch (const std::runtime_error& e) {
+        print_message(out, ERR, e.what());
+        return 1;
+    } catch (const std::exception& e) {
+        /* Out of memory, too many names, ...: this command fails, a server keeps serving. */
+        print_message(out, ERR, std::string("Internal error: ") + e.what());
+        return 1;
+    }
+
+    if (opts.stats)
+        stats.report(err, opts.stats_format);
+
+    return failed ? 1 : 0;
+}
+
+/*
+ * The result cache key for request, run in the current directory:
+ * the command line, stdin and every file it reads as it is now
+ * (inode, size and modification time). nullopt if the answer must
+ * not be reused: several sources (their outputs go to files),
+ * --stats (its timings would be stale) or an unreadable file.
+ */
+static std::optional<std::string> cache_key(const CompileRequest& request) {
+    Options opts;
+    try {
+        opts = parse_args(request.args);
+    } catch (const Fatal&) {
+        return std::nullopt;
+    }
+
+    if (opts.stats || (!opts.link && opts.inputs.size() != 1))
+        return std::nullopt;
+
+    std::string key = request.cwd;
+    for (auto& arg : request.args)
+        key += '\0' + arg;
+    key += request.input ? std::string("\0<", 2) + *request.input : std::string(1, '\0');
+
+    for (auto& path : opts.link ? opts.objects : opts.inputs) {
+        if (path == "-")
+            continue;
+
+        struct stat st {};
+        if (::stat(path.c_str(), &st) != 0)
+            return std::nullopt;
+
+        key += '\0' + std::to_string(st.st_dev) + ':' + std::to_string(st.st_ino) + ':' +
+               std::to_string(st.st_size) + ':' + std::to_string(st.st_mtim.tv_sec) + '.' +
+               std::to_string(st.st_mtim.tv_nsec);
+    }
+    return key;
+}
+
+/*
+ * lcc --server[=PATH]: answers lcc --client until SIGINT or
+ * SIGTERM (see compile_server.hpp).
+ *
+ * What each lcc process would build from scratch stays warm: the
+ * interned names (up to MaxNames), the thread pools, and the
+ * answers to recent requests. An answer is reused when the same
+ * command runs in the same directory on the same stdin and its
+ * files are unchanged.
+ */
+static int serve(const std::string& path) {
+    static constexpr size_t MaxAnswers = 256;      // cached; all are dropped when full
+    static constexpr size_t MaxNames   = 1 << 20;  // interned; all are forgotten past this
+
+    CompileServer server(path);
+    PoolCache     pools;
+    std::unordered_map<std::string, CompileResponse> answers;
+    size_t        reused = 0;
+
+    print_message(std::cout, INFO, "Listening on " + path);
+    std::cout.flush();
+
+    /* A client without stdin reads "-" as an empty file, never the server's stdin. */
+    const std::string no_input;
+
+    server.serve([&](const CompileRequest& request) {
+        CompileResponse response;
+
+        /* Requests are served one at a time, so each can run in its client's directory. */
+        if (::chdir(request.cwd.c_str()) != 0) {
+            std::ostringstream out;
+            print_message(out, ERR, "Cannot enter directory " + request.cwd);
+            response.status = 1;
+            response.out    = std::move(out).str();
+            return response;
+        }
+
+        std::optional<std::string> key = cache_key(request);
+        if (key) {
+            if (auto it = answers.find(*key); it != answers.end()) {
+                reused++;
+                return it->second;
+            }
+        }
+
+        std::ostringstream out, err;
+        response.status = run_command(request.args, request.input ? &*request.input : &no_input, out, err, pools);
+        response.out    = std::move(out).str();
+        response.err    = std::move(err).str();
+        Stats::global().reset();
+
+        /* No name outlives its request, so the interner can start over between them. */
+        if (Interner::global().size() > MaxNames)
+            Interner::global().clear();
+
+        if (key) {
+            if (answers.size() >= MaxAnswers)
+                answers.clear();
+            answers.emplace(std::move(*key), response);
+        }
+        return response;
+    });
+
+    print_message(std::cout, INFO, "Served " + std::to_string(server.served()) + " requests, " +
+                                   std::to_string(reused) + " from cache");
+    return 0;
+}
+
+/*
+ * lcc --client[=PATH] ...: runs the rest of the command line on
+ * the server, or in this process if none is listening, and prints
+ * and exits as lcc itself would. Scripts switch by adding --client.
+ */
+static int client(const std::string& path, const std::vector<std::string>& args) {
+    CompileRequest request;
+    request.args = args;
+
+    char cwd[4096];
+    if (!::getcwd(cwd, sizeof(cwd)))
+        throw std::runtime_error("Cannot get the working directory");
+    request.cwd = cwd;
+
+    if (std::count(args.begin(), args.end(), "-"))
+        request.input = std::string(std::istreambuf_iterator<char>(std::cin), {});
+
+    std::optional<CompileResponse> response = send_compile_request(path, request);
+    if (!response) {
+        PoolCache pools;
+        return run_command(args, request.input ? &*request.input : nullptr, std::cout, std::cerr, pools);
+    }
+
+    std::cout << response->out;
+    std::cerr << response->err;
+    return response->status;
+}
+
+int main(int argc, char **argv) {
+    /* Let std::cout buffer; the AST printer writes many small pieces. */
+    std::ios::sync_with_stdio(false);
 
-    Tokenizer tokenizer(source);
-    std::vector<Token> tokens = tokenizer.tokenize();
+    std::vector<std::string> args(argv + 1, argv + argc);
 
-    Parser parser(tokens);
-    auto prog = parser.parse_program();
+    /* --server and --client come first; =PATH names the socket. */
+    std::string mode   = args.empty() ? "" : args[0];
+    size_t      equals = mode.find('=');
+    std::string name   = mode.substr(0, equals);
+    std::string socket = equals != std::string::npos ? mode.substr(equals + 1) : default_socket_path();
 
-    std::cout << prog->to_string() << std::endl;
+    try {
+        if (name == "--server" && args.size() > 1)
+            throw std::runtime_error("--server takes no other options; clients pass their own");
+        if (name == "--server")
+            return serve(socket);
+        if (name == "--client")
+            return client(socket, std::vector<std::string>(args.begin() + 1, args.end()));
+    } catch (const std::runtime_error& e) {
+        print_message(std::cout, ERR, e.what());
+        return 1;
+    }
 
-    // for (const Token& t : tokens) {
-    //     std::cout << t.value << " " << to_string(t.type) << std::endl;
-    // }
+    PoolCache pools;
+    return run_command(args, nullptr, std::cout, std::cerr, pools);
 }
@@ -0,0 +1,236 @@
+#include "linker.hpp"
+
+#include <stdexcept>
+
+MProgram Linker::link() {
+    if (this->m_objects.empty())
+        _error("no objects");
+
+    this->_resolve();
+    this->_reach();
+    this->_place();
+    this->_emit();
+    return std::move(this->m_out);
+}
+
+/* Binds every external function to its definition; finds the address words. */
+void Linker::_resolve() {
+    size_t count = this->m_objects.size();
+    this->m_target    .resize(count);
+    this->m_address_of.resize(count);
+
+    for (uint32_t k = 0; k < count; k++) {
+        const Object& object = this->m_objects[k];
+
+        if (k > 0 && object.statements)
+            _error(object.name + " has top-level statements; only the first object's run");
+
+        auto& functions = object.program.functions;
+        this->m_target[k].assign(functions.size(), NoFn);
+        this->m_target[k][0] = FnRef {k, 0};
+
+        for (uint32_t i = 1; i < functions.size(); i++) {
+            if (functions[i].external)
+                continue;
+
+            auto [it, inserted] = this->m_defined.try_emplace(functions[i].name, FnRef {k, i});
+            if (!inserted)
+                _error("function " + std::string(spelling(functions[i].name)) + " is defined in " +
+                       this->m_objects[it->second.object].name + " and " + object.name);
+            this->m_target[k][i] = FnRef {k, i};
+        }
+    }
+
+    for (uint32_t k = 0; k < count; k++) {
+        const Object& object    = this->m_objects[k];
+        auto&         functions = object.program.functions;
+
+        for (uint32_t i = 1; i < functions.size(); i++) {
+            if (!functions[i].external)
+                continue;
+
+            std::string name(spelling(functions[i].name));
+            auto        it = this->m_defined.find(functions[i].name);
+            if (it == this->m_defined.end())
+                _error("undefined function " + name + ", called in " + object.name);
+
+            auto& definition = this->m_objects[it->second.object].program.functions[it->second.index];
+            if (definition.params.size() != functions[i].params.size())
+                _error(name + " takes " + std::to_string(definition.params.size()) + " arguments, " +
+                       object.name + " passes " + std::to_string(functions[i].params.size()));
+
+            this->m_target[k][i] = it->second;
+        }
+
+        /* A call loads the callee's address from a word `.fill <entry>`. */
+        std::unordered_map<LabelId, uint32_t> by_entry;
+        for (uint32_t i = 1; i < functions.size(); i++)
+            by_entry.emplace(functions[i].entry, i);
+
+        this->m_address_of[k].assign(object.program.labels.size(), UINT32_MAX);
+        for (auto& word : object.program.data) {
+            if (word.value_label == NoLabel)
+                continue;
+            if (auto it = by_entry.find(word.value_label); it != by_entry.end())
+                this->m_address_of[k][word.label] = it->second;
+        }
+    }
+}
+
+/* Marks the functions calls reach from the entry, and the labels their code uses. */
+void Linker::_reach() {
+    size_t count = this->m_objects.size();
+    this->m_kept.resize(count);
+    this->m_used.resize(count);
+    for (uint32_t k = 0; k < count; k++) {
+        this->m_kept[k].assign(this->m_objects[k].program.functions.size(), 0);
+        this->m_used[k].assign(this->m_objects[k].program.labels.size(), 0);
+    }
+
+    std::vector<FnRef> work {FnRef {0, 0}};
+    this->m_kept[0][0] = 1;
+
+    while (!work.empty()) {
+        FnRef at = work.back();
+        work.pop_back();
+
+        for (auto& in : this->m_objects[at.object].program.functions[at.index].code) {
+            if (in.label == NoLabel)
+                continue;
+            this->m_used[at.object][in.label] = 1;
+
+            uint32_t callee = this->m_address_of[at.object][in.label];
+            if (callee == UINT32_MAX)
+                continue;
+
+            FnRef target = this->m_target[at.object][callee];
+            if (!this->m_kept[target.object][target.index]) {
+                this->m_kept[target.object][target.index] = 1;
+                work.push_back(target);
+            }
+        }
+    }
+
+    for (uint32_t k = 0; k < count; k++) {
+        auto& functions = this->m_objects[k].program.functions;
+        for (uint32_t i = 1; i < functions.size(); i++)
+            this->m_stripped += !functions[i].external && !this->m_kept[k][i];
+    }
+}
+
+/* Output labels for everything kept, and the merged program data. */
+void Linker::_place() {
+    size_t count = this->m_objects.size();
+    this->m_labels.resize(count);
+    for (uint32_t k = 0; k < count; k++)
+        this->m_labels[k].assign(this->m_objects[k].program.labels.size(), NoLabel);
+
+    for (uint32_t k = 0; k < count; k++) {
+        auto& functions = this->m_objects[k].program.functions;
+        for (uint32_t i = 0; i < functions.size(); i++) {
+            if (functions[i].external || !this->m_kept[k][i])
+                continue;
+            if (functions[i].entry != NoLabel)
+                this->_new(k, functions[i].entry);
+            for (auto& word : functions[i].data)
+                this->_new(k, word.label);
+        }
+    }
+
+    /* External entries and parameters are their definition's. */
+    for (uint32_t k = 0; k < count; k++) {
+        auto& functions = this->m_objects[k].program.functions;
+        for (uint32_t i = 1; i < functions.size(); i++) {
+            FnRef target = this->m_target[k][i];
+            if (!functions[i].external || !this->m_kept[target.object][target.index])
+                continue;
+
+            auto& definition = this->m_objects[target.object].program.functions[target.index];
+            auto& labels     = this->m_labels[target.object];
+            this->m_labels[k][functions[i].entry] = labels[definition.entry];
+            for (size_t p = 0; p < functions[i].params.size(); p++)
+                this->m_labels[k][functions[i].params[p]] = labels[definition.params[p]];
+        }
+    }
+
+    std::unordered_map<uint64_t, LabelId> addresses;       // by (object, function) called
+    std::unordered_map<int32_t,  LabelId> constants;       // by value
+
+    for (uint32_t k = 0; k < count; k++) {
+        const MProgram& program = this->m_objects[k].program;
+
+        for (auto& word : program.data) {
+            if (!this->m_used[k][word.label])
+                continue;
+
+            LabelId* shared = nullptr;
+            if (uint32_t callee = this->m_address_of[k][word.label]; callee != UINT32_MAX) {
+                FnRef target = this->m_target[k][callee];
+                shared = &addresses.try_emplace(uint64_t(target.object) << 32 | target.index, NoLabel).first->second;
+            } else if (word.value_label == NoLabel && program.is_read_only(word.label)) {
+                shared = &constants.try_emplace(word.value, NoLabel).first->second;
+            }
+
+            if (shared && *shared != NoLabel) {
+                this->m_labels[k][word.label] = *shared;
+                this->m_merged++;
+                continue;
+            }
+
+            LabelId label = this->_new(k, word.label);
+            if (shared)
+                *shared = label;
+            this->m_out.data.push_back(this->_remap(k, word));
+        }
+    }
+}
+
+/* The kept functions, entry first, then in object and source order. */
+void Linker::_emit() {
+    for (uint32_t k = 0; k < this->m_objects.size(); k++) {
+        auto& functions = this->m_objects[k].program.functions;
+
+        for (uint32_t i = 0; i < functions.size(); i++) {
+            if (functions[i].external || !this->m_kept[k][i] || (i == 0 && k > 0))
+                continue;
+
+            const MFunction& from = functions[i];
+            MFunction&       fn   = this->m_out.functions.emplace_back();
+            fn.name  = from.name;
+            fn.entry = from.entry == NoLabel ? NoLabel : this->m_labels[k][from.entry];
+            for (LabelId param : from.params)
+                fn.params.push_back(this->m_labels[k][param]);
+
+            fn.code = from.code;
+            for (auto& in : fn.code)
+                this->_remap(k, in);
+
+            for (auto& word : from.data)
+                fn.data.push_back(this->_remap(k, word));
+        }
+    }
+}
+
+LabelId Linker::_new(uint32_t object, LabelId label) {
+    const Label& l = this->m_objects[object].program.labels[label];
+    return this->m_labels[object][label] = this->m_out.new_label(l.kind, l.name);
+}
+
+/* Locations are offsets into one object's source; a linked program has several, so they go. */
+void Linker::_remap(uint32_t object, MInstr& in) const {
+    if (in.label != NoLabel)
+        in.label = this->m_labels[object][in.label];
+    in.loc = NoLoc;
+}
+
+DataWord Linker::_remap(uint32_t object, const DataWord& word) const {
+    DataWord out = word;
+    out.label = this->m_labels[object][word.label];
+    if (word.value_label != NoLabel)
+        out.value_label = this->m_labels[object][word.value_label];
+    return out;
+}
+
+void Linker::_error(const std::string& msg) {
+    throw std::runtime_error("Link error: " + msg);
+}
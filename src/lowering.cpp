@@ -0,0 +1,36 @@
+#include "lowering.hpp"
+
+#include "lowering_table.hpp"
+
+namespace lowering {
+
+namespace {
+
+constexpr int Ops      = static_cast<int>(Op::COUNT);
+constexpr int Aliases  = static_cast<int>(Alias::COUNT);
+constexpr int Settings = static_cast<int>(Regs::COUNT);
+
+constexpr Entry Missing {};
+
+struct Index {
+    const Entry* entries[Ops][Aliases][Settings];
+
+    constexpr Index() : entries() {
+        for (auto& by_alias : this->entries)
+            for (auto& by_regs : by_alias)
+                for (auto& entry : by_regs)
+                    entry = &Missing;
+        for (const Entry& e : Table)
+            this->entries[static_cast<int>(e.op)][static_cast<int>(e.alias)][static_cast<int>(e.regs)] = &e;
+    }
+};
+
+constexpr Index TableIndex;
+
+} // namespace
+
+const Entry& lookup(Op op, Alias alias, Regs regs) {
+    return *TableIndex.entries[static_cast<int>(op)][static_cast<int>(alias)][static_cast<int>(regs)];
+}
+
+} // namespace lowering
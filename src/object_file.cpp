@@ -0,0 +1,229 @@
+#include "object_file.hpp"
+
+#include <charconv>
+#include <iterator>
+#include <stdexcept>
+
+static constexpr std::string_view Magic = "lcc-object 1";
+
+static constexpr Opcode AllOpcodes[] = {
+    Opcode::add, Opcode::nor, Opcode::lw, Opcode::sw, Opcode::beq,
+    Opcode::jalr, Opcode::halt, Opcode::noop, Opcode::eq,
+};
+
+/* Labels and symbols print as a number / name, or `-` when absent. */
+static void put_label(std::ostream& os, LabelId label) {
+    if (label == NoLabel)
+        os << '-';
+    else
+        os << label;
+}
+
+static void put_name(std::ostream& os, SymbolId name) {
+    if (name == NoSymbol)
+        os << '-';
+    else
+        os << spelling(name);
+}
+
+static void put_word(std::ostream& os, const DataWord& word) {
+    os << "w " << word.label << ' ' << word.value << ' ';
+    put_label(os, word.value_label);
+    os << '\n';
+}
+
+void write_object(std::ostream& os, const Object& object) {
+    const MProgram& program = object.program;
+
+    os << Magic << '\n';
+    os << "statements " << object.statements << '\n';
+
+    for (auto& label : program.labels) {
+        os << "label " << LabelPrefix[static_cast<size_t>(label.kind)] << ' ';
+        put_name(os, label.name);
+        os << '\n';
+    }
+
+    for (auto& fn : program.functions) {
+        os << "function ";
+        put_name(os, fn.name);
+        os << ' ';
+        put_label(os, fn.entry);
+        os << ' ' << fn.external << ' ' << fn.params.size();
+        for (LabelId param : fn.params)
+            os << ' ' << param;
+        os << '\n';
+
+        for (auto& in : fn.code) {
+            os << "i " << to_string(in.op) << ' ' << in.a << ' ' << in.b << ' ' << in.d << ' ' << in.offset << ' ';
+            put_label(os, in.label);
+            os << '\n';
+        }
+        for (auto& word : fn.data)
+            put_word(os, word);
+    }
+
+    os << "data\n";
+    for (auto& word : program.data)
+        put_word(os, word);
+    os << "end\n";
+}
+
+namespace {
+
+/* Reads an object a line at a time, a field at a time. */
+class ObjectReader {
+public:
+    ObjectReader(std::string_view text, std::string_view name)
+        : m_text(text), m_name(name) {}
+
+    Object read() {
+        Object object;
+        object.name = std::string(this->m_name);
+        MProgram& program = object.program;
+
+        if (!this->_line() || this->m_line != Magic)
+            this->_error("not an lcc object");
+
+        this->_line();
+        this->_keyword("statements");
+        object.statements = this->_number() != 0;
+
+        MFunction* fn = nullptr;
+        while (this->_line()) {
+            std::string_view kind = this->_field();
+
+            if (kind == "label") {
+                std::string_view prefix = this->_field();
+                size_t           index  = std::string_view(LabelPrefix, std::size(LabelPrefix)).find(prefix);
+                if (prefix.size() != 1 || index == std::string_view::npos)
+                    this->_error("bad label kind");
+                program.new_label(static_cast<LabelKind>(index), this->_name());
+            } else if (kind == "function") {
+                fn = &program.functions.emplace_back();
+                fn->name     = this->_name();
+                fn->entry    = this->_label(program);
+                fn->external = this->_number() != 0;
+                for (int64_t n = this->_number(); n > 0; n--)
+                    fn->params.push_back(this->_label(program));
+            } else if (kind == "i") {
+                if (!fn)
+                    this->_error("instruction outside a function");
+                fn->code.push_back(this->_instruction(program));
+            } else if (kind == "w") {
+                DataWord word;
+                word.label       = this->_label(program);
+                word.value       = static_cast<int32_t>(this->_number());
+                word.value_label = this->_label(program);
+                (fn ? fn->data : program.data).push_back(word);
+            } else if (kind == "data") {
+                fn = nullptr;
+            } else if (kind == "end") {
+                if (program.functions.empty())
+                    this->_error("no top-level code");
+                return object;
+            } else {
+                this->_error("unknown record " + std::string(kind));
+            }
+        }
+
+        this->_error("truncated");
+    }
+
+private:
+    std::string_view m_text;
+    std::string_view m_name;
+    std::string_view m_line;
+    uint32_t         m_number = 0;
+
+    bool _line() {
+        if (this->m_text.empty())
+            return false;
+
+        size_t newline = this->m_text.find('\n');
+        this->m_line = this->m_text.substr(0, newline);
+        this->m_text.remove_prefix(newline == std::string_view::npos ? this->m_text.size() : newline + 1);
+        this->m_number++;
+        return true;
+    }
+
+    std::string_view _field() {
+        size_t space = this->m_line.find(' ');
+        std::string_view field = this->m_line.substr(0, space);
+        this->m_line.remove_prefix(space == std::string_view::npos ? this->m_line.size() : space + 1);
+        if (field.empty())
+            this->_error("missing field");
+        return field;
+    }
+
+    void _keyword(std::string_view keyword) {
+        if (this->_field() != keyword)
+            this->_error("expected " + std::string(keyword));
+    }
+
+    int64_t _number() {
+        std::string_view field = this->_field();
+        int64_t          value = 0;
+        auto [end, err] = std::from_chars(field.data(), field.data() + field.size(), value);
+        if (err != std::errc() || end != field.data() + field.size())
+            this->_error("bad number " + std::string(field));
+        return value;
+    }
+
+    LabelId _label(const MProgram& program) {
+        if (this->m_line.substr(0, 2) == "- " || this->m_line == "-") {
+            this->_field();
+            return NoLabel;
+        }
+
+        int64_t label = this->_number();
+        if (label < 0 || static_cast<size_t>(label) >= program.labels.size())
+            this->_error("undeclared label " + std::to_string(label));
+        return static_cast<LabelId>(label);
+    }
+
+    SymbolId _name() {
+        std::string_view field = this->_field();
+        return field == "-" ? NoSymbol : Interner::global().intern(field);
+    }
+
+    MInstr _instruction(const MProgram& program) {
+        std::string_view op = this->_field();
+
+        MInstr in {};
+        bool   known = false;
+        for (Opcode code : AllOpcodes) {
+            if (op == to_string(code)) {
+                in.op = code;
+                known = true;
+            }
+        }
+        if (!known)
+            this->_error("unknown opcode " + std::string(op));
+
+        in.a      = this->_register();
+        in.b      = this->_register();
+        in.d      = this->_register();
+        in.offset = static_cast<int32_t>(this->_number());
+        in.label  = this->_label(program);
+        return in;
+    }
+
+    Reg _register() {
+        int64_t reg = this->_number();
+        if (reg < 0 || reg >= lc2k::NumRegs)
+            this->_error("bad register " + std::to_string(reg));
+        return static_cast<Reg>(reg);
+    }
+
+    [[noreturn]] void _error(const std::string& msg) const {
+        throw std::runtime_error("Object error: " + std::string(this->m_name) + ":" +
+                                 std::to_string(this->m_number) + ": " + msg);
+    }
+};
+
+} // namespace
+
+Object read_object(std::string_view text, std::string_view name) {
+    return ObjectReader(text, name).read();
+}
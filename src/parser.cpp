@@ -1,27 +1,65 @@
 #include "parser.hpp"
 
-const Token& Parser::peek(size_t offset) const {
-    assert(this->m_pos + offset < this->m_tokens.size());
+#include <charconv>
 
-    return this->m_tokens.at(this->m_pos + offset);
+/* Returned by peek() past the last token. */
+static const Token EofToken {.value = {}, .type = TokenType::m_eof};
+
+void Parser::_fill(size_t offset) {
+    assert(offset < Parser::Lookahead);
+
+    while (this->m_count <= offset && !this->m_exhausted) {
+        size_t tail = (this->m_head + this->m_count) & (Parser::Lookahead - 1);
+        size_t room = std::min(Parser::Lookahead - this->m_count,
+                               Parser::Lookahead - tail);
+
+        size_t read = this->m_source.read_tokens(&this->m_ring[tail], room);
+        if (read == 0)
+            this->m_exhausted = true;
+
+        this->m_count += read;
+    }
+}
+
+const Token& Parser::peek(size_t offset) {
+    if (this->m_count <= offset)
+        this->_fill(offset);
+
+    if (this->m_count <= offset)
+        return EofToken;
+
+    return this->m_ring[(this->m_head + offset) & (Parser::Lookahead - 1)];
 }
 
-const Token& Parser::consume() {
-    assert(this->m_pos < this->m_tokens.size());
+Token Parser::consume() {
+    if (this->m_count == 0)
+        this->_fill(0);
 
-    return this->m_tokens.at(this->m_pos++);
+    assert(this->m_count > 0);
+
+    Token token = this->m_ring[this->m_head];
+    this->m_head = (this->m_head + 1) & (Parser::Lookahead - 1);
+    this->m_count--;
+
+    return token;
 }
 
 std::unique_ptr<ProgramNode> Parser::parse_program() {
     auto program = std::make_unique<ProgramNode>();
+    this->m_arena = &program->arena;
+
+    size_t mark = this->m_node_scratch.size();
 
-    while (this->m_pos < this->m_tokens.size()) {
-        program->functions_and_statements.push_back(
-            this->parse_statement()
-        );
-        break;
+    while (!this->_match(TokenType::m_eof)) {
+        if (this->_match(TokenType::k_func))
+            this->m_node_scratch.push_back(this->parse_function_decl());
+        else
+            this->m_node_scratch.push_back(this->parse_statement());
     }
 
+    program->functions_and_statements = this->_take_nodes(mark);
+    this->m_arena = nullptr;
+
     return program;
 }
 
@@ -55,7 +93,12 @@ bool Parser::_expect(TokenType type, ParseErrorType err) {
     if (this->_match(type))
         return true;
 
-    throw std::runtime_error("Parse error: " + to_string(err));
+    auto& got = this->peek();
+    throw std::runtime_error(
+        "Parse error: " + to_string(err) + ", got " +
+        (got.type == TokenType::m_eof ? std::string("end of input")
+                                      : "'" + std::string(got.value) + "'")
+    );
 }
 
 bool Parser::_expect_consume(TokenType type, ParseErrorType err) {
@@ -64,90 +107,265 @@ bool Parser::_expect_consume(TokenType type, ParseErrorType err) {
     return true;
 }
 
-bool Parser::_is_func_call() const {
+bool Parser::_is_func_call() {
     return this->peek(0).type == TokenType::m_ident &&
            this->peek(1).type == TokenType::b_lparen;
 }
 
+BinaryExprNode* Parser::_make_binary(TokenType op, ASTNodePtr left, ASTNodePtr right) {
+    auto* binary_expr = this->m_arena->make<BinaryExprNode>();
+    binary_expr->offset = left->offset;
+    binary_expr->op     = op;
+    binary_expr->left   = left;
+    binary_expr->right  = right;
+    return binary_expr;
+}
+
+NodeList Parser::_take_nodes(size_t mark) {
+    auto list = this->m_arena->copy_span(this->m_node_scratch, mark);
+    this->m_node_scratch.resize(mark);
+    return list;
+}
+
+std::string_view Parser::_copy_value(const Token& token) {
+    return this->m_arena->copy_string(token.value);
+}
+
+void Parser::_declare(SymbolId name, const ASTNode* decl) {
+    if (!this->m_symbols.declare(name, decl))
+        throw std::runtime_error("Parse error: " + to_string(ParseErrorType::Redeclaration) +
+                                 " '" + std::string(spelling(name)) + "'");
+}
+
 /* PARSING FUNCTIONS */
-std::unique_ptr<ASTNode> Parser::parse_statement() {
-    if (this->_match(TokenType::k_func))
-        return this->parse_function_decl();
+ASTNodePtr Parser::parse_statement() {
     if (this->_match(TokenType::k_let))
         return this->parse_var_decl();
-    
-    return nullptr;
+    if (this->_match(TokenType::k_exit))
+        return this->parse_exit_stmt();
+    if (this->_match(TokenType::m_ident) &&
+        this->peek(1).type == TokenType::o_equal)
+        return this->parse_assignment();
+
+    return this->parse_expr_stmt();
 }
 
 
-std::unique_ptr<FunctionDeclNode> Parser::parse_function_decl() {
-    auto function_decl = std::make_unique<FunctionDeclNode>();
+FunctionDeclNode* Parser::parse_function_decl() {
+    auto* function_decl = this->m_arena->make<FunctionDeclNode>();
+    function_decl->offset = this->peek().offset;
+
+    this->_expect_consume(TokenType::k_func, ParseErrorType::ExpectedFn);
+
+    this->_expect(TokenType::d_int, ParseErrorType::ExpectedDataType);
+    function_decl->return_type = this->_copy_value(this->consume());
+
+    this->_expect(TokenType::m_ident, ParseErrorType::ExpectedIdentifier);
+    function_decl->name = this->consume().symbol;
+    this->_declare(function_decl->name, function_decl);
+
+    this->_expect_consume(TokenType::b_lparen, ParseErrorType::ExpectedLParen);
+
+    this->m_symbols.push_scope();
+
+    size_t param_mark = this->m_param_scratch.size();
+
+    while (!this->_match(TokenType::b_rparen)) {
+        if (this->m_param_scratch.size() > param_mark)
+            this->_expect_consume(TokenType::b_comma, ParseErrorType::ExpectedComma);
+
+        FunctionDeclNode::Param param;
+
+        this->_expect(TokenType::m_ident, ParseErrorType::ExpectedIdentifier);
+        param.name = this->consume().symbol;
+
+        this->_expect_consume(TokenType::b_colon, ParseErrorType::ExpectedColon);
+
+        this->_expect(TokenType::d_int, ParseErrorType::ExpectedDataType);
+        param.type = this->_copy_value(this->consume());
+
+        this->_declare(param.name, function_decl);
+        this->m_param_scratch.push_back(param);
+    }
+
+    function_decl->params = this->m_arena->copy_span(this->m_param_scratch, param_mark);
+    this->m_param_scratch.resize(param_mark);
+
+    this->_expect_consume(TokenType::b_rparen, ParseErrorType::ExpectedRParen);
+    this->_expect_consume(TokenType::b_left_curl, ParseErrorType::ExpectedLCurl);
+
+    size_t body_mark = this->m_node_scratch.size();
+
+    while (!this->_match(TokenType::b_right_curl) && !this->_match(TokenType::m_eof))
+        this->m_node_scratch.push_back(this->parse_statement());
+
+    function_decl->body = this->_take_nodes(body_mark);
+
+    this->_expect_consume(TokenType::b_right_curl, ParseErrorType::ExpectedRCurl);
+
+    this->m_symbols.pop_scope();
 
     return function_decl;
 }
 
-std::unique_ptr<FunctionCallNode> Parser::parse_function_call() {
-    auto function_call = std::make_unique<FunctionCallNode>();
+FunctionCallNode* Parser::parse_function_call() {
+    auto* function_call = this->m_arena->make<FunctionCallNode>();
+    function_call->offset = this->peek().offset;
+
+    this->_expect(TokenType::m_ident, ParseErrorType::ExpectedIdentifier);
+    function_call->name = this->consume().symbol;
+
+    this->_expect_consume(TokenType::b_lparen, ParseErrorType::ExpectedLParen);
+
+    size_t arg_mark = this->m_node_scratch.size();
+
+    while (!this->_match(TokenType::b_rparen)) {
+        if (this->m_node_scratch.size() > arg_mark)
+            this->_expect_consume(TokenType::b_comma, ParseErrorType::ExpectedComma);
+
+        this->m_node_scratch.push_back(this->parse_expr());
+    }
+
+    function_call->args = this->_take_nodes(arg_mark);
+
+    this->_expect_consume(TokenType::b_rparen, ParseErrorType::ExpectedRParen);
 
     return function_call;
 }
 
-std::unique_ptr<VarDeclNode> Parser::parse_var_decl() {
-    auto var_decl = std::make_unique<VarDeclNode>();
+VarDeclNode* Parser::parse_var_decl() {
+    auto* var_decl = this->m_arena->make<VarDeclNode>();
+    var_decl->offset = this->peek().offset;
 
     this->_expect_consume(TokenType::k_let, ParseErrorType::ExpectedLet);
 
     this->_expect(TokenType::m_ident, ParseErrorType::ExpectedIdentifier);
-    var_decl->name = this->consume().value;
+    var_decl->name = this->consume().symbol;
 
     this->_expect_consume(TokenType::b_colon, ParseErrorType::ExpectedColon);
 
     this->_expect(TokenType::d_int, ParseErrorType::ExpectedDataType);
-    var_decl->type = this->consume().value;
+    var_decl->type = this->_copy_value(this->consume());
 
     this->_expect_consume(TokenType::o_equal, ParseErrorType::ExpectedEqual);
 
-    var_decl->value = this->parse_expr_stmt();
+    var_decl->value = this->parse_expr();
 
     this->_expect_consume(TokenType::b_semi, ParseErrorType::ExpectedSemiColon);
 
+    this->_declare(var_decl->name, var_decl);
+
     return var_decl;
 }
 
 
-std::unique_ptr<AssignmentNode> Parser::parse_assignment() {
-    auto assign = std::make_unique<AssignmentNode>();
+AssignmentNode* Parser::parse_assignment() {
+    auto* assign = this->m_arena->make<AssignmentNode>();
+    assign->offset = this->peek().offset;
+
+    this->_expect(TokenType::m_ident, ParseErrorType::ExpectedIdentifier);
+    assign->name = this->consume().symbol;
+
+    this->_expect_consume(TokenType::o_equal, ParseErrorType::ExpectedEqual);
+
+    assign->value = this->parse_expr();
+
+    this->_expect_consume(TokenType::b_semi, ParseErrorType::ExpectedSemiColon);
 
     return assign;
 }
 
-std::unique_ptr<ExitNode> Parser::parse_exit_stmt() {
-    auto exit_node = std::make_unique<ExitNode>();
+ExitNode* Parser::parse_exit_stmt() {
+    auto* exit_node = this->m_arena->make<ExitNode>();
+    exit_node->offset = this->peek().offset;
+
+    this->_expect_consume(TokenType::k_exit, ParseErrorType::ExpectedExit);
+    this->_expect_consume(TokenType::b_lparen, ParseErrorType::ExpectedLParen);
+
+    exit_node->value = this->parse_expr();
+
+    this->_expect_consume(TokenType::b_rparen, ParseErrorType::ExpectedRParen);
+    this->_expect_consume(TokenType::b_semi, ParseErrorType::ExpectedSemiColon);
 
     return exit_node;
 }
 
-std::unique_ptr<ExprStmtNode> Parser::parse_expr_stmt() {
-    auto expr_stmt = std::make_unique<ExprStmtNode>();
-    this->consume();
+ExprStmtNode* Parser::parse_expr_stmt() {
+    auto* expr_stmt = this->m_arena->make<ExprStmtNode>();
+    expr_stmt->offset = this->peek().offset;
+
+    expr_stmt->expr = this->parse_expr();
+
+    this->_expect_consume(TokenType::b_semi, ParseErrorType::ExpectedSemiColon);
 
     return expr_stmt;
 }
 
-std::unique_ptr<BinaryExprNode> Parser::parse_binary_expr() {
-    auto binary_expr = std::make_unique<BinaryExprNode>();
+ASTNodePtr Parser::parse_expr() {
+    if (++this->m_depth > Parser::MaxNesting)
+        throw std::runtime_error("Parse error: " + to_string(ParseErrorType::TooDeep) + ", over " +
+                                 std::to_string(Parser::MaxNesting) + " levels");
 
-    return binary_expr;
+    auto* left = this->parse_add_sub();
+
+    if (this->_match_consume(TokenType::o_equal_equal))
+        left = this->_make_binary(TokenType::o_equal_equal, left, this->parse_add_sub());
+
+    this->m_depth--;
+    return left;
+}
+
+ASTNodePtr Parser::parse_add_sub() {
+    auto* left = this->parse_factor();
+
+    while (this->_match(TokenType::o_plus) || this->_match(TokenType::o_sub)) {
+        TokenType op = this->consume().type;
+        left = this->_make_binary(op, left, this->parse_factor());
+    }
+
+    return left;
+}
+
+ASTNodePtr Parser::parse_factor() {
+    if (this->_match(TokenType::l_int))
+        return this->parse_int_literal();
+
+    if (this->_is_func_call())
+        return this->parse_function_call();
+
+    if (this->_match(TokenType::m_ident))
+        return this->parse_ident_node();
+
+    this->_expect_consume(TokenType::b_lparen, ParseErrorType::ExpectedExpression);
+
+    auto* expr = this->parse_expr();
+
+    this->_expect_consume(TokenType::b_rparen, ParseErrorType::ExpectedRParen);
+
+    return expr;
 }
 
-std::unique_ptr<IdentNode> Parser::parse_ident_node() {
-    auto ident = std::make_unique<IdentNode>();
+IdentNode* Parser::parse_ident_node() {
+    auto* ident = this->m_arena->make<IdentNode>();
+    ident->offset = this->peek().offset;
+
+    this->_expect(TokenType::m_ident, ParseErrorType::ExpectedIdentifier);
+    ident->name = this->consume().symbol;
 
     return ident;
 }
 
-std::unique_ptr<IntLiteralNode> Parser::parse_int_literal() {
-    auto int_lit = std::make_unique<IntLiteralNode>();
+IntLiteralNode* Parser::parse_int_literal() {
+    auto* int_lit = this->m_arena->make<IntLiteralNode>();
+    int_lit->offset = this->peek().offset;
+
+    this->_expect(TokenType::l_int, ParseErrorType::ExpectedExpression);
+    auto text = this->consume().value;
+
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), int_lit->value);
+    if (ec != std::errc() || end != text.data() + text.size())
+        throw std::runtime_error("Parse error: " + to_string(ParseErrorType::InvalidIntLiteral) +
+                                 " '" + std::string(text) + "'");
 
     return int_lit;
-}
\ No newline at end of file
+}
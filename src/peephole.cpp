@@ -0,0 +1,244 @@
+#include "peephole.hpp"
+
+/* r0 always reads 0, so it is never live and never holds anything. */
+static inline uint8_t bit(Reg phys) {
+    return phys == lc2k::ZeroReg ? 0 : static_cast<uint8_t>(1u << phys);
+}
+
+/* nor x x y and nor 0 x y both complement x; the x, or NoReg. */
+static inline Reg complemented(const MInstr& in) {
+    if (in.op != Opcode::nor)
+        return NoReg;
+    if (in.a == in.b || in.b == lc2k::ZeroReg)
+        return in.a;
+    return in.a == lc2k::ZeroReg ? in.b : NoReg;
+}
+
+void Peephole::run(MFunction& fn) {
+    for (bool changed = true; changed; ) {
+        changed  = this->_forward(fn.code);
+        changed |= this->_dead(fn.code);
+    }
+}
+
+void Peephole::run(MProgram& program, ThreadPool* pool) {
+    std::vector<Peephole> workers(slots(pool));
+    parallel_for(pool, program.functions.size(), [&](size_t slot, size_t i) {
+        workers[slot].run(program.functions[i]);
+    });
+
+    for (auto& worker : workers)
+        for (size_t k = 0; k < this->m_hits.size(); k++)
+            this->m_hits[k] += worker.m_hits[k];
+}
+
+bool Peephole::_forward(std::vector<MInstr>& code) {
+    this->_targets(code);
+    this->m_remove.assign(code.size(), false);
+
+    /* Memory word each register is known to hold. */
+    std::array<LabelId, lc2k::NumRegs> holds;
+    holds.fill(NoLabel);
+
+    for (size_t i = 0; i < code.size(); i++) {
+        MInstr& in = code[i];
+
+        if (this->m_target[i])
+            holds.fill(NoLabel);
+
+        switch (in.op) {
+            case Opcode::noop:
+                this->_remove(Pattern::Noop, i);
+                break;
+
+            case Opcode::add:
+                if (in.d != lc2k::ZeroReg &&
+                    ((in.a == in.d && in.b == lc2k::ZeroReg) || (in.b == in.d && in.a == lc2k::ZeroReg))) {
+                    this->_remove(Pattern::SelfMove, i);
+                    break;
+                }
+                holds[in.d] = NoLabel;
+                break;
+
+            case Opcode::nor:
+                /* nor x x y ... nor y y z (or nor 0 x, nor 0 y): z is x again, if x is still there. */
+                if (Reg x = complemented(in); x != NoReg && x != in.d && in.d != lc2k::ZeroReg) {
+                    Reg y = in.d;
+
+                    for (size_t j = i + 1; j < code.size() && j <= i + DoubleNorWindow; j++) {
+                        MInstr& next = code[j];
+                        if (this->m_remove[j])
+                            continue;
+                        if (this->m_target[j] || next.op == Opcode::beq ||
+                            next.op == Opcode::jalr || next.op == Opcode::halt)
+                            break;
+
+                        if (complemented(next) == y) {
+                            next = MInstr {.op = Opcode::add, .a = x, .b = lc2k::ZeroReg, .d = next.d, .loc = next.loc};
+                            this->m_hits[static_cast<size_t>(Pattern::DoubleNor)]++;
+                            break;
+                        }
+
+                        Reg srcs[2];
+                        int n = uses(next, srcs);
+                        Reg dest = def(next);
+                        if ((n > 0 && srcs[0] == y) || (n > 1 && srcs[1] == y) || dest == x || dest == y)
+                            break;
+                    }
+                }
+                holds[in.d] = NoLabel;
+                break;
+
+            case Opcode::eq:
+                holds[in.d] = NoLabel;
+                break;
+
+            case Opcode::lw:
+                if (in.a != lc2k::ZeroReg || in.label == NoLabel) {
+                    holds[in.b] = NoLabel;
+                    break;
+                }
+                if (holds[in.b] == in.label) {
+                    this->_remove(Pattern::StoreLoad, i);
+                    break;
+                }
+                holds[in.b] = in.label;
+                break;
+
+            case Opcode::sw:
+                if (in.a != lc2k::ZeroReg || in.label == NoLabel) {
+                    holds.fill(NoLabel);
+                    break;
+                }
+                for (auto& label : holds)
+                    if (label == in.label)
+                        label = NoLabel;
+                if (in.b != lc2k::ZeroReg)
+                    holds[in.b] = in.label;
+                break;
+
+            case Opcode::beq:
+                if (in.label == NoLabel && in.offset == 0) {
+                    this->_remove(Pattern::JumpNext, i);
+                    break;
+                }
+                holds.fill(NoLabel);
+                break;
+
+            case Opcode::jalr:
+            case Opcode::halt:
+                /* A callee may store anywhere. */
+                holds.fill(NoLabel);
+                break;
+        }
+    }
+
+    return this->_compact(code);
+}
+
+/* Backward liveness of r1..r7; a definition nothing reads is dropped. */
+bool Peephole::_dead(std::vector<MInstr>& code) {
+    this->m_remove.assign(code.size(), false);
+
+    uint8_t live = 0;
+    for (size_t i = code.size(); i-- > 0; ) {
+        const MInstr& in = code[i];
+
+        switch (in.op) {
+            case Opcode::add:
+            case Opcode::nor:
+            case Opcode::eq:
+            case Opcode::lw: {
+                Reg dest = def(in);
+                if (dest != lc2k::ZeroReg && !(live & bit(dest))) {
+                    this->_remove(Pattern::DeadDef, i);
+                    break;
+                }
+
+                Reg srcs[2];
+                int n = uses(in, srcs);
+                live &= ~bit(dest);
+                for (int k = 0; k < n; k++)
+                    live |= bit(srcs[k]);
+                break;
+            }
+
+            case Opcode::sw:
+                live |= bit(in.a) | bit(in.b);
+                break;
+
+            case Opcode::beq:
+                live = 0xff;        // whatever the target needs
+                break;
+
+            case Opcode::jalr:
+                /* A return hands back nothing but control; a call clobbers only r7 itself. */
+                if (is_return(in))
+                    live = bit(lc2k::LinkReg);
+                else
+                    live = (live & ~bit(in.b)) | bit(in.a);
+                break;
+
+            case Opcode::halt:
+                live = bit(lc2k::ExitReg);
+                break;
+
+            case Opcode::noop:
+                break;
+        }
+    }
+
+    return this->_compact(code);
+}
+
+void Peephole::_targets(const std::vector<MInstr>& code) {
+    this->m_target.assign(code.size() + 1, false);
+
+    for (size_t i = 0; i < code.size(); i++) {
+        const MInstr& in = code[i];
+        if (in.op != Opcode::beq || in.label != NoLabel)
+            continue;
+
+        int64_t target = static_cast<int64_t>(i) + 1 + in.offset;
+        if (target >= 0 && target <= static_cast<int64_t>(code.size()))
+            this->m_target[target] = true;
+    }
+}
+
+void Peephole::_remove(Pattern pattern, size_t i) {
+    this->m_remove[i] = true;
+    this->m_hits[static_cast<size_t>(pattern)]++;
+}
+
+bool Peephole::_compact(std::vector<MInstr>& code) {
+    this->m_index.resize(code.size() + 1);
+
+    uint32_t kept = 0;
+    for (size_t i = 0; i < code.size(); i++) {
+        this->m_index[i] = kept;
+        kept += !this->m_remove[i];
+    }
+    this->m_index[code.size()] = kept;
+
+    if (kept == code.size())
+        return false;
+
+    /* A removed target becomes the next instruction kept. */
+    for (size_t i = 0; i < code.size(); i++) {
+        MInstr& in = code[i];
+        if (this->m_remove[i] || in.op != Opcode::beq || in.label != NoLabel)
+            continue;
+
+        int64_t target = static_cast<int64_t>(i) + 1 + in.offset;
+        if (target >= 0 && target <= static_cast<int64_t>(code.size()))
+            in.offset = static_cast<int32_t>(this->m_index[target]) - static_cast<int32_t>(this->m_index[i]) - 1;
+    }
+
+    size_t out = 0;
+    for (size_t i = 0; i < code.size(); i++) {
+        if (!this->m_remove[i])
+            code[out++] = code[i];
+    }
+    code.resize(out);
+    return true;
+}
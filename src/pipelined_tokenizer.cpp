@@ -0,0 +1,36 @@
+#include "pipelined_tokenizer.hpp"
+
+PipelinedTokenizer::PipelinedTokenizer(std::string_view src)
+    : m_producer(&PipelinedTokenizer::_produce, this, src) {}
+
+PipelinedTokenizer::~PipelinedTokenizer() {
+    /* Parser may have stopped early (e.g. parse error): release the producer. */
+    this->m_ring.cancel();
+    this->m_producer.join();
+}
+
+size_t PipelinedTokenizer::read_tokens(Token* out, size_t max) {
+    size_t count = this->m_ring.pop(out, max);
+
+    /* close() happens-after m_error is written, and pop() observed it. */
+    if (count == 0 && this->m_error)
+        std::rethrow_exception(this->m_error);
+
+    return count;
+}
+
+void PipelinedTokenizer::_produce(std::string_view src) {
+    try {
+        Tokenizer tokenizer(src);
+        std::array<Token, PipelinedTokenizer::Batch> batch;
+
+        while (size_t count = tokenizer.read_tokens(batch.data(), batch.size())) {
+            if (!this->m_ring.push(batch.data(), count))
+                break;      // consumer cancelled
+        }
+    } catch (...) {
+        this->m_error = std::current_exception();
+    }
+
+    this->m_ring.close();
+}
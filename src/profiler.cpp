@@ -0,0 +1,130 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+
+void Profiler::report(std::ostream& os, Format format) const {
+    if (format == Format::Collapsed)
+        this->_collapsed(os);
+    else
+        this->_flat(os);
+}
+
+void Profiler::_flat(std::ostream& os) const {
+    const auto& fns      = this->m_map.functions;
+    const auto& hits     = this->m_sim.hits();
+    const auto& contexts = this->m_sim.contexts();
+    uint64_t    total    = this->m_sim.instructions();
+
+    auto share = [&](uint64_t n) { return total > 0 ? 100.0 * n / total : 0.0; };
+
+    /* Self: the function's own addresses. Total: every context with it on the call path, once. */
+    std::vector<uint64_t> self(fns.size(), 0), inclusive(fns.size(), 0);
+    for (size_t f = 0; f < fns.size(); f++)
+        for (uint32_t a = fns[f].begin; a < fns[f].end; a++)
+            self[f] += hits[a];
+
+    std::vector<uint32_t> seen(fns.size(), UINT32_MAX);
+    for (uint32_t c = 0; c < contexts.size(); c++) {
+        for (uint32_t at = c; ; at = contexts[at].parent) {
+            int f = this->_function(contexts[at].entry);
+            if (f >= 0 && seen[f] != c) {
+                seen[f] = c;
+                inclusive[f] += contexts[c].self;
+            }
+            if (at == 0)
+                break;
+        }
+    }
+
+    /* Per line; [0] collects code with no line. */
+    std::vector<uint64_t> line_hits(this->m_lines.lines() + 1, 0);
+    for (size_t r = 0; r < this->m_map.runs.size(); r++) {
+        auto&    run  = this->m_map.runs[r];
+        uint32_t end  = r + 1 < this->m_map.runs.size() ? this->m_map.runs[r + 1].address : this->m_map.code_end;
+        uint32_t line = run.loc == NoLoc ? 0 : this->m_lines.position(run.loc).line;
+        for (uint32_t a = run.address; a < end; a++)
+            line_hits[line] += hits[a];
+    }
+
+    char line[160];
+    os << total << " instructions\n\n";
+
+    std::snprintf(line, sizeof(line), "  %14s %6s %14s %6s  %s\n", "self", "%", "total", "%", "function");
+    os << line;
+
+    std::vector<uint32_t> order(fns.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t x, uint32_t y) { return self[x] > self[y]; });
+
+    for (uint32_t f : order) {
+        if (inclusive[f] == 0)
+            continue;
+        std::snprintf(line, sizeof(line), "  %14llu %5.1f%% %14llu %5.1f%%  ",
+                      static_cast<unsigned long long>(self[f]), share(self[f]),
+                      static_cast<unsigned long long>(inclusive[f]), share(inclusive[f]));
+        os << line << this->_name(static_cast<int>(f)) << '\n';
+    }
+
+    std::snprintf(line, sizeof(line), "\n  %14s %6s  %s\n", "count", "%", "line");
+    os << line;
+
+    order.resize(line_hits.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t x, uint32_t y) { return line_hits[x] > line_hits[y]; });
+
+    for (uint32_t l : order) {
+        if (line_hits[l] == 0)
+            break;
+
+        std::snprintf(line, sizeof(line), "  %14llu %5.1f%%  ",
+                      static_cast<unsigned long long>(line_hits[l]), share(line_hits[l]));
+        os << line;
+
+        if (l == 0) {
+            os << "(no line)\n";
+            continue;
+        }
+
+        auto text = this->m_lines.line_text(l);
+        text.remove_prefix(std::min(text.find_first_not_of(" \t"), text.size()));
+        os << this->m_file << ':' << l << '\t' << text << '\n';
+    }
+}
+
+void Profiler::_collapsed(std::ostream& os) const {
+    const auto& contexts = this->m_sim.contexts();
+
+    std::vector<uint32_t> path;
+    for (uint32_t c = 0; c < contexts.size(); c++) {
+        if (contexts[c].self == 0)
+            continue;
+
+        path.clear();
+        for (uint32_t at = c; ; at = contexts[at].parent) {
+            path.push_back(at);
+            if (at == 0)
+                break;
+        }
+
+        for (size_t i = path.size(); i-- > 0; ) {
+            os << this->_name(this->_function(contexts[path[i]].entry));
+            os.put(i > 0 ? ';' : ' ');
+        }
+        os << contexts[c].self << '\n';
+    }
+}
+
+int Profiler::_function(uint32_t address) const {
+    auto* fn = this->m_map.function(address);
+    return fn ? static_cast<int>(fn - this->m_map.functions.data()) : -1;
+}
+
+std::string Profiler::_name(int function) const {
+    if (function < 0)
+        return "?";
+
+    SymbolId name = this->m_map.functions[function].name;
+    return name == NoSymbol ? "top-level" : std::string(spelling(name));
+}
@@ -0,0 +1,346 @@
+#include "regalloc.hpp"
+
+#include <cassert>
+
+/* Allocation order; r7 last, since a function must save it first. */
+static constexpr Reg Allocatable[] = {1, 2, 3, 4, 5, 6, lc2k::LinkReg};
+
+static inline uint8_t bit(Reg phys) { return static_cast<uint8_t>(1u << phys); }
+
+void LinearScan::run() {
+    size_t  count = this->m_program.functions.size();
+    LabelId first = static_cast<LabelId>(this->m_program.labels.size());
+
+    this->m_allocators.clear();
+    for (size_t i = 0; i < ::slots(this->m_pool); i++)
+        this->m_allocators.emplace_back(this->m_program, first);
+
+    std::vector<std::vector<Label>> labels(count);
+    parallel_for(this->m_pool, count, [&](size_t slot, size_t i) {
+        labels[i] = this->m_allocators[slot].allocate(this->m_program.functions[i]);
+    });
+
+    /* Program labels in function order, as allocating one function after another would number them. */
+    std::vector<LabelId> map;
+    for (size_t i = 0; i < count; i++) {
+        if (labels[i].empty())
+            continue;
+
+        map.clear();
+        for (const Label& label : labels[i])
+            map.push_back(this->m_program.new_label(label.kind, label.name));
+        this->m_program.functions[i].relabel(first, map);
+    }
+}
+
+size_t LinearScan::_sum(size_t Allocator::*counter) const {
+    size_t total = 0;
+    for (auto& allocator : this->m_allocators)
+        total += allocator.*counter;
+    return total;
+}
+
+std::vector<Label> LinearScan::Allocator::allocate(MFunction& fn) {
+    this->m_fn        = &fn;
+    this->m_code      = std::move(fn.code);
+    this->m_link_used = false;
+    this->m_holder.fill(NoReg);
+    this->m_free_slots.clear();
+    this->m_labels.clear();
+
+    this->_analyse();
+
+    this->m_out.clear();
+    this->m_out.reserve(this->m_code.size() + this->m_code.size() / 8);
+
+    for (uint32_t pos = 0; pos < this->m_code.size(); pos++)
+        this->_instruction(pos);
+
+    fn.code = std::move(this->m_out);
+    this->_save_link();
+
+    return std::move(this->m_labels);
+}
+
+/* Definition and use positions of every virtual register. */
+void LinearScan::Allocator::_analyse() {
+    size_t count = this->m_fn->next_vreg;
+
+    this->m_def      .assign(count, NoUse);
+    this->m_use_begin.assign(count + 1, 0);
+    this->m_next     .assign(count, 0);
+    this->m_where    .assign(count, NoReg);
+    this->m_slot     .assign(count, NoLabel);
+    this->m_stored   .assign(count, 0);
+    this->m_hint     .assign(count, 0);
+    this->m_avoid    .assign(count, 0);
+
+    /* Count uses, then lay them out in position order (CSR). */
+    for (uint32_t pos = 0; pos < this->m_code.size(); pos++) {
+        const MInstr& in = this->m_code[pos];
+
+        Reg srcs[2];
+        int n = uses(in, srcs);
+        for (int k = 0; k < n; k++) {
+            if (is_virtual(srcs[k]) && (k == 0 || srcs[k] != srcs[0]))
+                this->m_use_begin[srcs[k] + 1]++;
+        }
+
+        Reg dest = def(in);
+        if (is_virtual(dest))
+            this->m_def[dest] = pos;
+
+        /* `jalr 7 7` would link over its own target. */
+        if (is_call(in) && is_virtual(in.a))
+            this->m_avoid[in.a] |= bit(lc2k::LinkReg);
+
+        /* A copy into a fixed register (exit's r1) wants its source there already. */
+        if (in.op == Opcode::add && in.b == lc2k::ZeroReg && is_virtual(in.a) &&
+            !is_virtual(in.d) && in.d != lc2k::ZeroReg)
+            this->m_hint[in.a] = static_cast<uint8_t>(in.d);
+    }
+
+    for (size_t v = 1; v <= count; v++)
+        this->m_use_begin[v] += this->m_use_begin[v - 1];
+
+    this->m_use_pos.resize(this->m_use_begin[count]);
+
+    std::vector<uint32_t> fill(this->m_use_begin.begin(), this->m_use_begin.end() - 1);
+    for (uint32_t pos = 0; pos < this->m_code.size(); pos++) {
+        Reg srcs[2];
+        int n = uses(this->m_code[pos], srcs);
+        for (int k = 0; k < n; k++) {
+            if (is_virtual(srcs[k]) && (k == 0 || srcs[k] != srcs[0]))
+                this->m_use_pos[fill[srcs[k]]++] = pos;
+        }
+    }
+
+    for (size_t v = 0; v < count; v++)
+        this->m_next[v] = this->m_use_begin[v];
+}
+
+void LinearScan::Allocator::_instruction(uint32_t pos) {
+    MInstr in = this->m_code[pos];
+    this->m_loc = in.loc;
+
+    /* Sources: reload split intervals, keeping the other source's register. */
+    Reg* fields[2] = {&in.a, &in.b};
+    Reg  srcs[2];
+    int  n = uses(in, srcs);
+
+    uint8_t locked = 0;
+    for (int k = 0; k < n; k++) {
+        Reg v = srcs[k];
+        if (!is_virtual(v)) {
+            locked |= bit(v);
+            continue;
+        }
+
+        if (this->m_where[v] == NoReg) {
+            Reg phys = this->_pick(pos, locked | this->m_avoid[v], 0);
+            this->_reload(v, phys);
+        }
+
+        locked |= bit(this->m_where[v]);
+        *fields[k] = this->m_where[v];
+    }
+
+    /* Sources used for the last time free their registers (dest may reuse one) and slots. */
+    for (int k = 0; k < n; k++) {
+        Reg v = srcs[k];
+        if (!is_virtual(v))
+            continue;
+
+        while (this->m_next[v] < this->m_use_begin[v + 1] && this->m_use_pos[this->m_next[v]] <= pos)
+            this->m_next[v]++;
+
+        if (this->_next_use(v) != NoUse)
+            continue;
+
+        if (this->m_where[v] != NoReg) {
+            this->m_holder[this->m_where[v]] = NoReg;
+            this->m_where[v] = NoReg;
+        }
+        if (this->m_slot[v] != NoLabel) {
+            this->m_free_slots.push_back(this->m_slot[v]);
+            this->m_slot[v] = NoLabel;
+        }
+    }
+
+    /* Everything is caller-saved: split whatever lives past a call. */
+    if (is_call(in)) {
+        for (Reg phys : Allocatable) {
+            if (this->m_holder[phys] != NoReg)
+                this->_evict(phys);
+        }
+    }
+
+    Reg* dest_field = def_field(in);
+    Reg  dest       = dest_field ? *dest_field : NoReg;
+
+    if (is_virtual(dest)) {
+        Reg phys = this->_pick(pos, this->m_avoid[dest], this->m_hint[dest]);
+        *dest_field = phys;
+
+        if (this->_next_use(dest) != NoUse) {
+            this->m_where [dest] = phys;
+            this->m_holder[phys] = dest;
+        }
+    } else if (dest != NoReg && dest != lc2k::ZeroReg) {
+        /* Fixed register (exit's r1, a call's r7): move out whatever lives there. */
+        if (this->m_holder[dest] != NoReg)
+            this->_evict(dest);
+    }
+
+    /* Copies whose source landed in the right register already vanish. */
+    if (in.op == Opcode::add && in.b == lc2k::ZeroReg && in.a == in.d)
+        return;
+
+    this->_emit(in);
+}
+
+/* sw 0 7 R on entry and lw 0 7 R before returning, if anything clobbers r7. */
+void LinearScan::Allocator::_save_link() {
+    MFunction& fn = *this->m_fn;
+    if (fn.entry == NoLabel)
+        return;
+
+    bool clobbered = this->m_link_used;
+    for (auto& in : fn.code)
+        clobbered |= is_call(in);
+
+    if (!clobbered)
+        return;
+
+    LabelId save = this->_new_label(LabelKind::Save);
+    fn.data.push_back(DataWord {.label = save});
+
+    std::vector<MInstr> code;
+    code.reserve(fn.code.size() + 4);
+    /* Like the return it usually ends with, the save belongs to the declaration. */
+    code.push_back(MInstr {.op = Opcode::sw, .a = lc2k::ZeroReg, .b = lc2k::LinkReg, .label = save,
+                           .loc = fn.code.empty() ? NoLoc : fn.code.back().loc});
+
+    for (auto& in : fn.code) {
+        if (is_return(in))
+            code.push_back(MInstr {.op = Opcode::lw, .a = lc2k::ZeroReg, .b = lc2k::LinkReg, .label = save,
+                                   .loc = in.loc});
+        code.push_back(in);
+    }
+
+    fn.code = std::move(code);
+}
+
+uint32_t LinearScan::Allocator::_next_use(Reg v) const {
+    return this->m_next[v] < this->m_use_begin[v + 1] ? this->m_use_pos[this->m_next[v]] : NoUse;
+}
+
+/* Values defined by loading a read-only word (or nor 0 0) are recomputed, not stored. */
+bool LinearScan::Allocator::_remat(Reg v) const {
+    const MInstr& in = this->m_code[this->m_def[v]];
+
+    if (in.op == Opcode::lw)
+        return in.a == lc2k::ZeroReg && in.label != NoLabel && this->m_program.is_read_only(in.label);
+
+    return in.op == Opcode::nor && in.a == lc2k::ZeroReg && in.b == lc2k::ZeroReg;
+}
+
+/*
+ * A free register for an interval starting at pos: hint if free,
+ * else the first free one, else one taken from the interval used
+ * furthest in the future (values that need no store count double).
+ */
+Reg LinearScan::Allocator::_pick(uint32_t pos, uint8_t excluded, uint8_t hint) {
+    if (hint && this->m_holder[hint] == NoReg && !(excluded & bit(hint)))
+        return hint;
+
+    for (Reg phys : Allocatable) {
+        if (this->m_holder[phys] == NoReg && !(excluded & bit(phys))) {
+            this->m_link_used |= phys == lc2k::LinkReg;
+            return phys;
+        }
+    }
+
+    Reg      victim = NoReg;
+    uint64_t best   = 0;
+
+    for (Reg phys : Allocatable) {
+        if (excluded & bit(phys))
+            continue;
+
+        Reg      v     = this->m_holder[phys];
+        uint64_t score = this->_next_use(v) - pos;
+        if (this->m_stored[v] || this->_remat(v))
+            score *= 2;
+
+        if (victim == NoReg || score > best) {
+            victim = phys;
+            best   = score;
+        }
+    }
+
+    assert(victim != NoReg && "No register to spill");
+    this->_evict(victim);
+    return victim;
+}
+
+/* Frees phys, storing its value first if it is needed later and cannot be recomputed. */
+void LinearScan::Allocator::_evict(Reg phys) {
+    Reg v = this->m_holder[phys];
+
+    if (!this->m_stored[v] && !this->_remat(v) && this->_next_use(v) != NoUse) {
+        if (this->m_slot[v] == NoLabel)
+            this->m_slot[v] = this->_slot();
+
+        this->_emit(MInstr {.op = Opcode::sw, .a = lc2k::ZeroReg, .b = phys, .label = this->m_slot[v]});
+        this->m_stored[v] = 1;
+        this->spills++;
+    }
+
+    this->m_where [v]    = NoReg;
+    this->m_holder[phys] = NoReg;
+}
+
+/* A free spill slot: the one freed last, or a new word. */
+LabelId LinearScan::Allocator::_slot() {
+    if (!this->m_free_slots.empty()) {
+        LabelId slot = this->m_free_slots.back();
+        this->m_free_slots.pop_back();
+        this->shared++;
+        return slot;
+    }
+
+    LabelId slot = this->_new_label(LabelKind::Spill);
+    this->m_fn->data.push_back(DataWord {.label = slot});
+    this->slots++;
+    return slot;
+}
+
+/* A provisional label named after the function; run() makes it a program label. */
+LabelId LinearScan::Allocator::_new_label(LabelKind kind) {
+    this->m_labels.push_back(Label {kind, 0, this->m_fn->name});
+    return this->m_first + static_cast<LabelId>(this->m_labels.size() - 1);
+}
+
+void LinearScan::Allocator::_reload(Reg v, Reg phys) {
+    MInstr load;
+
+    if (this->_remat(v)) {
+        load = this->m_code[this->m_def[v]];
+        *def_field(load) = phys;
+    } else {
+        assert(this->m_stored[v] && "Reloading a value that was never stored");
+        load = MInstr {.op = Opcode::lw, .a = lc2k::ZeroReg, .b = phys, .label = this->m_slot[v]};
+    }
+
+    this->_emit(load);
+    this->reloads++;
+
+    this->m_where [v]    = phys;
+    this->m_holder[phys] = v;
+}
+
+void LinearScan::Allocator::_emit(const MInstr& instr) {
+    this->m_out.push_back(instr);
+    this->m_out.back().loc = this->m_loc;
+}
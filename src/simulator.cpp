@@ -0,0 +1,215 @@
+#include "simulator.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+
+#if defined(__GNUC__)
+#define LCC_SIM_THREADED 1
+#endif
+
+Simulator::Simulator(const std::vector<int32_t>& image)
+    : m_memory(lc2k::MemorySize, 0) {
+    std::copy(image.begin(), image.begin() + std::min<size_t>(image.size(), lc2k::MemorySize),
+              this->m_memory.begin());
+
+    this->m_decoded.resize(lc2k::MemorySize);
+    for (uint32_t i = 0; i < lc2k::MemorySize; i++)
+        this->m_decoded[i] = _decode(this->m_memory[i]);
+}
+
+Simulator::Decoded Simulator::_decode(int32_t word) {
+    uint32_t w = static_cast<uint32_t>(word);
+    return Decoded {
+        .op     = static_cast<uint8_t>(w >> 22 & 7),
+        .a      = static_cast<uint8_t>(w >> 19 & 7),
+        .b      = static_cast<uint8_t>(w >> 16 & 7),
+        .d      = static_cast<uint8_t>(w & 7),
+        .offset = static_cast<int16_t>(w & 0xffff),
+    };
+}
+
+RunStatus Simulator::run(uint64_t max_steps) {
+    return this->_run<false>(max_steps);
+}
+
+RunStatus Simulator::profile(uint64_t max_steps) {
+    if (this->m_hits.empty()) {
+        this->m_hits.assign(lc2k::MemorySize, 0);
+        this->m_contexts.push_back(Context {.parent = 0, .entry = 0, .self = 0});
+    }
+    return this->_run<true>(max_steps);
+}
+
+template <bool Profiled>
+RunStatus Simulator::_run(uint64_t max_steps) {
+    int32_t*  mem   = this->m_memory.data();
+    Decoded*  code  = this->m_decoded.data();
+    int32_t*  reg   = this->m_regs.data();
+    uint64_t* count = this->m_counts.data();
+    uint64_t* hits  = this->m_hits.data();
+
+    uint32_t       pc   = this->m_pc;
+    uint64_t       left = max_steps;
+    uint64_t       mark = max_steps;    // left when the current context was last charged
+    const Decoded* in;
+    uint32_t       addr;
+    RunStatus      status = RunStatus::Halted;
+
+    /* Checks, then counts, the instruction at pc; in points at it. */
+#define LCC_SIM_FETCH()                                                        \
+    if (left == 0)               { status = RunStatus::StepLimit; goto stop; } \
+    if (pc >= lc2k::MemorySize)  { status = RunStatus::BadPc;     goto stop; } \
+    left--;                                                                    \
+    in = &code[pc];                                                            \
+    count[in->op]++;                                                           \
+    if constexpr (Profiled)                                                    \
+        hits[pc]++
+
+#ifdef LCC_SIM_THREADED
+    static const void* const Handlers[] = {
+        &&op_add, &&op_nor, &&op_lw, &&op_sw, &&op_beq, &&op_jalr, &&op_halt, &&op_noop,
+    };
+
+#define LCC_SIM_HANDLER(name) op_##name:
+#define LCC_SIM_NEXT()        do { LCC_SIM_FETCH(); goto *Handlers[in->op]; } while (0)
+
+    LCC_SIM_NEXT();
+#else
+#define LCC_SIM_HANDLER(name) case static_cast<uint8_t>(Opcode::name):
+#define LCC_SIM_NEXT()        goto dispatch
+
+dispatch:
+    LCC_SIM_FETCH();
+    switch (in->op) {
+#endif
+
+    LCC_SIM_HANDLER(add)
+        reg[in->d] = static_cast<int32_t>(static_cast<uint32_t>(reg[in->a]) + static_cast<uint32_t>(reg[in->b]));
+        pc++;
+        LCC_SIM_NEXT();
+
+    LCC_SIM_HANDLER(nor)
+        reg[in->d] = ~(reg[in->a] | reg[in->b]);
+        pc++;
+        LCC_SIM_NEXT();
+
+    LCC_SIM_HANDLER(lw)
+        addr = static_cast<uint32_t>(reg[in->a]) + static_cast<uint32_t>(in->offset);
+        if (addr >= lc2k::MemorySize) {
+            status = RunStatus::BadAddress;
+            goto stop;
+        }
+        reg[in->b] = mem[addr];
+        pc++;
+        LCC_SIM_NEXT();
+
+    LCC_SIM_HANDLER(sw)
+        addr = static_cast<uint32_t>(reg[in->a]) + static_cast<uint32_t>(in->offset);
+        if (addr >= lc2k::MemorySize) {
+            status = RunStatus::BadAddress;
+            goto stop;
+        }
+        mem[addr]  = reg[in->b];
+        code[addr] = _decode(reg[in->b]);
+        pc++;
+        LCC_SIM_NEXT();
+
+    LCC_SIM_HANDLER(beq)
+        pc += reg[in->a] == reg[in->b] ? 1 + static_cast<uint32_t>(in->offset) : 1;
+        LCC_SIM_NEXT();
+
+    LCC_SIM_HANDLER(jalr)
+        /* regB is written first: with regA == regB this jumps to pc + 1. */
+        reg[in->b] = static_cast<int32_t>(pc + 1);
+        pc = static_cast<uint32_t>(reg[in->a]);
+
+        if constexpr (Profiled) {
+            if (in->b == lc2k::LinkReg || (in->a == lc2k::LinkReg && in->b == lc2k::TrashReg)) {
+                this->m_contexts[this->m_context].self += mark - left;
+                mark = left;
+
+                if (in->b == lc2k::LinkReg)
+                    this->_call(pc);
+                else
+                    this->_return();
+            }
+        }
+        LCC_SIM_NEXT();
+
+    LCC_SIM_HANDLER(halt)
+        pc++;
+        status = RunStatus::Halted;
+        goto stop;
+
+    LCC_SIM_HANDLER(noop)
+        pc++;
+        LCC_SIM_NEXT();
+
+#ifndef LCC_SIM_THREADED
+    }
+#endif
+
+#undef LCC_SIM_FETCH
+#undef LCC_SIM_HANDLER
+#undef LCC_SIM_NEXT
+
+stop:
+    if constexpr (Profiled)
+        this->m_contexts[this->m_context].self += mark - left;
+
+    this->m_pc     = pc;
+    this->m_status = status;
+    return status;
+}
+
+void Simulator::_call(uint32_t entry) {
+    if (this->m_depth == MaxDepth) {
+        this->m_overflow++;
+        return;
+    }
+
+    uint64_t key = static_cast<uint64_t>(this->m_context) << 32 | entry;
+    auto [it, inserted] = this->m_children.try_emplace(key, static_cast<uint32_t>(this->m_contexts.size()));
+    if (inserted)
+        this->m_contexts.push_back(Context {.parent = this->m_context, .entry = entry, .self = 0});
+
+    this->m_context = it->second;
+    this->m_depth++;
+}
+
+void Simulator::_return() {
+    if (this->m_overflow > 0) {
+        this->m_overflow--;
+        return;
+    }
+
+    /* A return with nothing to return from stays in the root. */
+    if (this->m_depth > 0) {
+        this->m_context = this->m_contexts[this->m_context].parent;
+        this->m_depth--;
+    }
+}
+
+uint64_t Simulator::instructions() const {
+    return std::accumulate(this->m_counts.begin(), this->m_counts.end(), uint64_t {0});
+}
+
+void Simulator::report(std::ostream& os) const {
+    uint64_t total = this->instructions();
+    char     line[128];
+
+    os << to_string(this->m_status) << " at pc " << this->m_pc
+       << " after " << total << " instructions\n";
+
+    for (size_t op = 0; op < this->m_counts.size(); op++) {
+        double share = total > 0 ? 100.0 * this->m_counts[op] / total : 0.0;
+        std::snprintf(line, sizeof(line), "  %-6s %14llu %6.1f%%\n", to_string(static_cast<Opcode>(op)),
+                      static_cast<unsigned long long>(this->m_counts[op]), share);
+        os << line;
+    }
+
+    for (int r = 0; r < lc2k::NumRegs; r++)
+        os << (r == 0 ? "  " : " ") << 'r' << r << '=' << this->m_regs[r];
+    os.put('\n');
+}
@@ -0,0 +1,89 @@
+#include "source_buffer.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+std::optional<SourceBuffer> SourceBuffer::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return std::nullopt;
+
+    struct stat st {};
+    if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* map = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+
+        if (map != MAP_FAILED) {
+            /* Tokenizer walks the file front to back. */
+            ::madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+            SourceBuffer buf;
+            buf.m_map  = map;
+            buf.m_data = static_cast<const char*>(map);
+            buf.m_size = static_cast<size_t>(st.st_size);
+            return buf;
+        }
+    } else {
+        ::close(fd);
+    }
+
+    /* Not mappable: read it the slow way. */
+    std::ifstream in_file(path, std::ios::binary);
+    if (!in_file.is_open())
+        return std::nullopt;
+
+    return SourceBuffer::from_string(std::string(
+        (std::istreambuf_iterator<char>(in_file)),
+        std::istreambuf_iterator<char>()
+    ));
+}
+
+SourceBuffer SourceBuffer::from_string(std::string src) {
+    SourceBuffer buf;
+    buf.m_owned = std::move(src);
+    buf.m_data  = buf.m_owned.data();
+    buf.m_size  = buf.m_owned.size();
+    return buf;
+}
+
+SourceBuffer::SourceBuffer(SourceBuffer&& other) noexcept {
+    *this = std::move(other);
+}
+
+SourceBuffer& SourceBuffer::operator=(SourceBuffer&& other) noexcept {
+    if (this == &other)
+        return *this;
+
+    this->_release();
+
+    this->m_map   = std::exchange(other.m_map, nullptr);
+    this->m_size  = std::exchange(other.m_size, 0);
+    this->m_owned = std::move(other.m_owned);
+
+    /* Owned data may live in the SSO buffer, so re-point after the move. */
+    this->m_data = this->m_map ? std::exchange(other.m_data, nullptr)
+                               : this->m_owned.data();
+    other.m_data = nullptr;
+
+    return *this;
+}
+
+SourceBuffer::~SourceBuffer() {
+    this->_release();
+}
+
+void SourceBuffer::_release() {
+    if (this->m_map)
+        ::munmap(this->m_map, this->m_size);
+
+    this->m_map  = nullptr;
+    this->m_data = nullptr;
+    this->m_size = 0;
+    this->m_owned.clear();
+}
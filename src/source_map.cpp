@@ -0,0 +1,53 @@
+#include "source_map.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+LineMap::LineMap(std::string_view src)
+    : m_src(src) {
+    this->m_starts.push_back(0);
+
+    const char* begin = src.data();
+    const char* end   = begin + src.size();
+    for (const char* p = begin; (p = static_cast<const char*>(std::memchr(p, '\n', end - p))); p++)
+        this->m_starts.push_back(static_cast<uint32_t>(p + 1 - begin));
+}
+
+LineMap::Position LineMap::position(SourceLoc loc) const {
+    auto it = std::upper_bound(this->m_starts.begin(), this->m_starts.end(), loc);
+    uint32_t line = static_cast<uint32_t>(it - this->m_starts.begin());
+    return Position {line, loc - this->m_starts[line - 1] + 1};
+}
+
+std::string_view LineMap::line_text(uint32_t line) const {
+    if (line == 0 || line > this->m_starts.size())
+        return {};
+
+    size_t begin = this->m_starts[line - 1];
+    size_t end   = line < this->m_starts.size() ? this->m_starts[line] - 1 : this->m_src.size();
+    if (end > begin && this->m_src[end - 1] == '\r')
+        end--;
+    return this->m_src.substr(begin, end - begin);
+}
+
+void SourceMap::add(uint32_t address, SourceLoc loc) {
+    if (this->runs.empty() || this->runs.back().loc != loc)
+        this->runs.push_back(Run {address, loc});
+}
+
+SourceLoc SourceMap::loc(uint32_t address) const {
+    if (address >= this->code_end)
+        return NoLoc;
+
+    auto it = std::upper_bound(this->runs.begin(), this->runs.end(), address,
+                               [](uint32_t a, const Run& run) { return a < run.address; });
+    return it == this->runs.begin() ? NoLoc : std::prev(it)->loc;
+}
+
+const SourceMap::Function* SourceMap::function(uint32_t address) const {
+    auto it = std::upper_bound(this->functions.begin(), this->functions.end(), address,
+                               [](uint32_t a, const Function& fn) { return a < fn.begin; });
+    if (it == this->functions.begin() || address >= std::prev(it)->end)
+        return nullptr;
+    return &*std::prev(it);
+}
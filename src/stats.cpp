@@ -0,0 +1,175 @@
+#include "stats.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+/*
+ * Allocator hooks. Counting is off until Stats::enable(); the
+ * counters are global (not per thread) so the pipelined lexer's
+ * allocations are seen too.
+ */
+static std::atomic<bool>     CountAllocs {false};
+static std::atomic<uint64_t> AllocCount  {0};
+static std::atomic<uint64_t> AllocBytes  {0};
+
+static inline void note_alloc(size_t size) {
+    if (CountAllocs.load(std::memory_order_relaxed)) {
+        AllocCount.fetch_add(1,    std::memory_order_relaxed);
+        AllocBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+}
+
+static void* checked_alloc(size_t size) {
+    note_alloc(size);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+static void* checked_alloc(size_t size, std::align_val_t align) {
+    note_alloc(size);
+    size_t a = static_cast<size_t>(align);
+    /* aligned_alloc needs a non-zero multiple of the alignment. */
+    size_t rounded = size ? (size + a - 1) / a * a : a;
+    if (void* p = std::aligned_alloc(a, rounded))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new  (size_t size)                         { return checked_alloc(size); }
+void* operator new[](size_t size)                         { return checked_alloc(size); }
+void* operator new  (size_t size, std::align_val_t align) { return checked_alloc(size, align); }
+void* operator new[](size_t size, std::align_val_t align) { return checked_alloc(size, align); }
+
+void operator delete  (void* p) noexcept                          { std::free(p); }
+void operator delete[](void* p) noexcept                          { std::free(p); }
+void operator delete  (void* p, size_t) noexcept                  { std::free(p); }
+void operator delete[](void* p, size_t) noexcept                  { std::free(p); }
+void operator delete  (void* p, std::align_val_t) noexcept        { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept        { std::free(p); }
+void operator delete  (void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+
+/* Stats */
+Stats& Stats::global() {
+    static Stats stats;
+    return stats;
+}
+
+void Stats::enable() {
+    this->m_enabled = true;
+    this->m_owner   = std::this_thread::get_id();
+    CountAllocs.store(true, std::memory_order_relaxed);
+}
+
+void Stats::reset() {
+    CountAllocs.store(false, std::memory_order_relaxed);
+    this->m_enabled = false;
+    this->m_paused  = false;
+    this->m_phases.clear();
+    this->m_stack.clear();
+}
+
+void Stats::enter(std::string_view phase) {
+    this->_charge();
+    this->m_stack.push_back(this->_phase(phase));
+}
+
+void Stats::leave() {
+    this->_charge();
+    this->m_stack.pop_back();
+}
+
+void Stats::count(std::string_view phase, std::string_view counter, uint64_t value) {
+    auto& counters = this->m_phases[this->_phase(phase)].counters;
+
+    for (auto& c : counters) {
+        if (c.name == counter) {
+            c.value += value;
+            return;
+        }
+    }
+    counters.push_back(Counter {counter, value});
+}
+
+size_t Stats::_phase(std::string_view name) {
+    for (size_t i = 0; i < this->m_phases.size(); i++)
+        if (this->m_phases[i].name == name)
+            return i;
+
+    this->m_phases.push_back(Phase {.name = name});
+    return this->m_phases.size() - 1;
+}
+
+/* Charges everything since the last mark to the innermost active phase. */
+void Stats::_charge() {
+    auto     now    = Clock::now();
+    uint64_t allocs = AllocCount.load(std::memory_order_relaxed);
+    uint64_t bytes  = AllocBytes.load(std::memory_order_relaxed);
+
+    if (!this->m_stack.empty()) {
+        Phase& top = this->m_phases[this->m_stack.back()];
+        top.seconds += std::chrono::duration<double>(now - this->m_mark).count();
+        top.allocs  += allocs - this->m_mark_allocs;
+        top.bytes   += bytes  - this->m_mark_bytes;
+    }
+
+    this->m_mark        = now;
+    this->m_mark_allocs = allocs;
+    this->m_mark_bytes  = bytes;
+}
+
+/* Reporting */
+void Stats::report(std::ostream& os, Format format) const {
+    Phase total {.name = "total"};
+    for (auto& phase : this->m_phases) {
+        total.seconds += phase.seconds;
+        total.allocs  += phase.allocs;
+        total.bytes   += phase.bytes;
+    }
+
+    if (format == Format::Json) {
+        auto phase_json = [&](const Phase& p) {
+            os << "{\"name\":\"" << p.name << "\",\"seconds\":" << p.seconds
+               << ",\"allocs\":" << p.allocs << ",\"bytes\":" << p.bytes << ",\"counters\":{";
+            for (size_t i = 0; i < p.counters.size(); i++) {
+                if (i > 0) os.put(',');
+                os << '"' << p.counters[i].name << "\":" << p.counters[i].value;
+            }
+            os << "}}";
+        };
+
+        os << "{\"phases\":[";
+        for (size_t i = 0; i < this->m_phases.size(); i++) {
+            if (i > 0) os.put(',');
+            phase_json(this->m_phases[i]);
+        }
+        os << "],\"total\":";
+        phase_json(total);
+        os << "}\n";
+        return;
+    }
+
+    char line[128];
+    auto row = [&](const Phase& p) {
+        double share = total.seconds > 0 ? 100.0 * p.seconds / total.seconds : 0.0;
+        std::snprintf(line, sizeof(line), "  %-12.*s %10.3f %6.1f%% %10llu %12llu",
+                      static_cast<int>(p.name.size()), p.name.data(),
+                      p.seconds * 1e3, share,
+                      static_cast<unsigned long long>(p.allocs),
+                      static_cast<unsigned long long>(p.bytes));
+        os << line;
+        for (auto& c : p.counters)
+            os << "  " << c.name << '=' << c.value;
+        os.put('\n');
+    };
+
+    std::snprintf(line, sizeof(line), "  %-12s %10s %7s %10s %12s  %s\n",
+                  "phase", "time (ms)", "", "allocs", "bytes", "counters");
+    os << line;
+    for (auto& phase : this->m_phases)
+        row(phase);
+    row(total);
+}
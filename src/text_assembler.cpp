@@ -0,0 +1,163 @@
+#include "text_assembler.hpp"
+
+#include <charconv>
+#include <stdexcept>
+
+static inline bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+/* The next whitespace-separated word of rest, removed from it. */
+static std::string_view next_word(std::string_view& rest) {
+    size_t begin = 0;
+    while (begin < rest.size() && is_blank(rest[begin]))
+        begin++;
+
+    size_t end = begin;
+    while (end < rest.size() && !is_blank(rest[end]))
+        end++;
+
+    std::string_view word = rest.substr(begin, end - begin);
+    rest.remove_prefix(end);
+    return word;
+}
+
+/* Fields each opcode takes; -1 for none known. */
+static int field_count(std::string_view op) {
+    if (op == "add" || op == "nor" || op == "lw" || op == "sw" || op == "beq")
+        return 3;
+    if (op == "jalr")
+        return 2;
+    if (op == ".fill")
+        return 1;
+    if (op == "halt" || op == "noop")
+        return 0;
+    return -1;
+}
+
+std::vector<int32_t> TextAssembler::assemble() {
+    this->_parse();
+
+    if (this->m_lines.size() > lc2k::MemorySize)
+        _error(this->m_lines.back().number, "program does not fit in LC2K memory");
+
+    std::vector<int32_t> image;
+    image.reserve(this->m_lines.size());
+    for (auto& line : this->m_lines)
+        image.push_back(this->_encode(line, static_cast<uint32_t>(image.size())));
+    return image;
+}
+
+/* Pass 1: one Line per non-empty line, and the address of every label. */
+void TextAssembler::_parse() {
+    this->m_lines.clear();
+    this->m_labels.clear();
+
+    std::string_view text   = this->m_text;
+    uint32_t         number = 0;
+
+    while (!text.empty()) {
+        size_t           newline = text.find('\n');
+        std::string_view rest    = text.substr(0, newline);
+        text.remove_prefix(newline == std::string_view::npos ? text.size() : newline + 1);
+        number++;
+
+        std::string_view label;
+        if (!rest.empty() && !is_blank(rest[0]))
+            label = next_word(rest);
+
+        Line line {.number = number, .op = next_word(rest), .fields = {}, .count = 0};
+        if (line.op.empty()) {
+            if (!label.empty())
+                _error(number, "label " + std::string(label) + " without an instruction");
+            continue;                   // blank line
+        }
+
+        line.count = field_count(line.op);
+        if (line.count < 0)
+            _error(number, "unknown opcode " + std::string(line.op));
+
+        for (int k = 0; k < line.count; k++) {
+            line.fields[k] = next_word(rest);
+            if (line.fields[k].empty())
+                _error(number, std::string(line.op) + " needs " + std::to_string(line.count) + " fields");
+        }
+        /* Anything after the fields is a comment. */
+
+        if (!label.empty() && !this->m_labels.emplace(label, static_cast<uint32_t>(this->m_lines.size())).second)
+            _error(number, "duplicate label " + std::string(label));
+
+        this->m_lines.push_back(line);
+    }
+}
+
+/* Pass 2. */
+int32_t TextAssembler::_encode(const Line& line, uint32_t pc) const {
+    if (line.op == ".fill")
+        return static_cast<int32_t>(this->_value(line, 0));
+
+    int opcode = 0;
+    while (opcode < 8 && line.op != to_string(static_cast<Opcode>(opcode)))
+        opcode++;
+
+    uint32_t word = static_cast<uint32_t>(opcode) << 22;
+
+    switch (static_cast<Opcode>(opcode)) {
+        case Opcode::add:
+        case Opcode::nor:
+            word |= this->_reg(line, 0) << 19 | this->_reg(line, 1) << 16 | this->_reg(line, 2);
+            break;
+
+        case Opcode::lw:
+        case Opcode::sw:
+        case Opcode::beq: {
+            bool    named;
+            int64_t offset = this->_value(line, 2, &named);
+
+            /* Branches to a label are relative; numeric offsets are taken as written. */
+            if (named && static_cast<Opcode>(opcode) == Opcode::beq)
+                offset -= static_cast<int64_t>(pc) + 1;
+
+            if (offset < lc2k::MinOffset || offset > lc2k::MaxOffset)
+                _error(line.number, "offset " + std::to_string(offset) + " does not fit in 16 bits");
+            word |= this->_reg(line, 0) << 19 | this->_reg(line, 1) << 16 | (static_cast<uint32_t>(offset) & 0xffff);
+            break;
+        }
+
+        case Opcode::jalr:
+            word |= this->_reg(line, 0) << 19 | this->_reg(line, 1) << 16;
+            break;
+
+        default:
+            break;                      // halt, noop
+    }
+
+    return static_cast<int32_t>(word);
+}
+
+uint32_t TextAssembler::_reg(const Line& line, int field) const {
+    auto&    text = line.fields[field];
+    uint32_t reg  = 0;
+    auto [end, err] = std::from_chars(text.data(), text.data() + text.size(), reg);
+    if (err != std::errc() || end != text.data() + text.size() || reg >= lc2k::NumRegs)
+        _error(line.number, "bad register " + std::string(text));
+    return reg;
+}
+
+int64_t TextAssembler::_value(const Line& line, int field, bool* named) const {
+    auto&   text  = line.fields[field];
+    int64_t value = 0;
+    auto [end, err] = std::from_chars(text.data(), text.data() + text.size(), value);
+    bool number = err == std::errc() && end == text.data() + text.size();
+    if (named)
+        *named = !number;
+    if (number)
+        return value;
+
+    auto it = this->m_labels.find(text);
+    if (it == this->m_labels.end())
+        _error(line.number, "undefined label " + std::string(text));
+    return it->second;
+}
+
+void TextAssembler::_error(uint32_t line, const std::string& msg) {
+    throw std::runtime_error("Assembler error: line " + std::to_string(line) + ": " + msg);
+}
@@ -0,0 +1,176 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+struct ThreadPool::Batch {
+    const std::function<void(size_t)>& job;
+    std::atomic<size_t>                 remaining;
+
+    std::mutex         error_mutex;
+    std::exception_ptr error;
+};
+
+/* The pool and deque of the running worker; outside threads have no pool. */
+static thread_local const ThreadPool* CurrentPool  = nullptr;
+static thread_local size_t            CurrentQueue = 0;
+
+ThreadPool::ThreadPool(size_t threads) {
+    threads = std::max<size_t>(threads, 1);
+
+    for (size_t i = 0; i < threads; i++)
+        this->m_queues.push_back(std::make_unique<Queue>());
+
+    for (size_t i = 1; i < threads; i++)
+        this->m_workers.emplace_back(&ThreadPool::_worker, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(this->m_mutex);
+        this->m_stop = true;
+    }
+    this->m_wake.notify_all();
+
+    for (auto& worker : this->m_workers)
+        worker.join();
+}
+
+size_t ThreadPool::hardware_threads() {
+    return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+void ThreadPool::run(size_t count, const std::function<void(size_t)>& job) {
+    if (this->m_workers.empty() || count == 1) {
+        for (size_t i = 0; i < count; i++)
+            job(i);
+        return;
+    }
+    if (count == 0)
+        return;
+
+    Batch  batch {job, count};
+    size_t self = this->_self();
+
+    /* Counted first, so m_queued never reads less than what the deques hold. */
+    this->m_queued.fetch_add(count, std::memory_order_release);
+    {
+        Queue&          queue = *this->m_queues[self];
+        std::lock_guard lock(queue.mutex);
+        for (size_t i = 0; i < count; i++)
+            queue.tasks.push_back(Task {&batch, i});
+    }
+
+    {
+        std::lock_guard lock(this->m_mutex);
+    }
+    this->m_wake.notify_all();
+
+    while (batch.remaining.load(std::memory_order_acquire) > 0) {
+        Task task;
+        if (this->_take(self, task)) {
+            this->_execute(task);
+            continue;
+        }
+
+        /* Our last tasks are running elsewhere; sleep until they finish or work appears. */
+        std::unique_lock lock(this->m_mutex);
+        this->m_wake.wait(lock, [&] {
+            return batch.remaining.load(std::memory_order_acquire) == 0 ||
+                   this->m_queued.load(std::memory_order_acquire) > 0;
+        });
+    }
+
+    if (batch.error)
+        std::rethrow_exception(batch.error);
+}
+
+size_t ThreadPool::_self() const {
+    return CurrentPool == this ? CurrentQueue : 0;
+}
+
+bool ThreadPool::_take(size_t self, Task& task) {
+    if (this->m_queued.load(std::memory_order_acquire) == 0)
+        return false;
+
+    /* Own deque: newest first, it is likely still in cache. */
+    {
+        Queue&          queue = *this->m_queues[self];
+        std::lock_guard lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+            this->m_queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    /* Steal the oldest task of the next non-empty deque. */
+    size_t n = this->m_queues.size();
+    for (size_t k = 1; k < n; k++) {
+        Queue&          queue = *this->m_queues[(self + k) % n];
+        std::lock_guard lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+            this->m_queued.fetch_sub(1, std::memory_order_relaxed);
+            this->m_steals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::_execute(const Task& task) {
+    Batch& batch = *task.batch;
+
+    try {
+        batch.job(task.index);
+    } catch (...) {
+        std::lock_guard lock(batch.error_mutex);
+        if (!batch.error)
+            batch.error = std::current_exception();
+    }
+
+    /* The caller may be asleep waiting for its last task. */
+    if (batch.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        {
+            std::lock_guard lock(this->m_mutex);
+        }
+        this->m_wake.notify_all();
+    }
+}
+
+void ThreadPool::_worker(size_t self) {
+    CurrentPool  = this;
+    CurrentQueue = self;
+
+    for (;;) {
+        Task task;
+        if (this->_take(self, task)) {
+            this->_execute(task);
+            continue;
+        }
+
+        std::unique_lock lock(this->m_mutex);
+        this->m_wake.wait(lock, [&] {
+            return this->m_stop || this->m_queued.load(std::memory_order_acquire) > 0;
+        });
+        if (this->m_stop && this->m_queued.load(std::memory_order_acquire) == 0)
+            return;
+    }
+}
+
+void parallel_for(ThreadPool* pool, size_t count, const std::function<void(size_t, size_t)>& job) {
+    if (!pool || pool->threads() == 1 || count <= 1) {
+        for (size_t i = 0; i < count; i++)
+            job(0, i);
+        return;
+    }
+
+    std::atomic<size_t> next {0};
+    pool->run(std::min(pool->threads(), count), [&](size_t slot) {
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < count; )
+            job(slot, i);
+    });
+}
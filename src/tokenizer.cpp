@@ -1,29 +1,10 @@
 #include "tokenizer.hpp"
+#include "char_scan.hpp"
 
-/* Define keyword and symbol maps. */
-std::unordered_map<std::string, TokenType> Tokenizer::m_keywords = {
-    {"exit", k_exit},
-    {"fn"  , k_func},
-    {"let" , k_let},
-    {"int" , d_int}
-};
-
-/* Keybreak includes symbols and operators */
-std::unordered_map<std::string, TokenType> Tokenizer::m_keybreak = {
-    {"(", b_lparen},
-    {")", b_rparen},
-    {":", b_colon},
-    {";", b_semi},
-    {"{", b_left_curl},
-    {"}", b_right_curl},
-    {",", b_comma},
-
-    // Operators
-    {"+", o_plus},
-    {"-", o_sub},
-    {"=", o_equal},
-    {"==", o_equal_equal},
-};
+/*
+ * Keywords and symbols are classified by the constexpr tables
+ * in token_table.hpp, generated from the lists in token_type.hpp.
+ */
 
 std::vector<Token> Tokenizer::tokenize() {
     std::vector<Token> result {};
@@ -34,6 +15,19 @@ std::vector<Token> Tokenizer::tokenize() {
     return result;
 }
 
+size_t Tokenizer::read_tokens(Token* out, size_t max) {
+    size_t count = 0;
+
+    while (count < max) {
+        auto token = this->next_token();
+        if (!token)
+            break;
+        out[count++] = *token;
+    }
+
+    return count;
+}
+
 std::optional<Token> Tokenizer::next_token() {
     if (this->m_peeked) {
         auto token = this->m_peeked;
@@ -41,15 +35,7 @@ std::optional<Token> Tokenizer::next_token() {
         return token;
     }
 
-    auto next_str = this->read_token();
-    if (!next_str)
-        return std::nullopt;
-
-    auto token_type = this->classify_token(*next_str);
-    if (!token_type)
-        return std::nullopt;
-    
-    return Token {.value = *next_str, .type = *token_type};
+    return this->read_token();
 }
 
 std::optional<Token> Tokenizer::peek_token() {
@@ -71,7 +57,7 @@ std::optional<char> Tokenizer::consume() {
     return this->m_src[this->m_pos++];
 }
 
-std::optional<std::string> Tokenizer::read_token() {
+std::optional<Token> Tokenizer::read_token() {
     this->_consume_whitespace();
 
     auto curr = this->peek();
@@ -88,89 +74,58 @@ std::optional<std::string> Tokenizer::read_token() {
 }
 
 
-std::optional<TokenType> Tokenizer::classify_token(const std::string& str) {
-    if (str.empty()) return std::nullopt;
-
-    if (this->__is_numeric(str))
-        return TokenType::l_int;
-
-    auto keyword_find = Tokenizer::m_keywords.find(str);
-    if (keyword_find != Tokenizer::m_keywords.end())
-        return keyword_find->second;
-
-    auto keybreak_find = Tokenizer::m_keybreak.find(str);
-    if (keybreak_find != Tokenizer::m_keybreak.end())
-        return keybreak_find->second;
-
-    return TokenType::m_ident;
-}
-
 void Tokenizer::_consume_whitespace() {
-    while(true) {
-        auto ch = peek();
-        if (!ch || !std::isspace((int)(*ch)))
-            return;
-        this->consume();
-    }
+    this->m_pos = this->_scan_to(char_scan::skip_whitespace);
 }
 
-std::string Tokenizer::_parse_number() {
+Token Tokenizer::_parse_number() {
     assert(this->peek() && this->__is_number(*this->peek()));
 
-    std::string num(1, *this->consume());
+    size_t start = this->m_pos;
+    this->m_pos = this->_scan_to(char_scan::skip_digits);
 
-    while (true) {
-        auto ch = this->peek();
-        if (!ch || !this->__is_number(*ch))
-            break;
-        num.push_back(*this->consume());
-    }
-
-    return num;
+    return Token {
+        .value  = this->m_src.substr(start, this->m_pos - start),
+        .type   = TokenType::l_int,
+        .offset = static_cast<uint32_t>(start)
+    };
 }
 
-std::string Tokenizer::_parse_alpha() {
+Token Tokenizer::_parse_alpha() {
     assert(this->peek() && this->__is_alpha(*this->peek()));
 
-    std::string value(1, *this->consume());
+    size_t start = this->m_pos;
+    this->m_pos = this->_scan_to(char_scan::skip_ident);
 
-    while (true) {
-        auto ch = this->peek();
-        if (!ch || !(this->__is_alpha(*ch) || this->__is_number(*ch)))
-            break;
-        value.push_back(*this->consume()); 
-    }
+    auto word = this->m_src.substr(start, this->m_pos - start);
+    auto type = token_table::classify_word(word);
 
-    return value;
+    return Token {
+        .value  = word,
+        .type   = type,
+        .symbol = type == TokenType::m_ident ? Interner::global().intern(word) : NoSymbol,
+        .offset = static_cast<uint32_t>(start)
+    };
 }
 
-std::string Tokenizer::_parse_symbol() {
-    // Try to match longest possible operator/symbol in m_keybreak
-    std::string symbol;
-
-    for (int len = 2; len >= 1; --len) {
-        symbol.clear();
-        for (int i = 0; i < len; ++i) {
-            auto ch = this->peek(i);
-            if (!ch) break;
-            symbol.push_back(*ch);
-        }
-        if (Tokenizer::m_keybreak.find(symbol) != Tokenizer::m_keybreak.end()) {
-            for (int i = 0; i < (int)symbol.size(); ++i) consume();
-            return symbol;
-        }
-    }
+Token Tokenizer::_parse_symbol() {
+    // Longest operator/symbol match, straight off the source.
+    auto match = token_table::match_symbol(this->m_src.substr(this->m_pos));
 
     // If nothing matched, consume one char as unknown
-    return std::string(1, *this->consume());
+    size_t len = match.length ? match.length : 1;
+    auto value  = this->m_src.substr(this->m_pos, len);
+    auto offset = static_cast<uint32_t>(this->m_pos);
+    this->m_pos += len;
+
+    return Token {.value = value, .type = match.type, .offset = offset};
 }
 
-TokenType Tokenizer::_get_keyword(const std::string str) {
-    if (str.empty()) return TokenType::m_unknown;
-    auto res = Tokenizer::m_keywords.find(str);
-    if (res == Tokenizer::m_keywords.end())
-        return TokenType::m_unknown;
-    return res->second;
+size_t Tokenizer::_scan_to(const char* (*skip)(const char*, const char*)) {
+    const char* begin = this->m_src.data();
+    const char* end   = begin + this->m_src.length();
+
+    return skip(begin + this->m_pos, end) - begin;
 }
 
 bool Tokenizer::__is_alpha(char c) {
@@ -182,13 +137,3 @@ bool Tokenizer::__is_alpha(char c) {
 bool Tokenizer::__is_number(char c) {
     return std::isdigit(static_cast<unsigned char>(c));
 }
-
-bool Tokenizer::__is_numeric(const std::string& s) {
-    return !s.empty() && std::all_of(s.begin(), s.end(), 
-                                     [](unsigned char c){ return std::isdigit(c); });
-}
-
-bool Tokenizer::__is_whitespace(const std::string& s) {
-    return !s.empty() && std::all_of(s.begin(), s.end(),
-                                     [](unsigned char c){ return std::isspace(c); });
-}
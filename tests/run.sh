@@ -0,0 +1,174 @@
+#!/bin/sh
+#
+# make test: runs every tests/*.lc at -O0 and -O1 and checks the
+# value it exits with against tests/NAME.exit, checks its machine
+# code against the assembly (--mc=check), checks from --stats that
+# the programs written for a backend pass do exercise it, checks
+# that each tests/errors/NAME.lc is rejected with the message in
+# NAME.err and that bad -j counts are refused, compiles
+# expressions too long or deep to keep in the tree, then links the
+# objects in tests/link/.
+#
+#   tests/run.sh LCC
+
+LCC=$(realpath "${1:-./build/lcc}")
+DIR=$(realpath "$(dirname "$0")")
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+failed=0
+
+fail() {
+    echo "FAIL: $*"
+    failed=$((failed + 1))
+}
+
+# The r1 of a --run report: what the program passed to exit().
+exit_value() {
+    sed -n 's/.* r1=\(-*[0-9]*\) .*/\1/p'
+}
+
+# Expects the command after $1 to fail with an error containing $1.
+expect_error() {
+    message=$1
+    shift
+    if out=$("$@" 2>&1); then
+        fail "$* succeeded, expected \"$message\""
+    elif ! echo "$out" | grep -q "$message"; then
+        fail "$*: $out, expected \"$message\""
+    fi
+}
+
+# The counter $2 of phase $1 in the --stats report for $3 at -O1.
+counter() {
+    "$LCC" --stats -O1 "$3" 2>&1 > /dev/null | sed -n "s/^ *$1 .* $2=\([0-9]*\).*/\1/p"
+}
+
+# Expects the counter $2 of phase $1 to be nonzero for $3.
+expect_counted() {
+    [ "$(counter "$1" "$2" "$3")" -gt 0 ] 2>/dev/null || fail "$3: $1 $2 is '$(counter "$1" "$2" "$3")', expected more than 0"
+}
+
+# PROGRAMS
+
+for source in "$DIR"/*.lc; do
+    expected=$(cat "${source%.lc}.exit")
+
+    for level in -O0 -O1; do
+        got=$("$LCC" --run $level "$source" | exit_value)
+        [ "$got" = "$expected" ] || fail "$source $level exits with '$got', expected $expected"
+
+        "$LCC" --mc=check $level "$source" > /dev/null || fail "$source $level --mc=check"
+    done
+done
+
+# BACKEND PASSES
+
+# More values live at once, and across a call, than there are registers.
+expect_counted regalloc spills  "$DIR/pressure.lc"
+expect_counted regalloc reloads "$DIR/pressure.lc"
+
+# Overwritten stores, copies and code after exit(); the stores a call reads stay.
+expect_counted opt dead_stores "$DIR/dead.lc"
+expect_counted opt forwarded   "$DIR/dead.lc"
+expect_counted opt dead_code   "$DIR/dead.lc"
+
+# Calls inside expressions leave moves to the same register, double negations and dead definitions.
+for pattern in self_move double_nor dead_def; do
+    expect_counted peephole $pattern "$DIR/peephole.lc"
+done
+
+# Right-leaning trees: in Sethi-Ullman order they fit the registers (in source order they do not).
+expect_counted irgen reordered "$DIR/order.lc"
+reloads=$(counter regalloc reloads "$DIR/order.lc")
+[ "$reloads" = 0 ] || fail "$DIR/order.lc: $reloads reloads at -O1, expected 0"
+
+# Two bursts of spills whose values never overlap share slots.
+expect_counted regalloc slots_saved "$DIR/slots.lc"
+
+# ERRORS
+
+for source in "$DIR"/errors/*.lc; do
+    expect_error "$(cat "${source%.lc}.err")" "$LCC" "$source"
+done
+
+for jobs in -j0 -j-3 -j+0 -j999999 -jfour -j2x; do
+    expect_error "[Jj]ob count" "$LCC" $jobs "$DIR/arith.lc"
+done
+
+# LONG AND DEEP EXPRESSIONS
+
+# A statement `let x : int = $3;` with $3 repeated $1 times, joined by $2.
+repeat() {
+    awk -v n="$1" -v sep="$2" -v term="$3" 'BEGIN { printf "let x : int = %s", term; for (i = 1; i < n; i++) printf "%s%s", sep, term; print ";" }'
+}
+
+# `let x : int = (a + (a + ... a));` nested $1 deep.
+nested() {
+    awk -v n="$1" 'BEGIN { printf "let x : int = "; for (i = 0; i < n; i++) printf "(a + "; printf "a"; for (i = 0; i < n; i++) printf ")"; print ";" }'
+}
+
+{ repeat 120000 " + " 1; echo "exit(x);"; } > "$TMP/chain.lc"
+got=$("$LCC" --run "$TMP/chain.lc" | exit_value)
+[ "$got" = 120000 ] || fail "a chain of 120000 literals exits with '$got', expected 120000"
+
+{ echo "let a : int = 3;"; repeat 120000 " + " a; } > "$TMP/long.lc"
+"$LCC" --ir -O0 "$TMP/long.lc" > /dev/null || fail "a chain of 120000 variables at -O0"
+"$LCC" --ir -O1 "$TMP/long.lc" > /dev/null || fail "a chain of 120000 variables at -O1"
+for format in --ast --ast=sexpr --ast=json; do
+    "$LCC" $format "$TMP/long.lc" > /dev/null || fail "$format of a chain of 120000 variables"
+done
+
+{ echo "fn int f(b : int) {"; repeat 120000 " + " b; echo "}"; } > "$TMP/long_fn.lc"
+"$LCC" -c "$TMP/long_fn.lc" > /dev/null || fail "a chain of 120000 variables in a function, with -c"
+
+{ echo "let a : int = 2;"; nested 9999; echo "exit(x);"; } > "$TMP/nested.lc"
+got=$("$LCC" --run "$TMP/nested.lc" | exit_value)
+[ "$got" = 20000 ] || fail "parentheses nested 9999 deep exit with '$got', expected 20000"
+
+{ echo "let a : int = 2;"; nested 10001; } > "$TMP/too_deep.lc"
+expect_error "nested too deeply" "$LCC" "$TMP/too_deep.lc"
+
+{ echo "let a : int = 3;"; repeat 70000 " + " a; echo "exit(x);"; } > "$TMP/too_big.lc"
+expect_error "words of memory" "$LCC"      "$TMP/too_big.lc"
+expect_error "words of memory" "$LCC" --mc "$TMP/too_big.lc"
+
+# More globals than lw and sw can reach, in machine code and in assembly.
+awk 'BEGIN { for (i = 1; i <= 33000; i++) printf "let v%d : int = %d;\n", i, i }' > "$TMP/too_much_data.lc"
+expect_error "lw and sw reach" "$LCC" -O0      "$TMP/too_much_data.lc"
+expect_error "lw and sw reach" "$LCC" -O0 --mc "$TMP/too_much_data.lc"
+
+# LINKER
+
+for unit in main twice done dup arity; do
+    "$LCC" -c "$DIR/link/$unit.lc" > "$TMP/$unit.o" || fail "lcc -c $unit.lc"
+done
+
+cd "$TMP" || exit 1
+
+got=$("$LCC" --link --run main.o twice.o done.o | exit_value)
+[ "$got" = 38 ] || fail "main.o twice.o done.o exits with '$got', expected 38"
+
+"$LCC" --link --mc=check main.o twice.o done.o > /dev/null || fail "main.o twice.o done.o --mc=check"
+
+# twice.o also defines unused(), which nothing calls.
+"$LCC" --link main.o twice.o done.o > linked.as || fail "main.o twice.o done.o"
+grep -q twice linked.as  || fail "twice() missing from the linked program"
+grep -q unused linked.as && fail "unused() kept in the linked program"
+
+expect_error "undefined function done"   "$LCC" --link main.o twice.o
+expect_error "function done is defined"  "$LCC" --link main.o twice.o done.o dup.o
+expect_error "twice takes 2 arguments"   "$LCC" --link arity.o twice.o done.o
+
+# Label kinds are single letters from the prefix table; the last one is R.
+grep -q "^label R " twice.o || fail "twice.o has no label of kind R"
+sed 's/^label R /label Z /'  twice.o > bad_kind.o
+sed 's/^label R /label RR /' twice.o > long_kind.o
+expect_error "bad label kind" "$LCC" --link main.o bad_kind.o done.o
+expect_error "bad label kind" "$LCC" --link main.o long_kind.o done.o
+
+if [ $failed -ne 0 ]; then
+    echo "$failed failed"
+    exit 1
+fi
+echo "all tests passed"
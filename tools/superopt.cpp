@@ -0,0 +1,426 @@
+/*
+ * superopt: finds the shortest LC2K sequences for the operators
+ * in lowering.hpp and writes lowering_table.hpp to stdout.
+ *
+ *   superopt > inc/lowering_table.hpp
+ *
+ * For every operator, register setting and aliasing case it tries
+ * all sequences of 1, 2, ... MaxLength instructions, in a fixed
+ * order, over add, nor, beq (forward) and a load of the constant
+ * 1. Candidates are run on a few inputs as they are built; one
+ * that survives is checked on every pair of edge values and on
+ * many random pairs, with random garbage in the result and spare
+ * registers, then on every pair of Narrow-bit operands on a
+ * machine Narrow bits wide. The first sequence that passes is the
+ * entry.
+ *
+ * Since every sequence of each shorter length was tried and
+ * failed on some input, no shorter sequence over these
+ * instructions computes the operator: that half is exact.
+ *
+ * That the entry is right on every 32-bit input is tested, not
+ * proven. The narrow check is exhaustive but does not carry over:
+ * add and nor give the same low bits at any width, but beq looks
+ * at all of them, and the high bits of a result are functions the
+ * narrow machine never computes. It is there to catch what random
+ * pairs miss, not to prove anything.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "lowering.hpp"
+
+using namespace lowering;
+
+namespace {
+
+constexpr int MaxSlots = 8;
+constexpr int Quick    = 8;            // inputs candidates are run on while being built
+constexpr int Random   = 100000;       // random pairs in the final check
+constexpr int Narrow   = 8;            // bits of the machine every pair is checked on
+
+struct Rng {
+    uint64_t state;
+
+    uint32_t next() {
+        uint64_t z = (this->state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return static_cast<uint32_t>(z ^ (z >> 31));
+    }
+};
+
+struct Input {
+    uint32_t a, b;
+    uint32_t garbage[MaxSlots];
+};
+
+/* One search: which slot each role lives in, and what may be read and written. */
+struct Problem {
+    Op    op;
+    Alias alias;
+    Regs  regs;
+
+    int  slots  = 1;                   // slot 0 is r0
+    int  slot_a = -1, slot_b = -1, slot_d = -1, slot_t = -1;
+    Role names[MaxSlots] {};           // role printed for each slot
+
+    int _slot(Role role) {
+        this->names[this->slots] = role;
+        return this->slots++;
+    }
+
+    Problem(Op op, Alias alias, Regs regs)
+        : op(op), alias(alias), regs(regs) {
+        bool binary = op != Op::Neg;
+
+        if (regs == Regs::Ssa) {
+            this->slot_a = this->_slot(A);
+            if (binary)
+                this->slot_b = this->_slot(B);
+            return;                    // temporaries and D are added as they are written
+        }
+
+        switch (alias) {
+            case Alias::Distinct:
+                this->slot_a = this->_slot(A);
+                if (binary)
+                    this->slot_b = this->_slot(B);
+                this->slot_d = this->_slot(D);
+                break;
+            case Alias::DestA:
+                this->slot_a = this->slot_d = this->_slot(D);
+                if (binary)
+                    this->slot_b = this->_slot(B);
+                break;
+            case Alias::DestB:
+                this->slot_a = this->_slot(A);
+                this->slot_b = this->slot_d = this->_slot(D);
+                break;
+            case Alias::SameAB:
+                this->slot_a = this->slot_b = this->_slot(A);
+                this->slot_d = this->_slot(D);
+                break;
+            case Alias::All:
+                this->slot_a = this->slot_b = this->slot_d = this->_slot(D);
+                break;
+            case Alias::COUNT:
+                break;
+        }
+
+        if (regs == Regs::Spare)
+            this->slot_t = this->_slot(T);
+    }
+
+    bool same_ab() const { return this->alias == Alias::SameAB || this->alias == Alias::All; }
+
+    uint32_t expected(const Input& in) const {
+        switch (this->op) {
+            case Op::Sub:   return in.a - in.b;
+            case Op::Neg:   return 0u - in.a;
+            case Op::Eq:    return in.a == in.b;
+            case Op::COUNT: break;
+        }
+        return 0;
+    }
+};
+
+/* A step over slots; beq.z unused. */
+struct Slots {
+    Opcode op;
+    int    x, y, z;
+    int    offset;
+};
+
+/* mask keeps the low bits a narrow machine has. */
+struct Machine {
+    uint32_t slot[MaxSlots];
+    int      pc;
+    uint32_t mask;
+};
+
+class Search {
+public:
+    explicit Search(const Problem& problem)
+        : m_p(problem) {
+        Rng rng {0x5eed ^ (static_cast<uint64_t>(problem.op) << 16 | static_cast<uint64_t>(problem.alias) << 8 |
+                           static_cast<uint64_t>(problem.regs))};
+
+        const uint32_t fixed[][2] = {
+            {5, 3}, {3, 5}, {9, 9}, {0, 0xffffffffu}, {0x80000000u, 0x7fffffffu}, {12345, 12345},
+        };
+
+        for (int k = 0; k < Quick; k++) {
+            Input in;
+            in.a = k < 6 ? fixed[k][0] : rng.next();
+            in.b = k < 6 ? fixed[k][1] : rng.next();
+            this->_finish(in, rng);
+            this->m_quick.push_back(in);
+        }
+
+        const uint32_t edges[] = {0, 1, 2, 0xffffffffu, 0xfffffffeu, 0x80000000u, 0x7fffffffu, 0x80000001u,
+                                  0x55555555u, 0xaaaaaaaau, 0x0000ffffu, 0xffff0000u};
+        for (uint32_t a : edges) {
+            for (uint32_t b : edges) {
+                Input in {a, b, {}};
+                this->_finish(in, rng);
+                this->m_full.push_back(in);
+            }
+        }
+        for (int k = 0; k < Random; k++) {
+            Input in {rng.next(), 0, {}};
+            in.b = k % 2 ? in.a : rng.next();      // equal operands half the time
+            this->_finish(in, rng);
+            this->m_full.push_back(in);
+        }
+
+        for (uint32_t a = 0; a < 1u << Narrow; a++) {
+            for (uint32_t b = 0; b < 1u << Narrow; b++) {
+                if ((this->m_p.same_ab() || this->m_p.slot_b < 0) && b != a)
+                    continue;      // b is a, or unused
+                Input in {a, b, {}};
+                this->_finish(in, rng);
+                for (auto& g : in.garbage)
+                    g &= NarrowMask;
+                this->m_narrow.push_back(in);
+            }
+        }
+    }
+
+    /* Fills entry with the shortest sequence; length 0 if none is short enough. */
+    Entry run() {
+        Entry entry {.op = this->m_p.op, .alias = this->m_p.alias, .regs = this->m_p.regs, .length = 0, .steps = {}};
+
+        for (int length = 1; length <= MaxLength; length++) {
+            this->m_length = length;
+            this->m_slots  = this->m_p.slots;
+
+            Machine start[Quick];
+            for (int k = 0; k < Quick; k++)
+                start[k] = this->_start(this->m_quick[k]);
+
+            if (this->_extend(0, start)) {
+                entry.length = static_cast<uint8_t>(length);
+                for (int i = 0; i < length; i++)
+                    entry.steps[i] = this->_step(this->m_seq[i]);
+                break;
+            }
+        }
+        return entry;
+    }
+
+    size_t checked() const { return this->m_full.size(); }
+    size_t checked_narrow() const { return this->m_narrow.size(); }
+
+private:
+    static constexpr uint32_t FullMask   = 0xffffffffu;
+    static constexpr uint32_t NarrowMask = (1u << Narrow) - 1;
+
+    const Problem&     m_p;
+    std::vector<Input> m_quick;
+    std::vector<Input> m_full;
+    std::vector<Input> m_narrow;       // every pair, Narrow bits wide
+
+    int   m_length = 0;
+    int   m_slots  = 0;                // in use at the current depth (grows with SSA temporaries)
+    Slots m_seq[MaxLength] {};
+    Role  m_names[MaxSlots] {};
+
+    void _finish(Input& in, Rng& rng) const {
+        if (this->m_p.same_ab())
+            in.b = in.a;
+        for (auto& g : in.garbage)
+            g = rng.next();
+    }
+
+    Machine _start(const Input& in, uint32_t mask = FullMask) const {
+        Machine m {};
+        m.mask = mask;
+        for (int s = 1; s < MaxSlots; s++)
+            m.slot[s] = in.garbage[s];
+        m.slot[0] = 0;
+        m.slot[this->m_p.slot_a] = in.a;
+        if (this->m_p.slot_b >= 0)
+            m.slot[this->m_p.slot_b] = in.b;
+        m.pc = 0;
+        return m;
+    }
+
+    static void _execute(const Slots& s, Machine& m, int depth) {
+        if (m.pc != depth)
+            return;                    // skipped by an earlier beq
+
+        switch (s.op) {
+            case Opcode::add: m.slot[s.z] = (m.slot[s.x] + m.slot[s.y]) & m.mask;    break;
+            case Opcode::nor: m.slot[s.z] = ~(m.slot[s.x] | m.slot[s.y]) & m.mask; break;
+            case Opcode::lw:  m.slot[s.z] = 1;                            break;
+            case Opcode::beq:
+                if (m.slot[s.x] == m.slot[s.y]) {
+                    m.pc += 1 + s.offset;
+                    return;
+                }
+                break;
+            default:
+                break;
+        }
+        m.pc++;
+    }
+
+    int _result_slot() const {
+        return this->m_p.regs == Regs::Ssa ? this->m_p.slots + this->m_length - 1 : this->m_p.slot_d;
+    }
+
+    bool _verify(const std::vector<Input>& inputs, uint32_t mask) const {
+        int d = this->_result_slot();
+        for (auto& in : inputs) {
+            Machine m = this->_start(in, mask);
+            for (int i = 0; i < this->m_length; i++)
+                _execute(this->m_seq[i], m, i);
+            if (m.slot[d] != (this->m_p.expected(in) & mask))
+                return false;
+        }
+        return true;
+    }
+
+    bool _try(int depth, const Machine* before, const Slots& step) {
+        Machine after[Quick];
+        for (int k = 0; k < Quick; k++) {
+            after[k] = before[k];
+            _execute(step, after[k], depth);
+        }
+
+        this->m_seq[depth] = step;
+        return this->_extend(depth + 1, after);
+    }
+
+    bool _extend(int depth, const Machine* state) {
+        if (depth == this->m_length) {
+            int d = this->_result_slot();
+            for (int k = 0; k < Quick; k++)
+                if (state[k].slot[d] != this->m_p.expected(this->m_quick[k]))
+                    return false;
+            return this->_verify(this->m_full, FullMask) && this->_verify(this->m_narrow, NarrowMask);
+        }
+
+        bool ssa      = this->m_p.regs == Regs::Ssa;
+        int  readable = ssa ? this->m_p.slots + depth : this->m_p.slots;
+
+        /* SSA: every step defines the next temporary, the last one D. */
+        int writable[2], nwritable = 0;
+        if (ssa) {
+            writable[nwritable++] = this->m_p.slots + depth;
+        } else {
+            writable[nwritable++] = this->m_p.slot_d;
+            if (this->m_p.slot_t >= 0)
+                writable[nwritable++] = this->m_p.slot_t;
+        }
+
+        for (Opcode op : {Opcode::add, Opcode::nor}) {
+            for (int x = 0; x < readable; x++)
+                for (int y = x; y < readable; y++)
+                    for (int w = 0; w < nwritable; w++)
+                        if (this->_try(depth, state, Slots {op, x, y, writable[w], 0}))
+                            return true;
+        }
+
+        for (int w = 0; w < nwritable; w++)
+            if (this->_try(depth, state, Slots {Opcode::lw, 0, 0, writable[w], 0}))
+                return true;
+
+        /* Branches join two definitions, which SSA cannot express. */
+        if (!ssa) {
+            for (int offset = 1; depth + 1 + offset <= this->m_length; offset++)
+                for (int x = 0; x < readable; x++)
+                    for (int y = x; y < readable; y++)
+                        if (this->_try(depth, state, Slots {Opcode::beq, x, y, 0, offset}))
+                            return true;
+        }
+
+        return false;
+    }
+
+    Role _role(int slot) const {
+        if (slot < this->m_p.slots)
+            return this->m_p.names[slot];
+        if (this->m_p.regs == Regs::Ssa && slot == this->_result_slot())
+            return D;
+        return static_cast<Role>(S0 + (slot - this->m_p.slots));
+    }
+
+    Step _step(const Slots& s) const {
+        switch (s.op) {
+            case Opcode::lw:  return Step {.op = s.op, .z = this->_role(s.z)};
+            case Opcode::beq: return Step {.op = s.op, .x = this->_role(s.x), .y = this->_role(s.y),
+                                           .offset = static_cast<int8_t>(s.offset)};
+            default:          return Step {.op = s.op, .x = this->_role(s.x), .y = this->_role(s.y),
+                                           .z = this->_role(s.z)};
+        }
+    }
+};
+
+#define LCC_LOWERING_ID(name, str) #name,
+
+/* Enumerator spellings, for writing the table as C++. */
+constexpr const char* OpIds   [] = { LCC_LOWERED_OPS     (LCC_LOWERING_ID) };
+constexpr const char* AliasIds[] = { LCC_LOWERING_ALIASES(LCC_LOWERING_ID) };
+constexpr const char* RegsIds [] = { LCC_LOWERING_REGS   (LCC_LOWERING_ID) };
+
+#undef LCC_LOWERING_ID
+
+bool applies(Op op, Alias alias, Regs regs) {
+    if (regs == Regs::Ssa)
+        return alias == Alias::Distinct;        // fresh registers never alias
+    if (op == Op::Neg)
+        return alias == Alias::Distinct || alias == Alias::DestA;
+    return true;
+}
+
+void print(const Entry& e, size_t checked, size_t narrow) {
+    std::printf("    /* %s, %s, %s: ", OpNames[static_cast<int>(e.op)], RegsNames[static_cast<int>(e.regs)],
+                AliasNames[static_cast<int>(e.alias)]);
+    if (e.length == 0)
+        std::printf("nothing within %d instructions */\n", MaxLength);
+    else
+        std::printf("%d, checked on %zu inputs and all %zu at %d bits */\n", e.length, checked, narrow, Narrow);
+
+    std::printf("    {Op::%s, Alias::%s, Regs::%s, %d, {{", OpIds[static_cast<int>(e.op)],
+                AliasIds[static_cast<int>(e.alias)], RegsIds[static_cast<int>(e.regs)], e.length);
+
+    for (int i = 0; i < e.length; i++) {
+        const Step& s = e.steps[i];
+        std::printf("%s\n        {Opcode::%-4s %-5s %-5s %-5s %d}", i ? "," : "", (to_string(s.op) + std::string(",")).c_str(),
+                    (std::string(RoleNames[s.x]) + ",").c_str(), (std::string(RoleNames[s.y]) + ",").c_str(),
+                    (std::string(RoleNames[s.z]) + ",").c_str(), s.offset);
+    }
+    std::printf("%s}}},\n", e.length ? "\n    " : "");
+}
+
+} // namespace
+
+int main() {
+    std::printf("#pragma once\n\n"
+                "/*\n"
+                " * Generated by tools/superopt.cpp (`make lowering`); do not edit.\n"
+                " * See lowering.hpp.\n"
+                " */\n"
+                "#include \"lowering.hpp\"\n\n"
+                "namespace lowering {\n\n"
+                "inline constexpr Entry Table[] = {\n");
+
+    for (int op = 0; op < static_cast<int>(Op::COUNT); op++) {
+        for (int regs = 0; regs < static_cast<int>(Regs::COUNT); regs++) {
+            for (int alias = 0; alias < static_cast<int>(Alias::COUNT); alias++) {
+                if (!applies(static_cast<Op>(op), static_cast<Alias>(alias), static_cast<Regs>(regs)))
+                    continue;
+
+                Problem problem(static_cast<Op>(op), static_cast<Alias>(alias), static_cast<Regs>(regs));
+                Search  search(problem);
+                print(search.run(), search.checked(), search.checked_narrow());
+            }
+        }
+    }
+
+    std::printf("};\n\n} // namespace lowering\n");
+}